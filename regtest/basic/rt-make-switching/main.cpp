@@ -0,0 +1,63 @@
+#include "plumed/tools/SwitchingFunction.h"
+#include "plumed/tools/Stopwatch.h"
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+
+using namespace PLMD;
+
+// Compare the batch version of SwitchingFunction::calculateSqr with the scalar one.
+// Differences are written to output, timings to standard output.
+int main() {
+  std::vector<std::string> definitions;
+  definitions.push_back("RATIONAL R_0=0.3");
+  definitions.push_back("RATIONAL R_0=0.3 NN=8 MM=12");
+  definitions.push_back("RATIONAL R_0=0.3 NN=5 MM=11");
+  definitions.push_back("RATIONAL R_0=0.3 D_0=0.1");
+  definitions.push_back("EXP R_0=0.2 D_0=0.1");
+  definitions.push_back("GAUSSIAN R_0=0.2 D_0=0.1");
+  definitions.push_back("CUBIC D_0=0.1 D_MAX=1.0");
+  definitions.push_back("TANH R_0=0.2 D_0=0.1");
+  definitions.push_back("SMAP R_0=0.3 A=3 B=2");
+  definitions.push_back("COSINUS R_0=0.5 D_0=0.1");
+  definitions.push_back("CUSTOM FUNC=1/(1+x^6) R_0=0.3");
+  definitions.push_back("CUSTOM FUNC=1/(1+x2^3) R_0=0.3");
+
+  const unsigned n=100000;
+  const unsigned nrepeat=20;
+  std::vector<double> distance2(n),value(n),dfunc(n),value_scalar(n),dfunc_scalar(n);
+  for(unsigned i=0; i<n; i++) {
+    double d=1.5*i/n;
+    distance2[i]=d*d;
+  }
+
+  std::ofstream ofs("output");
+  for(const auto & def : definitions) {
+    SwitchingFunction sf;
+    std::string errors;
+    sf.set(def,errors);
+    if(errors.length()>0) {
+      ofs<<def<<" error: "<<errors<<"\n";
+      continue;
+    }
+
+    Stopwatch sw;
+    sw.start("scalar");
+    for(unsigned r=0; r<nrepeat; r++) for(unsigned i=0; i<n; i++) value_scalar[i]=sf.calculateSqr(distance2[i],dfunc_scalar[i]);
+    sw.stop("scalar");
+    sw.start("batch");
+    for(unsigned r=0; r<nrepeat; r++) sf.calculateSqr(n,&distance2[0],&value[0],&dfunc[0]);
+    sw.stop("batch");
+
+    double maxdiff=0.0;
+    for(unsigned i=0; i<n; i++) {
+      maxdiff=std::max(maxdiff,std::fabs(value[i]-value_scalar[i]));
+      maxdiff=std::max(maxdiff,std::fabs(dfunc[i]-dfunc_scalar[i]));
+    }
+    ofs<<def<<" max difference "<<maxdiff<<"\n";
+    std::cout<<def<<"\n"<<sw;
+  }
+  return 0;
+}
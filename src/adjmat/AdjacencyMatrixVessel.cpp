@@ -22,6 +22,7 @@
 #include "AdjacencyMatrixVessel.h"
 #include "AdjacencyMatrixBase.h"
 #include "vesselbase/ActionWithVessel.h"
+#include <algorithm>
 
 namespace PLMD {
 namespace adjmat {
@@ -121,6 +122,32 @@ void AdjacencyMatrixVessel::retrieveAdjacencyLists( std::vector<unsigned>& nneig
   }
 }
 
+void AdjacencyMatrixVessel::retrieveCompressedAdjacencyLists( std::vector<unsigned>& start, std::vector<unsigned>& neighbors ) {
+  plumed_dbg_assert( undirectedGraph() );
+  // Find the edges in the graph and count the neighbors of each node
+  std::vector<std::pair<unsigned,unsigned> > edges; start.assign( getNumberOfRows()+1, 0 );
+  std::vector<double> myvals( getNumberOfComponents() );
+  for(unsigned i=0; i<getNumberOfStoredValues(); ++i) {
+    // Check if atoms are connected
+    retrieveSequentialValue( i, false, myvals );
+    if( myvals[0]<epsilon || myvals[1]<epsilon ) continue ;
+
+    unsigned j, k; getMatrixIndices( function->getPositionInFullTaskList(i), k, j );
+    edges.push_back( std::pair<unsigned,unsigned>( k, j ) ); start[k+1]++; start[j+1]++;
+  }
+  // Offsets of the neighbor lists from the number of neighbors
+  for(unsigned i=1; i<start.size(); ++i) start[i] += start[i-1];
+
+  // And store both directions of every edge
+  neighbors.resize( start.back() ); std::vector<unsigned> nneigh( start.begin(), start.end()-1 );
+  for(unsigned i=0; i<edges.size(); ++i) {
+    neighbors[ nneigh[edges[i].first]++ ] = edges[i].second;
+    neighbors[ nneigh[edges[i].second]++ ] = edges[i].first;
+  }
+  // Sorted lists make it easy to compare graphs from different steps
+  for(unsigned i=0; i+1<start.size(); ++i) std::sort( neighbors.begin()+start[i], neighbors.begin()+start[i+1] );
+}
+
 void AdjacencyMatrixVessel::retrieveEdgeList( unsigned& nedge, std::vector<std::pair<unsigned,unsigned> >& edge_list ) {
   plumed_dbg_assert( undirectedGraph() ); nedge=0;
   std::vector<double> myvals( getNumberOfComponents() );
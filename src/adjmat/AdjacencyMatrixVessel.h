@@ -58,6 +58,8 @@ public:
   void retrieveMatrix( DynamicList<unsigned>& myactive_elements, Matrix<double>& mymatrix );
 /// Get the neighbour list based on the adjacency matrix
   void retrieveAdjacencyLists( std::vector<unsigned>& nneigh, Matrix<unsigned>& adj_list );
+/// Get the neighbour lists in compressed sparse row format (the neighbours of node i are neighbors[start[i]] to neighbors[start[i+1]-1] in ascending order)
+  void retrieveCompressedAdjacencyLists( std::vector<unsigned>& start, std::vector<unsigned>& neighbors );
 /// Retrieve the list of edges in the adjacency matrix/graph
   void retrieveEdgeList( unsigned& nedge, std::vector<std::pair<unsigned,unsigned> >& edge_list );
 ///
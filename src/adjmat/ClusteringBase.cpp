@@ -62,13 +62,21 @@ void ClusteringBase::calculate() {
   performClustering();
   // Order the clusters in the system by size (this returns ascending order )
   std::sort( cluster_sizes.begin(), cluster_sizes.end() );
+  // Sort the atoms by cluster so that the atoms in each cluster can be retrieved quickly
+  if( which_cluster.size()>0 ) {
+    cluster_start.assign( getNumberOfClusters()+1, 0 );
+    for(unsigned i=0; i<which_cluster.size(); ++i) cluster_start[which_cluster[i]+1]++;
+    for(unsigned i=1; i<cluster_start.size(); ++i) cluster_start[i] += cluster_start[i-1];
+    atoms_in_clusters.resize( which_cluster.size() ); std::vector<unsigned> natoms( cluster_start.begin(), cluster_start.end()-1 );
+    for(unsigned i=0; i<which_cluster.size(); ++i) atoms_in_clusters[ natoms[which_cluster[i]]++ ] = i;
+  }
 }
 
 void ClusteringBase::retrieveAtomsInCluster( const unsigned& clust, std::vector<unsigned>& myatoms ) const {
-  unsigned n=0; myatoms.resize( cluster_sizes[cluster_sizes.size() - clust].first );
-  for(unsigned i=0; i<getNumberOfNodes(); ++i) {
-    if( which_cluster[i]==cluster_sizes[cluster_sizes.size() - clust].second ) { myatoms[n]=i; n++; }
-  }
+  unsigned myclust=cluster_sizes[cluster_sizes.size() - clust].second;
+  // Clusters that were not found are empty
+  if( myclust>=getNumberOfClusters() ) { myatoms.resize(0); return; }
+  myatoms.assign( atoms_in_clusters.begin()+cluster_start[myclust], atoms_in_clusters.begin()+cluster_start[myclust+1] );
 }
 
 bool ClusteringBase::areConnected( const unsigned& iatom, const unsigned& jatom ) const {
@@ -36,6 +36,11 @@ protected:
   int number_of_cluster;
 /// Vector that identifies the cluster each atom belongs to
   std::vector<unsigned> which_cluster;
+private:
+/// The atoms in each of the clusters stored one cluster after the other
+  std::vector<unsigned> atoms_in_clusters;
+/// The position of the first atom of each cluster in atoms_in_clusters
+  std::vector<unsigned> cluster_start;
 public:
 /// Create manual
   static void registerKeywords( Keywords& keys );
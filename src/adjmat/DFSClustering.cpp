@@ -22,12 +22,8 @@
 #include "ClusteringBase.h"
 #include "AdjacencyMatrixVessel.h"
 #include "core/ActionRegister.h"
-
-#ifdef __PLUMED_HAS_BOOST_GRAPH
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/connected_components.hpp>
-#include <boost/graph/graph_utility.hpp>
-#endif
+#include "tools/OpenMP.h"
+#include <atomic>
 
 //+PLUMEDOC MATRIXF DFSCLUSTERING
 /*
@@ -36,10 +32,16 @@ Find the connected components of the matrix using the depth first search cluster
 As discussed in the section of the manual on \ref contactmatrix a useful tool for developing complex collective variables is the notion of the
 so called adjacency matrix.  An adjacency matrix is an \f$N \times N\f$ matrix in which the \f$i\f$th, \f$j\f$th element tells you whether
 or not the \f$i\f$th and \f$j\f$th atoms/molecules from a set of \f$N\f$ atoms/molecules are adjacent or not.  As detailed in \cite tribello-clustering
-these matrices provide a representation of a graph and can thus can be analyzed using tools from graph theory.  This particular action performs
-a depth first search clustering to find the connected components of this graph.  You can read more about depth first search here:
+these matrices provide a representation of a graph and can thus can be analyzed using tools from graph theory.  This particular action finds
+the connected components of this graph.  The name of the action refers to the depth first search that was originally used to
+find these components.  The components are now found by storing the graph as a compressed list of edges and by
+merging the nodes that are connected by each edge using a union-find data structure.  The edges are processed in parallel
+using OpenMP threads.  The clusters are numbered exactly as they would be by a depth first search that starts from the first node,
+so the results do not depend on the number of threads.  When only a small fraction of the edges
+changes between two steps only the clusters that have lost edges are rebuilt from scratch.  You can read more about the
+union-find data structure here:
 
-https://en.wikipedia.org/wiki/Depth-first_search
+https://en.wikipedia.org/wiki/Disjoint-set_data_structure
 
 This action is useful if you are looking at a phenomenon such as nucleation where the aim is to detect the sizes of the crystalline nuclei that have formed
 in your simulation cell.
@@ -69,19 +71,22 @@ namespace adjmat {
 
 class DFSClustering : public ClusteringBase {
 private:
-#ifdef __PLUMED_HAS_BOOST_GRAPH
-/// The list of edges in the graph
-  std::vector<std::pair<unsigned,unsigned> > edge_list;
-#else
-/// The number of neighbors each atom has
-  std::vector<unsigned> nneigh;
-/// The adjacency list
-  Matrix<unsigned> adj_list;
-/// The color that tells us whether a node has been visited
-  std::vector<unsigned> color;
-/// The recursive function at the heart of this method
-  int explore( const unsigned& index );
-#endif
+/// Offsets of the neighbor lists of each node
+  std::vector<unsigned> start;
+/// The neighbor lists of all the nodes one after the other
+  std::vector<unsigned> neighbors;
+/// The neighbor lists from the previous step
+  std::vector<unsigned> prev_start, prev_neighbors;
+/// The parent of each node in the union-find forest
+  std::vector<std::atomic<unsigned> > parent;
+/// The root of the cluster each node was in at the end of the last clustering
+  std::vector<unsigned> root;
+/// Should the clusters be rebuilt from scratch
+  bool clustersChanged( std::vector<std::pair<unsigned,unsigned> >& added, std::vector<char>& affected ) const ;
+/// Find the root of the tree that contains a node
+  unsigned findRoot( unsigned index );
+/// Merge the trees that contain two nodes
+  void mergeTrees( unsigned inode, unsigned jnode );
 public:
 /// Create manual
   static void registerKeywords( Keywords& keys );
@@ -95,67 +100,106 @@ PLUMED_REGISTER_ACTION(DFSClustering,"DFSCLUSTERING")
 
 void DFSClustering::registerKeywords( Keywords& keys ) {
   ClusteringBase::registerKeywords( keys );
-  keys.add("compulsory","MAXCONNECT","0","maximum number of connections that can be formed by any given node in the graph. "
-           "By default this is set equal to zero and the number of connections is set equal to the number "
-           "of nodes.  You only really need to set this if you are working with a very large system and "
-           "memory is at a premium");
+  keys.add("compulsory","MAXCONNECT","0","this keyword is no longer used.  The graph is stored as a list of edges so the memory "
+           "required no longer depends on the maximum number of connections that can be formed by a node");
 }
 
 DFSClustering::DFSClustering(const ActionOptions&ao):
   Action(ao),
-  ClusteringBase(ao)
+  ClusteringBase(ao),
+  parent(getNumberOfNodes()),
+  root(getNumberOfNodes())
 {
   unsigned maxconnections; parse("MAXCONNECT",maxconnections);
-#ifdef __PLUMED_HAS_BOOST_GRAPH
-  if( maxconnections>0 ) edge_list.resize( getNumberOfNodes()*maxconnections );
-  else edge_list.resize(0.5*getNumberOfNodes()*(getNumberOfNodes()-1));
-#else
-  nneigh.resize( getNumberOfNodes() ); color.resize(getNumberOfNodes());
-  if( maxconnections>0 ) adj_list.resize(getNumberOfNodes(),maxconnections);
-  else adj_list.resize(getNumberOfNodes(),getNumberOfNodes());
-#endif
 }
 
-void DFSClustering::performClustering() {
-#ifdef __PLUMED_HAS_BOOST_GRAPH
-  // Get the list of edges
-  unsigned nedges=0; getAdjacencyVessel()->retrieveEdgeList( nedges, edge_list );
-
-  // Build the graph using boost
-  boost::adjacency_list<boost::vecS,boost::vecS,boost::undirectedS> sg(&edge_list[0],&edge_list[nedges],getNumberOfNodes());
-
-  // Find the connected components using boost (-1 here for compatibility with non-boost version)
-  number_of_cluster=boost::connected_components(sg,&which_cluster[0]) - 1;
-
-  // And work out the size of each cluster
-  for(unsigned i=0; i<which_cluster.size(); ++i) cluster_sizes[which_cluster[i]].first++;
-#else
-  // Get the adjacency matrix
-  getAdjacencyVessel()->retrieveAdjacencyLists( nneigh, adj_list );
-
-  // Perform clustering
-  number_of_cluster=-1; color.assign(color.size(),0);
-  for(unsigned i=0; i<getNumberOfNodes(); ++i) {
-    if( color[i]==0 ) { number_of_cluster++; color[i]=explore(i); }
+unsigned DFSClustering::findRoot( unsigned index ) {
+  // Path halving: each node on the path is made to point to its grandparent
+  while( true ) {
+    unsigned p=parent[index];
+    if( p==index ) return index;
+    unsigned gp=parent[p];
+    if( gp!=p ) parent[index].compare_exchange_weak( p, gp );
+    index=gp;
   }
-#endif
 }
 
-#ifndef __PLUMED_HAS_BOOST_GRAPH
-int DFSClustering::explore( const unsigned& index ) {
+void DFSClustering::mergeTrees( unsigned inode, unsigned jnode ) {
+  // The tree with the larger root is always attached to the one with the smaller root.  The root of
+  // each cluster is thus its lowest numbered node regardless of the order in which edges are merged
+  while( true ) {
+    inode=findRoot( inode ); jnode=findRoot( jnode );
+    if( inode==jnode ) return;
+    if( inode<jnode ) std::swap( inode, jnode );
+    // This fails if another thread has attached inode to some other tree in the meantime
+    unsigned expected=inode;
+    if( parent[inode].compare_exchange_strong( expected, jnode ) ) return;
+  }
+}
 
-  color[index]=1;
-  for(unsigned i=0; i<nneigh[index]; ++i) {
-    unsigned j=adj_list(index,i);
-    if( color[j]==0 ) color[j]=explore(j);
+bool DFSClustering::clustersChanged( std::vector<std::pair<unsigned,unsigned> >& added, std::vector<char>& affected ) const {
+  if( prev_start.size()!=start.size() ) return true;
+  // Compare the sorted neighbor lists to find edges that have been created or destroyed
+  unsigned nchanged=0, maxchanged=neighbors.size()/20;
+  for(unsigned i=0; i+1<start.size(); ++i) {
+    unsigned k=prev_start[i], l=start[i];
+    while( k<prev_start[i+1] || l<start[i+1] ) {
+      if( l==start[i+1] || ( k<prev_start[i+1] && prev_neighbors[k]<neighbors[l] ) ) {
+        // A destroyed edge may have split the cluster that contained it
+        affected[root[i]]=1; k++; nchanged++;
+      } else if( k==prev_start[i+1] || neighbors[l]<prev_neighbors[k] ) {
+        if( i<neighbors[l] ) added.push_back( std::pair<unsigned,unsigned>( i, neighbors[l] ) );
+        l++; nchanged++;
+      } else { k++; l++; }
+    }
+    // Each edge appears twice both in the lists and in nchanged, so this is 5% of the edges
+    if( nchanged>maxchanged ) return true;
   }
+  return false;
+}
 
-  // Count the size of the cluster
-  cluster_sizes[number_of_cluster].first++;
-  which_cluster[index] = number_of_cluster;
-  return color[index];
+void DFSClustering::performClustering() {
+  // Get the adjacency lists
+  getAdjacencyVessel()->retrieveCompressedAdjacencyLists( start, neighbors );
+
+  unsigned nnodes=getNumberOfNodes(), nt=OpenMP::getNumThreads();
+  std::vector<std::pair<unsigned,unsigned> > added; std::vector<char> affected( nnodes, 0 );
+  if( clustersChanged( added, affected ) ) {
+    // Build all the clusters from scratch
+    #pragma omp parallel for num_threads(nt)
+    for(unsigned i=0; i<nnodes; ++i) parent[i]=i;
+    #pragma omp parallel for num_threads(nt) schedule(dynamic,64)
+    for(unsigned i=0; i<nnodes; ++i) {
+      for(unsigned k=start[i]; k<start[i+1]; ++k) {
+        if( i<neighbors[k] ) mergeTrees( i, neighbors[k] );
+      }
+    }
+  } else {
+    // Clusters that have not lost any edges are still connected.  Nodes in the other clusters start
+    // again on their own and are reconnected using their current edges.
+    #pragma omp parallel for num_threads(nt)
+    for(unsigned i=0; i<nnodes; ++i) parent[i] = affected[root[i]] ? i : root[i];
+    #pragma omp parallel for num_threads(nt) schedule(dynamic,64)
+    for(unsigned i=0; i<nnodes; ++i) {
+      if( !affected[root[i]] ) continue;
+      for(unsigned k=start[i]; k<start[i+1]; ++k) mergeTrees( i, neighbors[k] );
+    }
+    #pragma omp parallel for num_threads(nt)
+    for(unsigned i=0; i<added.size(); ++i) mergeTrees( added[i].first, added[i].second );
+  }
+  #pragma omp parallel for num_threads(nt)
+  for(unsigned i=0; i<nnodes; ++i) root[i]=findRoot(i);
+
+  // Number the clusters in the order of their lowest numbered node and work out the size of each cluster
+  number_of_cluster=-1;
+  for(unsigned i=0; i<nnodes; ++i) {
+    if( root[i]==i ) { number_of_cluster++; which_cluster[i]=number_of_cluster; }
+    else which_cluster[i]=which_cluster[root[i]];
+    cluster_sizes[which_cluster[i]].first++;
+  }
+  // Keep these lists to find out what has changed at the next step
+  std::swap( start, prev_start ); std::swap( neighbors, prev_neighbors );
 }
-#endif
 
 }
 }
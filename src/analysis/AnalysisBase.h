@@ -78,6 +78,8 @@ public:
   virtual std::string getDissimilarityInstruction() const ;
 /// Get the squared dissimilarity between two reference configurations
   virtual double getDissimilarity( const unsigned& i, const unsigned& j );
+/// Get the squared dissimilarities between a reference configuration and all the reference configurations
+  virtual void getDissimilarityRow( const unsigned& i, std::vector<double>& row );
 /// Get the indices of the atoms that have been stored
   virtual const std::vector<AtomNumber>& getAtomIndexes() const ;
 /// Overwrite getArguments so we get arguments from underlying class
@@ -97,6 +99,7 @@ public:
   void apply() {}
 /// This will call the analysis to be performed
   virtual void update();
+  bool isHistoryDependent()const override {return true;}
 /// This calls the analysis to be performed in the final step of the calculation
 /// i.e. when use_all_data is true
   virtual void runFinalJobs();
@@ -154,6 +157,11 @@ double AnalysisBase::getDissimilarity( const unsigned& i, const unsigned& j ) {
   return my_input_data->getDissimilarity( i, j );
 }
 
+inline
+void AnalysisBase::getDissimilarityRow( const unsigned& i, std::vector<double>& row ) {
+  my_input_data->getDissimilarityRow( i, row );
+}
+
 inline
 std::vector<Value*> AnalysisBase::getArgumentList() {
   return my_input_data->getArgumentList();
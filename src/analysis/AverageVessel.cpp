@@ -55,7 +55,7 @@ double AverageVessel::getAverage() const {
   return getDataElement(0);
 }
 
-void AverageVessel::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
+void AverageVessel::calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {
   plumed_error();
 }
 
@@ -38,7 +38,7 @@ public:
 /// Set the size of the data vessel
   void resize();
 /// This does nothing
-  void calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const ;
+  void calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const ;
   std::string description() { return ""; }
 /// Accumulate the average
   void accumulate( const double& weight, const double& val );
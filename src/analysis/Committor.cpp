@@ -72,6 +72,7 @@ public:
   explicit Committor(const ActionOptions&ao);
   void calculate();
   void apply() {}
+  bool isHistoryDependent()const override {return true;}
 };
 
 PLUMED_REGISTER_ACTION(Committor,"COMMITTOR")
@@ -24,11 +24,25 @@
 #include "core/ActionRegister.h"
 #include "reference/MetricRegister.h"
 #include "reference/ReferenceConfiguration.h"
+#include "tools/Communicator.h"
+#include "tools/OpenMP.h"
+#include <memory>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 //+PLUMEDOC ANALYSIS EUCLIDEAN_DISSIMILARITIES
 /*
 Calculate the matrix of dissimilarities between a trajectory of atomic configurations.
 
+The matrix is symmetric so only the elements above the diagonal are stored.  These elements are calculated in square tiles
+that contain TILE_SIZE frames along each side and that are divided between MPI processes and OpenMP threads.  As this matrix
+has \f$N^2/2\f$ elements for \f$N\f$ frames it can become very large.  If you use the SINGLE_PRECISION flag the elements
+are stored as single precision numbers, which halves the memory required.  If you use the DISK_STORE keyword the elements are stored in
+a file that is mapped in memory, so that the operating system keeps in memory only the parts of the matrix that have been used recently.
+This file is removed at the end of the calculation.  If you use the LOWMEM flag the matrix is not stored at all and the elements
+are calculated each time they are required.
+
 \par Examples
 
 */
@@ -41,10 +55,37 @@ class EuclideanDissimilarityMatrix : public AnalysisBase {
 private:
   PDB mypdb;
   std::string mtype;
-  Matrix<double> dissimilarities;
+/// The number of frames in each side of the tiles that are calculated by a single thread
+  unsigned tile_size;
+/// Are the dissimilarities stored in single precision
+  bool single_precision;
+/// The name of the file in which the dissimilarities are stored
+  std::string disk_store;
+/// The number of frames for which dissimilarities are stored
+  unsigned nframes;
+/// The dissimilarities when they are stored in memory
+  std::vector<double> dissimilarities;
+  std::vector<float> fdissimilarities;
+/// The dissimilarities when they are stored in a file
+  void* mapped;
+  size_t mapped_size;
+/// The dissimilarities in double or in single precision
+  double* dstore;
+  float* fstore;
+/// The reference configurations for all the frames
+  std::vector<std::unique_ptr<ReferenceConfiguration> > frames;
+/// Get the position of element i, j (with i<j) in the list of stored dissimilarities
+  size_t getStoreIndex( const unsigned& i, const unsigned& j ) const ;
+/// Get a stored dissimilarity
+  double getStoredValue( const size_t& k ) const ;
+/// Set up the storage for the dissimilarities between n frames
+  void setupStorage( const unsigned& n );
+/// Release the file in which the dissimilarities are stored
+  void releaseDiskStore();
 public:
   static void registerKeywords( Keywords& keys );
   EuclideanDissimilarityMatrix( const ActionOptions& ao );
+  ~EuclideanDissimilarityMatrix();
 /// Do the analysis
   void performAnalysis();
 /// This ensures that classes that use this data know that dissimilarities were set
@@ -53,6 +94,8 @@ public:
   std::string getDissimilarityInstruction() const ;
 /// Get the squared dissimilarity between two reference configurations
   double getDissimilarity( const unsigned& i, const unsigned& j );
+/// Get the squared dissimilarities between a reference configuration and all the reference configurations
+  void getDissimilarityRow( const unsigned& i, std::vector<double>& row );
 /// This is just to deal with ActionWithVessel
   void performTask( const unsigned&, const unsigned&, MultiValue& ) const { plumed_error(); }
 };
@@ -63,12 +106,33 @@ void EuclideanDissimilarityMatrix::registerKeywords( Keywords& keys ) {
   AnalysisBase::registerKeywords( keys ); keys.use("ARG"); keys.reset_style("ARG","optional");
   keys.add("compulsory","METRIC","EUCLIDEAN","the method that you are going to use to measure the distances between points");
   keys.add("atoms","ATOMS","the list of atoms that you are going to use in the measure of distance that you are using");
+  keys.add("compulsory","TILE_SIZE","64","the number of frames along each side of the blocks of the matrix that are calculated by a single thread");
+  keys.addFlag("SINGLE_PRECISION",false,"store the dissimilarities as single precision numbers");
+  keys.add("optional","DISK_STORE","the name of a file in which to store the dissimilarities.  The file is mapped in memory and removed at the end of the calculation");
 }
 
 EuclideanDissimilarityMatrix::EuclideanDissimilarityMatrix( const ActionOptions& ao ):
   Action(ao),
-  AnalysisBase(ao)
+  AnalysisBase(ao),
+  tile_size(64),
+  single_precision(false),
+  nframes(0),
+  mapped(NULL),
+  mapped_size(0),
+  dstore(NULL),
+  fstore(NULL)
 {
+  parse("TILE_SIZE",tile_size); parseFlag("SINGLE_PRECISION",single_precision); parse("DISK_STORE",disk_store);
+  if( tile_size==0 ) error("TILE_SIZE should be greater than zero");
+  if( usingLowMem() && ( single_precision || disk_store.length()>0 ) ) error("dissimilarities are not stored if LOWMEM is used so SINGLE_PRECISION and DISK_STORE cannot be used");
+  if( disk_store.length()>0 && comm.Get_size()>1 ) {
+    std::string num; Tools::convert( comm.Get_rank(), num ); disk_store += "." + num;
+  }
+  if( !usingLowMem() ) {
+    log.printf("  calculating dissimilarities in tiles of %u frames \n", tile_size );
+    if( single_precision ) log.printf("  storing dissimilarities in single precision \n");
+    if( disk_store.length()>0 ) log.printf("  storing dissimilarities in file named %s \n", disk_store.c_str() );
+  }
   parse("METRIC",mtype); std::vector<AtomNumber> atoms;
   if( my_input_data->getNumberOfAtoms()>0 ) {
     parseAtomList("ATOMS",atoms);
@@ -113,10 +177,91 @@ EuclideanDissimilarityMatrix::EuclideanDissimilarityMatrix( const ActionOptions&
   }
 }
 
+EuclideanDissimilarityMatrix::~EuclideanDissimilarityMatrix() {
+  releaseDiskStore();
+}
+
+void EuclideanDissimilarityMatrix::releaseDiskStore() {
+  if( mapped ) { munmap( mapped, mapped_size ); unlink( disk_store.c_str() ); }
+  mapped=NULL; mapped_size=0;
+}
+
+void EuclideanDissimilarityMatrix::setupStorage( const unsigned& n ) {
+  nframes=n; size_t nelements=static_cast<size_t>(n)*(n-1)/2;
+  if( n==0 ) nelements=0;
+  dstore=NULL; fstore=NULL;
+  if( disk_store.length()>0 ) {
+    releaseDiskStore();
+    mapped_size=nelements*( single_precision ? sizeof(float) : sizeof(double) );
+    if( mapped_size==0 ) return;
+    int fd=open( disk_store.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    if( fd<0 ) error("could not create file named " + disk_store );
+    // The file is initially empty and is filled with zeros by ftruncate
+    if( ftruncate( fd, mapped_size )!=0 ) { close(fd); error("could not set the size of file named " + disk_store ); }
+    void* m=mmap( NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close(fd);
+    if( m==MAP_FAILED ) { unlink( disk_store.c_str() ); error("could not map file named " + disk_store + " in memory"); }
+    mapped=m;
+    if( single_precision ) fstore=static_cast<float*>(mapped);
+    else dstore=static_cast<double*>(mapped);
+  } else if( single_precision ) {
+    fdissimilarities.assign( nelements, 0 ); fstore=fdissimilarities.data();
+  } else {
+    dissimilarities.assign( nelements, 0 ); dstore=dissimilarities.data();
+  }
+}
+
+size_t EuclideanDissimilarityMatrix::getStoreIndex( const unsigned& i, const unsigned& j ) const {
+  plumed_dbg_assert( i<j && j<nframes );
+  return static_cast<size_t>(i)*(2*static_cast<size_t>(nframes)-i-1)/2 + (j-i-1);
+}
+
+double EuclideanDissimilarityMatrix::getStoredValue( const size_t& k ) const {
+  if( fstore ) return fstore[k];
+  return dstore[k];
+}
+
 void EuclideanDissimilarityMatrix::performAnalysis() {
-  // Resize dissimilarities matrix and set all elements to zero
-  if( !usingLowMem() ) {
-    dissimilarities.resize( getNumberOfDataPoints(), getNumberOfDataPoints() ); dissimilarities=0;
+  // Create the reference configurations for all the frames
+  unsigned n=getNumberOfDataPoints(); frames.resize( n );
+  for(unsigned i=0; i<n; ++i) {
+    getStoredData( i, true ).transferDataToPDB( mypdb );
+    frames[i]=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
+  }
+  if( usingLowMem() ) return;
+
+  // Set all the elements of the dissimilarity matrix to zero
+  setupStorage( n );
+  // Make the list of tiles in the upper triangle of the matrix
+  unsigned nblocks=( n + tile_size - 1 ) / tile_size;
+  std::vector<std::pair<unsigned,unsigned> > tiles;
+  for(unsigned ib=0; ib<nblocks; ++ib) {
+    for(unsigned jb=ib; jb<nblocks; ++jb) tiles.push_back( std::pair<unsigned,unsigned>( ib, jb ) );
+  }
+  // And calculate the tiles on each process and thread
+  const std::vector<Value*> myargs( getArguments() );
+  unsigned rank=comm.Get_rank(), size=comm.Get_size();
+  unsigned nt=OpenMP::getNumThreads();
+  #pragma omp parallel for num_threads(nt) schedule(dynamic)
+  for(unsigned t=rank; t<tiles.size(); t+=size) {
+    unsigned iend=std::min( n, (tiles[t].first+1)*tile_size ), jend=std::min( n, (tiles[t].second+1)*tile_size );
+    for(unsigned i=tiles[t].first*tile_size; i<iend; ++i) {
+      unsigned jstart=std::max( i+1, tiles[t].second*tile_size );
+      for(unsigned j=jstart; j<jend; ++j) {
+        double dd=distance( getPbc(), myargs, frames[i].get(), frames[j].get(), true );
+        if( fstore ) fstore[getStoreIndex(i,j)]=dd;
+        else dstore[getStoreIndex(i,j)]=dd;
+      }
+    }
+  }
+  // The tiles from all the processes are added together in chunks that MPI can handle
+  if( size>1 ) {
+    const size_t nelements=static_cast<size_t>(n)*(n-1)/2, chunk=1<<24;
+    for(size_t k=0; k<nelements; k+=chunk) {
+      int len=std::min( chunk, nelements-k );
+      if( fstore ) comm.Sum( fstore+k, len );
+      else comm.Sum( dstore+k, len );
+    }
   }
 }
 
@@ -126,20 +271,32 @@ std::string EuclideanDissimilarityMatrix::getDissimilarityInstruction() const {
 
 double EuclideanDissimilarityMatrix::getDissimilarity( const unsigned& iframe, const unsigned& jframe ) {
   plumed_dbg_assert( iframe<getNumberOfDataPoints() && jframe<getNumberOfDataPoints() );
-  if( !usingLowMem() ) {
-    if( dissimilarities(iframe,jframe)>0. ) { return dissimilarities(iframe,jframe); }
+  if( iframe==jframe ) return 0.0;
+  if( usingLowMem() ) return distance( getPbc(), getArguments(), frames[iframe].get(), frames[jframe].get(), true );
+  if( iframe<jframe ) return getStoredValue( getStoreIndex( iframe, jframe ) );
+  return getStoredValue( getStoreIndex( jframe, iframe ) );
+}
+
+void EuclideanDissimilarityMatrix::getDissimilarityRow( const unsigned& iframe, std::vector<double>& row ) {
+  plumed_dbg_assert( iframe<getNumberOfDataPoints() );
+  unsigned n=getNumberOfDataPoints(); row.resize( n );
+  if( usingLowMem() ) {
+    // The elements of the row are divided between processes and threads and then summed
+    const std::vector<Value*> myargs( getArguments() );
+    unsigned rank=comm.Get_rank(), size=comm.Get_size();
+    row.assign( n, 0.0 );
+    #pragma omp parallel for num_threads(OpenMP::getNumThreads())
+    for(unsigned j=rank; j<n; j+=size) row[j] = ( j==iframe ? 0.0 : distance( getPbc(), myargs, frames[iframe].get(), frames[j].get(), true ) );
+    if( size>1 ) comm.Sum( row );
+    return;
   }
-  if( iframe!=jframe ) {
-    double dd;
-    getStoredData( iframe, true ).transferDataToPDB( mypdb );
-    auto myref1=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
-    getStoredData( jframe, true ).transferDataToPDB( mypdb );
-    auto myref2=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
-    if( !usingLowMem() ) dd=dissimilarities(iframe,jframe) = dissimilarities(jframe,iframe) = distance( getPbc(), getArguments(), myref1.get(), myref2.get(), true );
-    else dd=distance( getPbc(), getArguments(), myref1.get(), myref2.get(), true );
-    return dd;
+  // The elements before the diagonal are read from a column of the upper triangle and the others from a row
+  for(unsigned j=0; j<iframe; ++j) row[j]=getStoredValue( getStoreIndex( j, iframe ) );
+  row[iframe]=0.0;
+  if( iframe+1<n ) {
+    size_t k=getStoreIndex( iframe, iframe+1 );
+    for(unsigned j=iframe+1; j<n; ++j) row[j]=getStoredValue( k++ );
   }
-  return 0.0;
 }
 
 }
@@ -20,6 +20,7 @@
    along with plumed.  If not, see <http://www.gnu.org/licenses/>.
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "LandmarkSelectionBase.h"
+#include "tools/OpenMP.h"
 
 namespace PLMD {
 namespace analysis {
@@ -65,18 +66,49 @@ void LandmarkSelectionBase::performAnalysis() {
   }
 }
 
+void LandmarkSelectionBase::farthestPointSampling( std::vector<unsigned>& landmarks ) const {
+  // The distance from each point to the closest landmark selected thus far (N.B. We can use squared distances here for speed)
+  unsigned N=my_input_data->getNumberOfDataPoints();
+  std::vector<double> mindist; my_input_data->getDissimilarityRow( landmarks[0], mindist );
+  std::vector<double> row; unsigned nt=OpenMP::getNumThreads();
+  for(unsigned i=1; i<landmarks.size(); ++i) {
+    // Find point that has the largest minimum distance from the landmarks selected thus far
+    // (the first of these points is chosen if there are several)
+    double maxd=0; landmarks[i]=0;
+    #pragma omp parallel num_threads(nt)
+    {
+      double mymaxd=0; unsigned myland=0;
+      #pragma omp for nowait
+      for(unsigned j=0; j<N; ++j) {
+        if( mindist[j]>mymaxd ) { mymaxd=mindist[j]; myland=j; }
+      }
+      #pragma omp critical
+      if( mymaxd>maxd || ( mymaxd==maxd && mymaxd>0 && myland<landmarks[i] ) ) { maxd=mymaxd; landmarks[i]=myland; }
+    }
+    // And update the distances to the closest landmark
+    my_input_data->getDissimilarityRow( landmarks[i], row );
+    #pragma omp parallel for num_threads(nt)
+    for(unsigned j=0; j<N; ++j) {
+      if( row[j]<mindist[j] ) mindist[j]=row[j];
+    }
+  }
+}
+
 void LandmarkSelectionBase::voronoiAnalysis( const std::vector<unsigned>& myindices, std::vector<double>& lweights, std::vector<unsigned>& assignments ) const {
   plumed_dbg_assert( myindices.size()==lweights.size() && assignments.size()==my_input_data->getNumberOfDataPoints() );
   lweights.assign( lweights.size(), 0 );
   unsigned rank=comm.Get_rank(), size=comm.Get_size();
-  for(unsigned i=rank; i<my_input_data->getNumberOfDataPoints(); i+=size) {
-    assignments[i]=0;
-    double mindist=my_input_data->getDissimilarity( i, myindices[0] );
-    for(unsigned j=1; j<nlandmarks; ++j) {
-      double dist=my_input_data->getDissimilarity( i, myindices[j] );
-      if( dist<mindist ) { mindist=dist; assignments[i]=j; }
+  // The distances from each landmark are retrieved in turn, keeping the closest landmark for each point
+  std::vector<double> mindist( my_input_data->getNumberOfDataPoints() ), row;
+  for(unsigned j=0; j<nlandmarks; ++j) {
+    my_input_data->getDissimilarityRow( myindices[j], row );
+    for(unsigned i=rank; i<my_input_data->getNumberOfDataPoints(); i+=size) {
+      if( j==0 || row[i]<mindist[i] ) { mindist[i]=row[i]; assignments[i]=j; }
     }
-    lweights[ assignments[i] ] += my_input_data->getWeight(i);
+  }
+  for(unsigned i=rank; i<my_input_data->getNumberOfDataPoints(); i+=size) lweights[ assignments[i] ] += my_input_data->getWeight(i);
+  for(unsigned i=0; i<my_input_data->getNumberOfDataPoints(); ++i) {
+    if( (i%size)!=rank ) assignments[i]=0;
   }
   comm.Sum( &lweights[0], lweights.size() );
   comm.Sum( &assignments[0], assignments.size() );
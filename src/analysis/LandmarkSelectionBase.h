@@ -41,6 +41,8 @@ private:
 protected:
 /// Transfer frame i in the underlying action to the object we are going to analyze
   void selectFrame( const unsigned& );
+/// Select landmarks using farthest point sampling starting from the landmark in landmarks[0]
+  void farthestPointSampling( std::vector<unsigned>& landmarks ) const ;
 /// Do a voronoi analysis
   void voronoiAnalysis( const std::vector<unsigned>& myindices, std::vector<double>& lweights, std::vector<unsigned>& assignments ) const ;
 public:
@@ -59,6 +61,8 @@ public:
   virtual void selectLandmarks()=0;
 /// Get the squared dissimilarity between two reference configurations
   double getDissimilarity( const unsigned& i, const unsigned& j );
+/// Get the squared dissimilarities between a landmark and all the other landmarks
+  void getDissimilarityRow( const unsigned& i, std::vector<double>& row );
 /// This does nothing - it just ensures the final class is not abstract
   void performTask( const unsigned&, const unsigned&, MultiValue& ) const { plumed_error(); }
 };
@@ -88,6 +92,12 @@ double LandmarkSelectionBase::getDissimilarity( const unsigned& i, const unsigne
   return AnalysisBase::getDissimilarity( landmark_indices[i], landmark_indices[j] );
 }
 
+inline
+void LandmarkSelectionBase::getDissimilarityRow( const unsigned& i, std::vector<double>& row ) {
+  row.resize( nlandmarks );
+  for(unsigned j=0; j<nlandmarks; ++j) row[j]=getDissimilarity( i, j );
+}
+
 }
 }
 #endif
@@ -71,8 +71,10 @@ PrintDissimilarityMatrix::PrintDissimilarityMatrix( const ActionOptions& ao ):
 void PrintDissimilarityMatrix::performAnalysis() {
   std::string ofmt=" "+fmt;
   OFile ofile; ofile.setBackupString("analysis"); ofile.open(fname);
+  std::vector<double> row;
   for(unsigned i=0; i<getNumberOfDataPoints(); ++i) {
-    for(unsigned j=0; j<getNumberOfDataPoints(); ++j) ofile.printf(ofmt.c_str(), sqrt( my_input_data->getDissimilarity( i,j ) ) );
+    my_input_data->getDissimilarityRow( i, row );
+    for(unsigned j=0; j<getNumberOfDataPoints(); ++j) ofile.printf(ofmt.c_str(), sqrt( row[j] ) );
     ofile.printf("\n");
   }
   ofile.close();
@@ -61,6 +61,7 @@ public:
   bool dissimilaritiesWereSet() const { return true; }
 /// Get the dissimilarity between two data points
   double getDissimilarity( const unsigned&, const unsigned& );
+  void getDissimilarityRow( const unsigned&, std::vector<double>& );
 /// Get the weight from the input file
   double getWeight( const unsigned& idata );
 /// Just tell plumed to stop
@@ -151,6 +152,11 @@ double ReadDissimilarityMatrix::getDissimilarity( const unsigned& iframe, const
   return dissimilarities[iframe][jframe]*dissimilarities[iframe][jframe];
 }
 
+void ReadDissimilarityMatrix::getDissimilarityRow( const unsigned& iframe, std::vector<double>& row ) {
+  row.resize( dissimilarities.size() );
+  for(unsigned j=0; j<dissimilarities.size(); ++j) row[j]=dissimilarities[iframe][j]*dissimilarities[iframe][j];
+}
+
 DataCollectionObject& ReadDissimilarityMatrix::getStoredData( const unsigned& idata, const bool& calcdist ) {
   plumed_massert( !calcdist, "cannot calc dist as this data was read in from input");
   if( my_input_data ) return AnalysisBase::getStoredData( idata, calcdist );
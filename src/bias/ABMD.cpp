@@ -91,6 +91,7 @@ class ABMD : public Bias {
 public:
   explicit ABMD(const ActionOptions&);
   void calculate();
+  bool isHistoryDependent()const override {return true;}
   static void registerKeywords(Keywords& keys);
 };
 
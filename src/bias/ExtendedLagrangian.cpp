@@ -129,6 +129,7 @@ public:
   explicit ExtendedLagrangian(const ActionOptions&);
   void calculate();
   void update();
+  bool isHistoryDependent()const override {return true;}
   static void registerKeywords(Keywords& keys);
 };
 
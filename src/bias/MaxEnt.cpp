@@ -166,6 +166,7 @@ public:
   explicit MaxEnt(const ActionOptions&);
   void calculate();
   void update();
+  bool isHistoryDependent()const override {return true;}
   void update_lambda();
   static void registerKeywords(Keywords& keys);
   void ReadLagrangians(IFile &ifile);
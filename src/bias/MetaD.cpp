@@ -29,6 +29,8 @@
 #include "core/FlexibleBin.h"
 #include "tools/Matrix.h"
 #include "tools/Random.h"
+#include "tools/OpenMP.h"
+#include "tools/BucketIndex.h"
 #include <string>
 #include <cstring>
 #include "tools/File.h"
@@ -85,6 +87,10 @@ the most conservative choice (highest number of bins) for each dimension.
 In case you do not provide any information about bin size (neither GRID_BIN nor GRID_SPACING)
 and if Gaussian width is fixed PLUMED will use 1/5 of the Gaussian width as grid spacing.
 This default choice should be reasonable for most applications.
+With three or more collective variables a dense grid might not fit in memory.
+In this case you can use GRID_BLOCKS: the grid is then divided in blocks that are only
+allocated when a hill is added to them, so that memory scales with the region that has
+actually been explored.
 
 Metadynamics can be restarted either from a HILLS file as well as from a GRID, in this second
 case one can first save a GRID using GRID_WFILE (and GRID_WSTRIDE) and at a later stage read
@@ -393,6 +399,8 @@ private:
   vector<double> sigma0min_;
   vector<double> sigma0max_;
   vector<Gaussian> hills_;
+  std::unique_ptr<BucketIndex> hillsIndex_;
+  vector<unsigned> candidates_;
   OFile hillsOfile_;
   OFile gridfile_;
   std::unique_ptr<Grid> BiasGrid_;
@@ -407,6 +415,7 @@ private:
   struct TemperingSpecs tt_specs_;
   std::string targetfilename_;
   std::unique_ptr<Grid> TargetGrid_;
+  double target_max_;
   double kbt_;
   int stride_;
   bool welltemp_;
@@ -444,9 +453,19 @@ private:
   bool isFirstStep;
   bool calc_rct_;
   double reweight_factor_;
+// running maximum of the bias and partition functions used for c(t),
+// updated at every deposition using only the grid points touched by the hill
+  bool track_grid_;
+  bool grid_stats_valid_;
+// hills are added directly to a dense grid, unless they are split among MPI processes
+  bool dense_grid_;
+  bool grid_mpi_split_;
+  double grid_max_;
+  double rct_shift_;
+  double rct_z0_, rct_zv_;
+  double rct_z0_err_, rct_zv_err_;
   unsigned rct_ustride_;
   double work_;
-  long int last_step_warn_grid;
 
   static void   registerTemperingKeywords(const std::string &name_stem, const std::string &name, Keywords &keys);
   void   readTemperingSpecs(TemperingSpecs &t_specs);
@@ -454,14 +473,20 @@ private:
   void   readGaussians(IFile*);
   void   writeGaussian(const Gaussian&,OFile&);
   void   addGaussian(const Gaussian&);
+  void   addGaussianToGrid(const Gaussian&);
   double getHeight(const vector<double>&);
   void   temperHeight(double &height, const TemperingSpecs &t_specs, const double tempering_bias);
   double getBiasAndDerivatives(const vector<double>&,double* der=NULL);
   double evaluateGaussian(const vector<double>&, const Gaussian&,double* der=NULL);
   double getGaussianNormalization( const Gaussian& );
   vector<unsigned> getGaussianSupport(const Gaussian&);
+  vector<double> getGaussianBoundingBox(const Gaussian&);
   bool   scanOneHill(IFile *ifile,  vector<Value> &v, vector<double> &center, vector<double>  &sigma, double &height, bool &multivariate);
   void   computeReweightingFactor();
+  void   resetGridStatistics();
+  void   updateGridStatistics(double oldval,double newval);
+  double getMaxBias();
+  void   addToGrid(Grid::index_t index,double bias,vector<double>& der);
   double getTransitionBarrierBias();
   void updateFrequencyAdaptiveStride();
   string fmt;
@@ -470,6 +495,7 @@ public:
   explicit MetaD(const ActionOptions&);
   void calculate();
   void update();
+  bool isHistoryDependent()const override {return true;}
   static void registerKeywords(Keywords& keys);
   bool checkNeedsGradients()const {if(adaptive_==FlexibleBin::geometry) {return true;} else {return false;}}
 };
@@ -492,6 +518,7 @@ void MetaD::registerKeywords(Keywords& keys) {
   keys.add("compulsory","FILE","HILLS","a file in which the list of added hills is stored");
   keys.add("optional","HEIGHT","the heights of the Gaussian hills. Compulsory unless TAU and either BIASFACTOR or DAMPFACTOR are given");
   keys.add("optional","FMT","specify format for HILLS files (useful for decrease the number of digits in regtests)");
+  keys.addFlag("BINARY",false,"write the HILLS file in binary format, see \\ref convert_fields");
   keys.add("optional","BIASFACTOR","use well tempered metadynamics and use this bias factor.  Please note you must also specify temp");
   keys.add("optional","RECT","list of bias factors for all the replicas");
   keys.add("optional","DAMPFACTOR","damp hills with exp(-max(V)/(\\f$k_B\\f$T*DAMPFACTOR)");
@@ -510,7 +537,11 @@ void MetaD::registerKeywords(Keywords& keys) {
   keys.add("optional","RCT_USTRIDE","the update stride for calculating the \\f$c(t)\\f$ reweighting factor."
            "The default 1, so \\f$c(t)\\f$ is updated every time the bias is updated.");
   keys.addFlag("GRID_SPARSE",false,"use a sparse grid to store hills");
+  keys.addFlag("GRID_BLOCKS",false,"use a block sparse grid to store hills: the grid is divided in dense blocks that are only allocated when a hill is added to them, "
+               "so that memory scales with the explored region");
   keys.addFlag("GRID_NOSPLINE",false,"don't use spline interpolation with grids");
+  keys.addFlag("GRID_MPI_SPLIT",false,"split the grid points of each new hill among the MPI processes and sum them, instead of evaluating the whole hill on every process. "
+               "This requires communication at every deposition and is only convenient for very large hills");
   keys.add("optional","GRID_WSTRIDE","write the grid to a file every N steps");
   keys.add("optional","GRID_WFILE","the file on which to write the grid");
   keys.add("optional","GRID_RFILE","a grid file from which the bias should be read at the initial step of the simulation");
@@ -554,6 +585,7 @@ MetaD::MetaD(const ActionOptions& ao):
 // Metadynamics basic parameters
   height0_(std::numeric_limits<double>::max()), biasf_(-1.0), dampfactor_(0.0),
   tt_specs_(false, "TT", "Transition Tempered", -1.0, 0.0, 1.0),
+  target_max_(0.0),
   kbt_(0.0),
   stride_(0), welltemp_(false),
 // frequency adaptive
@@ -577,9 +609,16 @@ MetaD::MetaD(const ActionOptions& ao):
   isFirstStep(true),
   calc_rct_(false),
   reweight_factor_(0.0),
+  track_grid_(false),
+  grid_stats_valid_(false),
+  dense_grid_(false),
+  grid_mpi_split_(false),
+  grid_max_(0.0),
+  rct_shift_(0.0),
+  rct_z0_(0.0), rct_zv_(0.0),
+  rct_z0_err_(0.0), rct_zv_err_(0.0),
   rct_ustride_(1),
-  work_(0),
-  last_step_warn_grid(0)
+  work_(0)
 {
   // parse the flexible hills
   string adaptiveoption;
@@ -641,6 +680,8 @@ MetaD::MetaD(const ActionOptions& ao):
   current_stride = stride_;
   string hillsfname="HILLS";
   parse("FILE",hillsfname);
+  bool binary=false;
+  parseFlag("BINARY",binary);
 
   // Manually set to calculate special bias quantities
   // throughout the course of simulation. (These are chosen due to
@@ -757,6 +798,11 @@ MetaD::MetaD(const ActionOptions& ao):
   }
   bool sparsegrid=false;
   parseFlag("GRID_SPARSE",sparsegrid);
+  bool blockgrid=false;
+  parseFlag("GRID_BLOCKS",blockgrid);
+  if(sparsegrid && blockgrid) error("GRID_SPARSE and GRID_BLOCKS cannot be used together");
+  dense_grid_=!sparsegrid && !blockgrid;
+  parseFlag("GRID_MPI_SPLIT",grid_mpi_split_);
   bool nospline=false;
   parseFlag("GRID_NOSPLINE",nospline);
   bool spline=!nospline;
@@ -855,6 +901,7 @@ MetaD::MetaD(const ActionOptions& ao):
   log.printf("  Gaussian height %f\n",height0_);
   log.printf("  Gaussian deposition pace %d\n",stride_);
   log.printf("  Gaussian file %s\n",hillsfname.c_str());
+  if(binary) log.printf("  Gaussian file is written in binary format\n");
   if(welltemp_) {
     log.printf("  Well-Tempered Bias Factor %f\n",biasf_);
     log.printf("  Hills relaxation time (tau) %f\n",tau);
@@ -929,6 +976,8 @@ MetaD::MetaD(const ActionOptions& ao):
     log.printf("\n");
     if(spline) {log.printf("  Grid uses spline interpolation\n");}
     if(sparsegrid) {log.printf("  Grid uses sparse grid\n");}
+    if(blockgrid) {log.printf("  Grid uses block sparse grid\n");}
+    if(grid_mpi_split_) {log.printf("  Hills are split among MPI processes when added to the grid\n");}
     if(wgridstride_>0) {log.printf("  Grid is written on file %s with stride %d\n",gridfilename_.c_str(),wgridstride_);}
   }
 
@@ -1015,6 +1064,7 @@ MetaD::MetaD(const ActionOptions& ao):
     addComponent("maxbias");
     componentIsNotPeriodic("maxbias");
   }
+  track_grid_=grid_ && (calc_rct_ || calc_max_bias_ || dampfactor_>0.0);
   if (calc_transition_bias_) {
     if (!grid_) error("Calculating the transition bias on the fly works only with a grid");
     log.printf("  calculation on the fly of the transition bias V*(t)\n");
@@ -1067,6 +1117,18 @@ MetaD::MetaD(const ActionOptions& ao):
   // for performance
   dp_.reset( new double[getNumberOfArguments()] );
 
+  // without a grid, hills are looked up in a spatial index so that
+  // only those close to the current point are evaluated
+  if(!grid_) {
+    vector<bool> periodic(getNumberOfArguments());
+    vector<double> pmin(getNumberOfArguments(),0.0),pmax(getNumberOfArguments(),0.0);
+    for(unsigned i=0; i<getNumberOfArguments(); i++) {
+      periodic[i]=getPntrToArgument(i)->isPeriodic();
+      if(periodic[i]) getPntrToArgument(i)->getDomain(pmin[i],pmax[i]);
+    }
+    hillsIndex_.reset(new BucketIndex(periodic,pmin,pmax));
+  }
+
   // initializing and checking grid
   if(grid_) {
     // check for mesh and sigma size
@@ -1082,7 +1144,8 @@ MetaD::MetaD(const ActionOptions& ao):
       }
     }
     std::string funcl=getLabel() + ".bias";
-    if(!sparsegrid) {BiasGrid_.reset(new Grid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
+    if(blockgrid) {BiasGrid_.reset(new BlockSparseGrid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
+    else if(!sparsegrid) {BiasGrid_.reset(new Grid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
     else {BiasGrid_.reset(new SparseGrid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
     std::vector<std::string> actualmin=BiasGrid_->getMin();
     std::vector<std::string> actualmax=BiasGrid_->getMax();
@@ -1106,7 +1169,7 @@ MetaD::MetaD(const ActionOptions& ao):
       error("The GRID file you want to read: " + gridreadfilename_ + ", cannot be found!");
     }
     std::string funcl=getLabel() + ".bias";
-    BiasGrid_=Grid::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true);
+    BiasGrid_=Grid::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true, blockgrid);
     if(BiasGrid_->getDimension()!=getNumberOfArguments()) error("mismatch between dimensionality of input grid and number of arguments");
     for(unsigned i=0; i<getNumberOfArguments(); ++i) {
       if( getPntrToArgument(i)->isPeriodic()!=BiasGrid_->getIsPeriodic()[i] ) error("periodicity mismatch between arguments and input bias");
@@ -1133,7 +1196,8 @@ MetaD::MetaD(const ActionOptions& ao):
       if(mesh>0.5*sigma0_[i]) log<<"  WARNING: Using a METAD with a Grid Spacing larger than half of the Gaussians width can produce artifacts\n";
     }
     std::string funcl=getLabel() + ".bias";
-    if(!sparsegrid) {BiasGrid_.reset(new Grid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
+    if(blockgrid) {BiasGrid_.reset(new BlockSparseGrid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
+    else if(!sparsegrid) {BiasGrid_.reset(new Grid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
     else {BiasGrid_.reset(new SparseGrid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
     std::vector<std::string> actualmin=BiasGrid_->getMin();
     std::vector<std::string> actualmax=BiasGrid_->getMax();
@@ -1201,13 +1265,14 @@ MetaD::MetaD(const ActionOptions& ao):
     for(unsigned i=0; i<getNumberOfArguments(); ++i) {
       if( getPntrToArgument(i)->isPeriodic()!=TargetGrid_->getIsPeriodic()[i] ) error("periodicity mismatch between arguments and input bias");
     }
+    target_max_=TargetGrid_->getMaxValue();
   }
 
   // Calculate the Tiwary-Parrinello reweighting factor if we are restarting from previous hills
   if(getRestart() && calc_rct_) computeReweightingFactor();
   // Calculate all special bias quantities desired if restarting with nonzero bias.
   if(getRestart() && calc_max_bias_) {
-    max_bias_ = BiasGrid_->getMaxValue();
+    max_bias_ = getMaxBias();
     getPntrToComponent("maxbias")->set(max_bias_);
   }
   if(getRestart() && calc_transition_bias_) {
@@ -1239,6 +1304,7 @@ MetaD::MetaD(const ActionOptions& ao):
     hillsOfile_.enforceSuffix("");
   }
   if(mw_n_>1) hillsOfile_.enforceSuffix("");
+  if(binary) hillsOfile_.enforceBinary();
   hillsOfile_.open(ifilesnames[mw_id_]);
   if(fmt.length()>0) hillsOfile_.fmtField(fmt);
   hillsOfile_.addConstantField("multivariate");
@@ -1399,20 +1465,23 @@ void MetaD::writeGaussian(const Gaussian& hill, OFile&file)
 
 void MetaD::addGaussian(const Gaussian& hill)
 {
-  if(!grid_) hills_.push_back(hill);
-  else {
+  if(!grid_) {
+    hillsIndex_->add(hills_.size(),hill.center,getGaussianBoundingBox(hill));
+    hills_.push_back(hill);
+  } else if(doInt_) {
+    // with INTERVAL the cv is clamped at the boundaries, so use the generic kernel
     unsigned ncv=getNumberOfArguments();
     vector<unsigned> nneighb=getGaussianSupport(hill);
     vector<Grid::index_t> neighbors=BiasGrid_->getNeighbors(hill.center,nneighb);
     vector<double> der(ncv);
     vector<double> xx(ncv);
-    if(comm.Get_size()==1) {
+    if(!grid_mpi_split_ || comm.Get_size()==1) {
       for(unsigned i=0; i<neighbors.size(); ++i) {
         Grid::index_t ineigh=neighbors[i];
         for(unsigned j=0; j<ncv; ++j) der[j]=0.0;
         BiasGrid_->getPoint(ineigh,xx);
         double bias=evaluateGaussian(xx,hill,&der[0]);
-        BiasGrid_->addValueAndDerivatives(ineigh,bias,der);
+        addToGrid(ineigh,bias,der);
       }
     } else {
       unsigned stride=comm.Get_size();
@@ -1429,10 +1498,181 @@ void MetaD::addGaussian(const Gaussian& hill)
       for(unsigned i=0; i<neighbors.size(); ++i) {
         Grid::index_t ineigh=neighbors[i];
         for(unsigned j=0; j<ncv; ++j) {der[j]=allder[ncv*i+j];}
-        BiasGrid_->addValueAndDerivatives(ineigh,allbias[i],der);
+        addToGrid(ineigh,allbias[i],der);
+      }
+    }
+  } else {
+    addGaussianToGrid(hill);
+  }
+}
+
+void MetaD::addGaussianToGrid(const Gaussian& hill)
+{
+  const unsigned ncv=getNumberOfArguments();
+  const vector<unsigned> nneighb=getGaussianSupport(hill);
+  const vector<unsigned> nbin=BiasGrid_->getNbin();
+  const vector<bool> pbc=BiasGrid_->getIsPeriodic();
+  const vector<unsigned> center=BiasGrid_->getIndices(hill.center);
+
+// The stencil is the tensor product of one list of grid lines per dimension.
+// For each of them we store the contribution to the global grid index
+// and the distance from the center, so that differences (and, for
+// diagonal hills, exponentials) are computed once per line and not once per point.
+  vector<vector<Grid::index_t> > offset(ncv);
+  vector<vector<double> > dist(ncv);
+  vector<vector<double> > gauss(ncv);
+  vector<unsigned> tmp_indices(center);
+  vector<double> xx(ncv);
+  Grid::index_t gstride=1;
+  unsigned npoints=1;
+  for(unsigned j=0; j<ncv; ++j) {
+    for(int k=-static_cast<int>(nneighb[j]); k<=static_cast<int>(nneighb[j]); ++k) {
+      int i0=static_cast<int>(center[j])+k;
+      if(!pbc[j] && i0<0) continue;
+      if(!pbc[j] && i0>=static_cast<int>(nbin[j])) continue;
+      if( pbc[j] && i0<0) i0=nbin[j]-(-i0)%nbin[j];
+      if( pbc[j] && i0>=static_cast<int>(nbin[j])) i0%=nbin[j];
+      tmp_indices[j]=static_cast<unsigned>(i0);
+      BiasGrid_->getPoint(tmp_indices,xx);
+      double dp=difference(j,hill.center[j],xx[j]);
+      if(!hill.multivariate) {
+        dp*=hill.invsigma[j];
+        gauss[j].push_back(exp(-0.5*dp*dp));
+      }
+      offset[j].push_back(gstride*i0);
+      dist[j].push_back(dp);
+    }
+    tmp_indices[j]=center[j];
+    gstride*=nbin[j];
+    npoints*=offset[j].size();
+  }
+  if(npoints==0) return;
+
+  // the full inverse covariance is recomposed once per hill
+  Matrix<double> mymatrix;
+  if(hill.multivariate) {
+    mymatrix.resize(ncv,ncv);
+    unsigned k=0;
+    for(unsigned i=0; i<ncv; i++) {
+      for(unsigned j=i; j<ncv; j++) {
+        mymatrix(i,j)=mymatrix(j,i)=hill.sigma[k];
+        k++;
+      }
+    }
+  }
+
+// By default every process evaluates the whole stencil split among its threads,
+// which is cheaper than reducing the stencil over MPI at each deposition.
+// With GRID_MPI_SPLIT the points are also split among processes and summed.
+  const bool split=grid_mpi_split_ && comm.Get_size()>1;
+  const unsigned stride=(split?comm.Get_size():1);
+  const unsigned rank=(split?comm.Get_rank():0);
+// When all the points of the stencil are different points of a dense grid,
+// each thread adds its points directly to the grid. Otherwise the values are
+// stored and accumulated serially, since sparse grids allocate on write,
+// periodic stencils wider than the grid visit the same point twice and
+// the statistics of the grid are updated point by point.
+  bool direct=!split && dense_grid_ && !track_grid_;
+  for(unsigned j=0; j<ncv; ++j) if(offset[j].size()>nbin[j]) direct=false;
+  vector<Grid::index_t> index;
+  vector<double> allbias;
+  vector<double> allder;
+  if(!direct) {
+    index.resize(npoints);
+    allbias.assign(npoints,0.0);
+    allder.assign(npoints*ncv,0.0);
+  }
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt*64*stride>npoints) nt=1;
+  #pragma omp parallel num_threads(nt)
+  {
+    vector<unsigned> k(ncv);
+    vector<double> dp(ncv);
+    vector<double> der(ncv);
+    #pragma omp for
+    for(unsigned p=0; p<npoints; ++p) {
+      unsigned kk=p;
+      Grid::index_t ind=0;
+      for(unsigned j=0; j<ncv; ++j) {
+        k[j]=kk%offset[j].size();
+        kk/=offset[j].size();
+        ind+=offset[j][k[j]];
+        dp[j]=dist[j][k[j]];
+      }
+      if(!direct) index[p]=ind;
+      if(p%stride!=rank) continue;
+      double dp2=0.0;
+      double bias=0.0;
+      if(hill.multivariate) {
+        for(unsigned i=0; i<ncv; ++i) {
+          for(unsigned j=i; j<ncv; ++j) {
+            if(i==j) dp2+=dp[i]*dp[i]*mymatrix(i,j)*0.5;
+            else dp2+=dp[i]*dp[j]*mymatrix(i,j);
+          }
+        }
+        if(dp2>=DP2CUTOFF) continue;
+        bias=hill.height*exp(-dp2);
+        for(unsigned i=0; i<ncv; ++i) {
+          double tmp=0.0;
+          for(unsigned j=0; j<ncv; ++j) tmp+=dp[j]*mymatrix(i,j)*bias;
+          der[i]=-tmp;
+        }
+      } else {
+        double g=1.0;
+        for(unsigned j=0; j<ncv; ++j) {
+          dp2+=dp[j]*dp[j];
+          g*=gauss[j][k[j]];
+        }
+        dp2*=0.5;
+        if(dp2>=DP2CUTOFF) continue;
+        bias=hill.height*g;
+        for(unsigned i=0; i<ncv; ++i) der[i]=-bias*dp[i]*hill.invsigma[i];
+      }
+      if(direct) {
+        BiasGrid_->addValueAndDerivatives(ind,bias,der);
+      } else {
+        allbias[p]=bias;
+        for(unsigned i=0; i<ncv; ++i) allder[ncv*p+i]=der[i];
+      }
+    }
+  }
+  if(direct) return;
+  if(split) {
+    comm.Sum(allbias);
+    comm.Sum(allder);
+  }
+
+  vector<double> der(ncv);
+  for(unsigned p=0; p<npoints; ++p) {
+    for(unsigned j=0; j<ncv; ++j) der[j]=allder[ncv*p+j];
+    addToGrid(index[p],allbias[p],der);
+  }
+}
+
+vector<double> MetaD::getGaussianBoundingBox(const Gaussian& hill)
+{
+  unsigned ncv=getNumberOfArguments();
+  vector<double> halfwidth(ncv);
+  if(hill.multivariate) {
+    // the box bounding the ellipsoid is given by the diagonal of the covariance
+    unsigned k=0;
+    Matrix<double> mymatrix(ncv,ncv);
+    for(unsigned i=0; i<ncv; i++) {
+      for(unsigned j=i; j<ncv; j++) {
+        mymatrix(i,j)=mymatrix(j,i)=hill.sigma[k];
+        k++;
       }
     }
+    Matrix<double> myinv(ncv,ncv);
+    Invert(mymatrix,myinv);
+    for(unsigned i=0; i<ncv; i++) halfwidth[i]=sqrt(2.0*DP2CUTOFF*myinv(i,i));
+  } else {
+    // a vanishing sigma gives a hill that is constant along that direction
+    for(unsigned i=0; i<ncv; i++) {
+      halfwidth[i]=(hill.invsigma[i]!=0.0?sqrt(2.0*DP2CUTOFF)*std::abs(hill.sigma[i]):std::numeric_limits<double>::infinity());
+    }
   }
+  return halfwidth;
 }
 
 vector<unsigned> MetaD::getGaussianSupport(const Gaussian& hill)
@@ -1493,17 +1733,19 @@ double MetaD::getBiasAndDerivatives(const vector<double>& cv, double* der)
 {
   double bias=0.0;
   if(!grid_) {
-    if(hills_.size()>10000 && (getStep()-last_step_warn_grid)>10000) {
-      std::string msg;
-      Tools::convert(hills_.size(),msg);
-      msg="You have accumulated "+msg+" hills, you should enable GRIDs to avoid serious performance hits";
-      warning(msg);
-      last_step_warn_grid=getStep();
-    }
     unsigned stride=comm.Get_size();
     unsigned rank=comm.Get_rank();
-    for(unsigned i=rank; i<hills_.size(); i+=stride) {
-      bias+=evaluateGaussian(cv,hills_[i],der);
+    // hills are split among ranks as if all of them were evaluated
+    if(doInt_) {
+      vector<double> clamped(cv);
+      clamped[0]=std::max(lowI_,std::min(uppI_,cv[0]));
+      hillsIndex_->getCandidates(clamped,candidates_);
+    } else {
+      hillsIndex_->getCandidates(cv,candidates_);
+    }
+    for(unsigned i=0; i<candidates_.size(); ++i) {
+      if(candidates_[i]%stride!=rank) continue;
+      bias+=evaluateGaussian(cv,hills_[candidates_[i]],der);
     }
     comm.Sum(bias);
     if(der) comm.Sum(der,getNumberOfArguments());
@@ -1632,7 +1874,7 @@ double MetaD::getHeight(const vector<double>& cv)
   }
   if(dampfactor_>0.0) {
     plumed_assert(BiasGrid_);
-    double m=BiasGrid_->getMaxValue();
+    double m=getMaxBias();
     height*=exp(-m/(kbt_*(dampfactor_)));
   }
   if (tt_specs_.is_active) {
@@ -1640,7 +1882,7 @@ double MetaD::getHeight(const vector<double>& cv)
     temperHeight(height, tt_specs_, vbarrier);
   }
   if(TargetGrid_) {
-    double f=TargetGrid_->getValue(cv)-TargetGrid_->getMaxValue();
+    double f=TargetGrid_->getValue(cv)-target_max_;
     height*=exp(f/kbt_);
   }
   return height;
@@ -1753,6 +1995,7 @@ void MetaD::update() {
       // Flying Gaussian
       if (flying) {
         hills_.clear();
+        hillsIndex_->clear();
         comm.Barrier();
       }
 
@@ -1838,7 +2081,7 @@ void MetaD::update() {
   bool bias_has_changed = (nowAddAHill || (mw_n_ > 1 && getStep() % mw_rstride_ == 0));
   if (calc_rct_ && bias_has_changed && getStep()%(stride_*rct_ustride_)==0) computeReweightingFactor();
   if (calc_max_bias_ && bias_has_changed) {
-    max_bias_ = BiasGrid_->getMaxValue();
+    max_bias_ = getMaxBias();
     getPntrToComponent("maxbias")->set(max_bias_);
   }
   if (calc_transition_bias_ && bias_has_changed) {
@@ -1930,30 +2173,98 @@ void MetaD::computeReweightingFactor()
     return;
   }
 
-  double Z_0=0; //proportional to the integral of exp(-beta*F)
-  double Z_V=0; //proportional to the integral of exp(-beta*(F+V))
-  double minusBetaF=biasf_/(biasf_-1.)/kbt_;
-  double minusBetaFplusV=1./(biasf_-1.)/kbt_;
-  if (biasf_==-1.0) { //non well-tempered case
-    minusBetaF=1;
-    minusBetaFplusV=0;
-  }
-  const double big_number=minusBetaF*BiasGrid_->getMaxValue(); //to avoid exp overflow
+  // the partition functions are updated at every deposition, they are recomputed
+  // from scratch only when the accumulated rounding error becomes significant
+  const double tolerance=1e-12;
+  if(!grid_stats_valid_ || rct_z0_err_>tolerance*rct_z0_ || rct_zv_err_>tolerance*rct_zv_) resetGridStatistics();
 
-  const unsigned rank=comm.Get_rank();
-  const unsigned stride=comm.Get_size();
-  for (Grid::index_t t=rank; t<BiasGrid_->getSize(); t+=stride) {
-    const double val=BiasGrid_->getValue(t);
-    Z_0+=std::exp(minusBetaF*val-big_number);
-    Z_V+=std::exp(minusBetaFplusV*val-big_number);
+  reweight_factor_=kbt_*std::log(rct_z0_/rct_zv_);
+  getPntrToComponent("rct")->set(reweight_factor_);
+}
+
+void MetaD::resetGridStatistics()
+{
+  grid_max_=BiasGrid_->getMaxValue();
+  rct_z0_=rct_zv_=0.0;
+  rct_z0_err_=rct_zv_err_=0.0;
+  if(calc_rct_ && biasf_!=1.0) {
+    double Z_0=0; //proportional to the integral of exp(-beta*F)
+    double Z_V=0; //proportional to the integral of exp(-beta*(F+V))
+    double minusBetaF=biasf_/(biasf_-1.)/kbt_;
+    double minusBetaFplusV=1./(biasf_-1.)/kbt_;
+    if (biasf_==-1.0) { //non well-tempered case
+      minusBetaF=1;
+      minusBetaFplusV=0;
+    }
+    rct_shift_=minusBetaF*grid_max_; //to avoid exp overflow
+
+    const unsigned rank=comm.Get_rank();
+    const unsigned stride=comm.Get_size();
+    for (Grid::index_t t=rank; t<BiasGrid_->getSize(); t+=stride) {
+      const double val=BiasGrid_->getValue(t);
+      Z_0+=std::exp(minusBetaF*val-rct_shift_);
+      Z_V+=std::exp(minusBetaFplusV*val-rct_shift_);
+    }
+    if (stride>1) {
+      comm.Sum(Z_0);
+      comm.Sum(Z_V);
+    }
+    rct_z0_=Z_0;
+    rct_zv_=Z_V;
   }
-  if (stride>1) {
-    comm.Sum(Z_0);
-    comm.Sum(Z_V);
+  grid_stats_valid_=true;
+}
+
+void MetaD::updateGridStatistics(double oldval,double newval)
+{
+  if(!grid_stats_valid_) return;
+  // a decreasing bias could lower the maximum, which cannot be tracked locally
+  if(newval<oldval) {
+    grid_stats_valid_=false;
+    return;
   }
+  if(calc_rct_ && biasf_!=1.0) {
+    double minusBetaF=biasf_/(biasf_-1.)/kbt_;
+    double minusBetaFplusV=1./(biasf_-1.)/kbt_;
+    if (biasf_==-1.0) {
+      minusBetaF=1;
+      minusBetaFplusV=0;
+    }
+    // shift the exponentials again if the maximum grew too much
+    if(newval>grid_max_ && minusBetaF*newval-rct_shift_>100.0) {
+      const double factor=std::exp(rct_shift_-minusBetaF*newval);
+      rct_z0_*=factor; rct_zv_*=factor;
+      rct_z0_err_*=factor; rct_zv_err_*=factor;
+      rct_shift_=minusBetaF*newval;
+    }
+    const double new0=std::exp(minusBetaF*newval-rct_shift_);
+    const double old0=std::exp(minusBetaF*oldval-rct_shift_);
+    const double newv=std::exp(minusBetaFplusV*newval-rct_shift_);
+    const double oldv=std::exp(minusBetaFplusV*oldval-rct_shift_);
+    rct_z0_+=new0-old0;
+    rct_zv_+=newv-oldv;
+    rct_z0_err_+=std::numeric_limits<double>::epsilon()*(new0+old0);
+    rct_zv_err_+=std::numeric_limits<double>::epsilon()*(newv+oldv);
+    if(!std::isfinite(rct_z0_) || !std::isfinite(rct_zv_)) grid_stats_valid_=false;
+  }
+  if(newval>grid_max_) grid_max_=newval;
+}
 
-  reweight_factor_=kbt_*std::log(Z_0/Z_V);
-  getPntrToComponent("rct")->set(reweight_factor_);
+double MetaD::getMaxBias()
+{
+  if(!grid_stats_valid_) resetGridStatistics();
+  return grid_max_;
+}
+
+void MetaD::addToGrid(Grid::index_t index,double bias,vector<double>& der)
+{
+  if(!track_grid_) {
+    BiasGrid_->addValueAndDerivatives(index,bias,der);
+    return;
+  }
+  const double oldval=BiasGrid_->getValue(index);
+  BiasGrid_->addValueAndDerivatives(index,bias,der);
+  updateGridStatistics(oldval,BiasGrid_->getValue(index));
 }
 
 double MetaD::getTransitionBarrierBias() {
@@ -29,6 +29,7 @@
 #include "core/FlexibleBin.h"
 #include "tools/Matrix.h"
 #include "tools/Random.h"
+#include "tools/BucketIndex.h"
 #include <string>
 #include <cstring>
 #include "tools/File.h"
@@ -235,6 +236,8 @@ private:
   vector<double> sigma0min_;
   vector<double> sigma0max_;
   vector< vector<Gaussian> > hills_;
+  vector<std::unique_ptr<BucketIndex>> hillsIndex_;
+  vector<unsigned> candidates_;
   vector<std::unique_ptr<OFile>> hillsOfiles_;
   vector<std::unique_ptr<OFile>> gridfiles_;
   vector<std::unique_ptr<Grid>> BiasGrids_;
@@ -280,6 +283,7 @@ public:
   explicit PBMetaD(const ActionOptions&);
   void calculate();
   void update();
+  bool isHistoryDependent()const override {return true;}
   static void registerKeywords(Keywords& keys);
   bool checkNeedsGradients()const {if(adaptive_==FlexibleBin::geometry) {return true;} else {return false;}}
 };
@@ -602,6 +606,16 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
 
   // initializing vector of hills
   hills_.resize(getNumberOfArguments());
+  // without a grid, hills are looked up in a spatial index so that
+  // only those close to the current point are evaluated
+  if(!grid_) {
+    for(unsigned i=0; i<getNumberOfArguments(); ++i) {
+      vector<bool> periodic(1,getPntrToArgument(i)->isPeriodic());
+      vector<double> pmin(1,0.0),pmax(1,0.0);
+      if(periodic[0]) getPntrToArgument(i)->getDomain(pmin[0],pmax[0]);
+      hillsIndex_.emplace_back(new BucketIndex(periodic,pmin,pmax));
+    }
+  }
 
   // restart from external grid
   bool restartedFromGrid=false;
@@ -819,8 +833,14 @@ void PBMetaD::writeGaussian(unsigned iarg, const Gaussian& hill, OFile *ofile)
 
 void PBMetaD::addGaussian(unsigned iarg, const Gaussian& hill)
 {
-  if(!grid_) {hills_[iarg].push_back(hill);}
-  else {
+  if(!grid_) {
+    vector<double> halfwidth(1);
+    if(hill.multivariate) halfwidth[0]=sqrt(2.0*DP2CUTOFF/hill.sigma[0]);
+    else if(hill.invsigma[0]!=0.0) halfwidth[0]=sqrt(2.0*DP2CUTOFF)*std::abs(hill.sigma[0]);
+    else halfwidth[0]=std::numeric_limits<double>::infinity();
+    hillsIndex_[iarg]->add(hills_[iarg].size(),hill.center,halfwidth);
+    hills_[iarg].push_back(hill);
+  } else {
     vector<unsigned> nneighb=getGaussianSupport(iarg, hill);
     vector<Grid::index_t> neighbors=BiasGrids_[iarg]->getNeighbors(hill.center,nneighb);
     vector<double> der(1);
@@ -886,8 +906,16 @@ double PBMetaD::getBiasAndDerivatives(unsigned iarg, const vector<double>& cv, d
   if(!grid_) {
     unsigned stride=comm.Get_size();
     unsigned rank=comm.Get_rank();
-    for(unsigned i=rank; i<hills_[iarg].size(); i+=stride) {
-      bias += evaluateGaussian(iarg,cv,hills_[iarg][i],der);
+    // hills are split among ranks as if all of them were evaluated
+    if(doInt_[iarg]) {
+      vector<double> clamped(1,std::max(lowI_[iarg],std::min(uppI_[iarg],cv[0])));
+      hillsIndex_[iarg]->getCandidates(clamped,candidates_);
+    } else {
+      hillsIndex_[iarg]->getCandidates(cv,candidates_);
+    }
+    for(unsigned i=0; i<candidates_.size(); ++i) {
+      if(candidates_[i]%stride!=rank) continue;
+      bias += evaluateGaussian(iarg,cv,hills_[iarg][candidates_[i]],der);
     }
     comm.Sum(bias);
     if(der) comm.Sum(der,1);
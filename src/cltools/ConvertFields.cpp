@@ -0,0 +1,158 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "CLTool.h"
+#include "CLToolRegister.h"
+#include "tools/Tools.h"
+#include "core/ActionRegister.h"
+#include "tools/IFile.h"
+#include "tools/OFile.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace PLMD {
+namespace cltools {
+
+//+PLUMEDOC TOOLS convert_fields
+/*
+Convert a file with fields (e.g. a COLVAR or a HILLS file) between the text and the binary format.
+
+Files with fields can be written by PLUMED in a binary format, using the BINARY flag
+of \ref PRINT or of \ref METAD.
+These files start with the same `#! FIELDS` and `#! SET` lines
+that are found in text files, but the values of the fields on each line are stored
+as double precision numbers. Writing them is faster than formatting numbers as text,
+the resulting files are smaller and no precision is lost.
+Binary files are recognized automatically when they are read, e.g. by \ref READ,
+by \ref METAD when restarting or by \ref sum_hills.
+
+This tool reads a file with fields, in either format, and writes it again as text or,
+if `--binary` is used, in the binary format.
+
+\par Examples
+
+The following command converts a binary COLVAR file to text:
+\verbatim
+plumed convert_fields --ifile COLVAR.bin --ofile COLVAR
+\endverbatim
+
+The following command converts a text HILLS file to the binary format:
+\verbatim
+plumed convert_fields --ifile HILLS --ofile HILLS.bin --binary
+\endverbatim
+
+When writing text files, the format of the numbers can be chosen with `--fmt`:
+\verbatim
+plumed convert_fields --ifile COLVAR.bin --ofile COLVAR --fmt %8.4f
+\endverbatim
+
+*/
+//+ENDPLUMEDOC
+
+class ConvertFields:
+  public CLTool
+{
+public:
+  static void registerKeywords( Keywords& keys );
+  explicit ConvertFields(const CLToolOptions& co );
+  int main(FILE* in, FILE*out,Communicator& pc);
+  string description()const {
+    return "convert a file with fields between the text and the binary format";
+  }
+};
+
+PLUMED_REGISTER_CLTOOL(ConvertFields,"convert_fields")
+
+void ConvertFields::registerKeywords( Keywords& keys ) {
+  CLTool::registerKeywords( keys );
+  keys.add("compulsory","--ifile","specify the name of the input file");
+  keys.add("compulsory","--ofile","specify the name of the output file");
+  keys.add("compulsory","--fmt","%23.16lg","specify the format used to write numbers in text files");
+  keys.addFlag("--binary",false,"write the output file in the binary format");
+}
+
+ConvertFields::ConvertFields(const CLToolOptions& co ):
+  CLTool(co)
+{
+  inputdata=commandline;
+}
+
+int ConvertFields::main(FILE* in, FILE*out,Communicator& pc) {
+
+  std::string ifilename;
+  parse("--ifile",ifilename);
+  std::string ofilename;
+  parse("--ofile",ofilename);
+  std::string fmt;
+  parse("--fmt",fmt);
+  bool binary;
+  parseFlag("--binary",binary);
+
+  plumed_assert(ifilename.length()>0) << "please specify the input file with --ifile";
+  plumed_assert(ofilename.length()>0) << "please specify the output file with --ofile";
+  fprintf(out,"  with input file: %s\n",ifilename.c_str());
+  fprintf(out,"  with output file: %s\n",ofilename.c_str());
+  if(binary) fprintf(out,"  in binary format\n");
+
+  IFile ifile;
+  ifile.open(ifilename);
+
+  OFile ofile;
+  if(binary) ofile.enforceBinary();
+  ofile.open(ofilename);
+  ofile.fmtField(" "+fmt);
+
+  std::vector<std::string> fields,previous_fields;
+  std::vector<bool> constant;
+  std::string str;
+  double x;
+  while(ifile.scanFieldList(fields)) {
+// when the header changes, constant fields are declared again
+    if(fields!=previous_fields) {
+      ofile.clearFields();
+      constant.resize(fields.size());
+      for(unsigned i=0; i<fields.size(); i++) {
+        constant[i]=ifile.FieldIsConstant(fields[i]);
+        if(constant[i]) ofile.addConstantField(fields[i]);
+      }
+      previous_fields=fields;
+    }
+    for(unsigned i=0; i<fields.size(); i++) {
+      if(constant[i]) {
+        ifile.scanField(fields[i],str);
+        ofile.printField(fields[i],str);
+      } else {
+        ifile.scanField(fields[i],x);
+        ofile.printField(fields[i],x);
+      }
+    }
+    ifile.scanField();
+    ofile.printField();
+  }
+
+  return 0;
+}
+}
+
+} // End of namespace
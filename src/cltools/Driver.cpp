@@ -23,6 +23,7 @@
 #include "CLToolRegister.h"
 #include "tools/Tools.h"
 #include "core/PlumedMain.h"
+#include "core/ActionSet.h"
 #include "tools/Communicator.h"
 #include "tools/Random.h"
 #include "tools/Pbc.h"
@@ -30,11 +31,23 @@
 #include <cstring>
 #include <vector>
 #include <map>
+#include <set>
 #include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "tools/Units.h"
 #include "tools/PDB.h"
 #include "tools/FileBase.h"
 #include "tools/IFile.h"
+#include "tools/OFile.h"
 
 // when using molfile plugin
 #ifdef __PLUMED_HAS_MOLFILE_PLUGINS
@@ -174,6 +187,27 @@ Notice that the xdrfile implementation of xtc and trr
 is more robust than the molfile one, since it provides support for generic cell shapes.
 In addition, it allows \ref DUMPATOMS to write compressed xtc files.
 
+When analysing long trajectories with MPI, the frames can be distributed among the processes
+with `--frame-parallel`.
+Each process calculates its own frames, which are assigned in a round-robin fashion,
+with a separate copy of the actions.
+\verbatim
+mpirun -np 8 plumed driver --plumed plumed.dat --ixtc traj.xtc --frame-parallel
+\endverbatim
+This is only possible if the actions do not depend on the previous frames, so that e.g. \ref METAD or \ref HISTOGRAM
+are not allowed, and neither are neighbor lists that are not updated at every step (NL_STRIDE larger than one).
+Frames calculated by other processes are skipped without being parsed when reading xyz and gro files,
+and are not stored when using molfile plugins (some of them, e.g. dcd, also avoid reading them).
+Frames in xtc and trr files still need to be decoded by every process.
+At the end of the calculation, the files in which the first field is the time (e.g. those written by \ref PRINT)
+are merged back into time order. Other files are left in separate files with the rank of the process as a suffix.
+
+With `--prefetch` the trajectory is read and decoded by a separate thread,
+which keeps the given number of frames ready while plumed is calculating the current one.
+\verbatim
+plumed driver --plumed plumed.dat --ixtc traj.xtc --prefetch 4
+\endverbatim
+
 
 */
 //+ENDPLUMEDOC
@@ -195,12 +229,283 @@ static int register_cb(void *v, vmdplugin_t *p) {
 }
 #endif
 
+/// A frame read from the trajectory
+template<typename real>
+struct DriverFrame {
+  int natoms=0;
+/// the step read from the file, only used if hasStep is true
+  long int step=0;
+  bool hasStep=false;
+/// the frame is only read but not calculated (see --frame-parallel)
+  bool skip=false;
+  std::vector<real> coordinates;
+  std::vector<real> cell;
+};
+
+/// Reads frames in a separate thread, storing them in a ring of buffers.
+/// The buffers are swapped with the frame passed to next(), so that
+/// their memory is reused and no allocation is needed at every frame.
+template<typename real>
+class DriverPrefetcher {
+  std::function<bool(DriverFrame<real>&)> reader;
+  std::vector<DriverFrame<real> > ring;
+/// first filled buffer and number of filled buffers
+  unsigned first, filled;
+  bool finished, stop;
+  std::exception_ptr except;
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::thread th;
+  void run();
+public:
+  DriverPrefetcher(unsigned n,std::function<bool(DriverFrame<real>&)> reader);
+  ~DriverPrefetcher();
+/// Get the next frame, returns false at the end of the trajectory.
+/// Errors found while reading are rethrown here
+  bool next(DriverFrame<real>& f);
+};
+
+template<typename real>
+DriverPrefetcher<real>::DriverPrefetcher(unsigned n,std::function<bool(DriverFrame<real>&)> reader):
+  reader(reader),
+  ring(n),
+  first(0),
+  filled(0),
+  finished(false),
+  stop(false)
+{
+  plumed_assert(n>0);
+  th=std::thread(&DriverPrefetcher<real>::run,this);
+}
+
+template<typename real>
+DriverPrefetcher<real>::~DriverPrefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop=true;
+  }
+  cv.notify_all();
+  th.join();
+}
+
+template<typename real>
+void DriverPrefetcher<real>::run() {
+  try {
+    while(true) {
+      unsigned slot;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock,[this] {return stop || filled<ring.size();});
+        if(stop) return;
+        slot=(first+filled)%ring.size();
+      }
+// this buffer is not touched by next() until filled is increased
+      bool ok=reader(ring[slot]);
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        if(ok) filled++;
+        else finished=true;
+      }
+      cv.notify_all();
+      if(!ok) return;
+    }
+  } catch(...) {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      except=std::current_exception();
+      finished=true;
+    }
+    cv.notify_all();
+  }
+}
+
+template<typename real>
+bool DriverPrefetcher<real>::next(DriverFrame<real>& f) {
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait(lock,[this] {return filled>0 || finished;});
+  if(filled==0) {
+    if(except) std::rethrow_exception(except);
+    return false;
+  }
+  std::swap(f,ring[first]);
+  first=(first+1)%ring.size();
+  filled--;
+  lock.unlock();
+  cv.notify_all();
+  return true;
+}
+
+/// A trajectory in xyz or gro format mapped in memory.
+/// Functions are inline since this file is also included in DriverFloat.cpp.
+/// The beginning of each frame is found with a first scan of the file,
+/// and numbers are then parsed in place without copying the lines.
+class DriverMappedText {
+  const char* data;
+  size_t size;
+  bool gro;
+/// offset of the beginning of each frame
+  std::vector<size_t> frames;
+/// find the end of the line starting at p, excluding \n and \r, and move p to the next line
+  static bool getLine(const char*& p,const char* end,const char*& b,const char*& e);
+/// parse the token starting at p (skipping spaces) and move p after it, with the same rules as sscanf("%lf")
+  static bool parseToken(const char*& p,const char* e,double& d);
+  static int parseNatoms(const char* b,const char* e);
+public:
+  DriverMappedText(): data(NULL), size(0), gro(false) {}
+  ~DriverMappedText();
+/// map a file, returns false if the file cannot be mapped
+  bool open(const std::string& path,bool gro);
+  size_t getNumberOfFrames()const {return frames.size();}
+/// read frame i. If skip is true, only the number of atoms is read.
+/// If readBox is false the box of xyz files is not read
+  template<typename real>
+  void read(size_t i,bool skip,bool readBox,int& natoms,std::vector<real>& cell,std::vector<real>& coordinates)const;
+};
+
+inline DriverMappedText::~DriverMappedText() {
+  if(data) munmap(const_cast<char*>(data),size);
+}
+
+inline bool DriverMappedText::open(const std::string& path,bool gro) {
+  this->gro=gro;
+  int fd=::open(path.c_str(),O_RDONLY);
+  if(fd<0) return false;
+  struct stat st;
+  if(fstat(fd,&st)!=0 || st.st_size==0) { ::close(fd); return false; }
+  void* m=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  ::close(fd);
+  if(m==MAP_FAILED) return false;
+  data=static_cast<const char*>(m);
+  size=st.st_size;
+  madvise(m,size,MADV_SEQUENTIAL);
+// first scan: frames are made of a title (gro only), the number of atoms,
+// one line per atom and a line with the box
+  const char* p=data;
+  const char* end=data+size;
+  while(p<end) {
+    frames.push_back(p-data);
+    const char* b; const char* e;
+    if(gro) getLine(p,end,b,e);
+    if(!getLine(p,end,b,e)) break;
+    const int n=parseNatoms(b,e);
+    for(int i=0; i<n+1; i++) if(!getLine(p,end,b,e)) break;
+  }
+  return true;
+}
+
+inline bool DriverMappedText::getLine(const char*& p,const char* end,const char*& b,const char*& e) {
+  if(p>=end) return false;
+  b=p;
+  const char* n=static_cast<const char*>(memchr(p,'\n',end-p));
+  e=(n?n:end);
+  p=(n?n+1:end);
+  if(e>b && *(e-1)=='\r') e--;
+  return true;
+}
+
+inline int DriverMappedText::parseNatoms(const char* b,const char* e) {
+  while(b<e && (*b==' ' || *b=='\t')) b++;
+  int n=0;
+  bool neg=false;
+  if(b<e && (*b=='-' || *b=='+')) { neg=(*b=='-'); b++; }
+  for(; b<e && *b>='0' && *b<='9'; b++) n=10*n+(*b-'0');
+  return neg?-n:n;
+}
+
+inline bool DriverMappedText::parseToken(const char*& p,const char* e,double& d) {
+  while(p<e && (*p==' ' || *p=='\t')) p++;
+  const char* b=p;
+  while(p<e && *p!=' ' && *p!='\t') p++;
+  if(b==p) return false;
+  if(Tools::convertFast(b,p,d)) return true;
+// rare cases (e.g. numbers with many digits or large exponents) are converted as in the other readers
+  return Tools::convert(std::string(b,p),d);
+}
+
+template<typename real>
+void DriverMappedText::read(size_t i,bool skip,bool readBox,int& natoms,std::vector<real>& cell,std::vector<real>& coordinates)const {
+  const char* p=data+frames[i];
+  const char* end=(i+1<frames.size()?data+frames[i+1]:data+size);
+  const char* b; const char* e;
+  if(gro) getLine(p,end,b,e);
+  if(!getLine(p,end,b,e)) plumed_merror("premature end of trajectory file");
+  natoms=parseNatoms(b,e);
+  if(skip) return;
+  coordinates.assign(3*natoms,real(0.0));
+  cell.assign(9,real(0.0));
+  if(!gro) {
+    if(!getLine(p,end,b,e)) plumed_merror("premature end of trajectory file");
+    if(readBox) {
+// as with sscanf, numbers are read until the first word that is not a number
+      const unsigned nwords=Tools::getWords(std::string(b,e)).size();
+      if(nwords!=3 && nwords!=9) plumed_merror("needed box in second line of xyz file");
+      double c[9]= {0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0};
+      const char* q=b;
+      for(unsigned j=0; j<nwords; j++) if(!parseToken(q,e,c[j])) break;
+      if(nwords==3) {
+        cell[0]=real(c[0]); cell[4]=real(c[1]); cell[8]=real(c[2]);
+      } else {
+        for(unsigned j=0; j<9; j++) cell[j]=real(c[j]);
+      }
+    }
+  }
+  int ddist=0;
+  for(int iatom=0; iatom<natoms; iatom++) {
+    if(!getLine(p,end,b,e)) plumed_merror("premature end of trajectory file");
+    double cc[3];
+    if(!gro) {
+// skip the atom name
+      const char* q=b;
+      while(q<e && (*q==' ' || *q=='\t')) q++;
+      while(q<e && *q!=' ' && *q!='\t') q++;
+      if(!parseToken(q,e,cc[0]) || !parseToken(q,e,cc[1]) || !parseToken(q,e,cc[2]))
+        plumed_merror("cannot read line"+std::string(b,e));
+    } else {
+      if(!iatom) {
+// calculate the distance between dots (as in gromacs gmxlib/confio.c, routine get_w_conf )
+        const char* p1=static_cast<const char*>(memchr(b,'.',e-b));
+        if(!p1) plumed_merror("seems there are no coordinates in the gro file");
+        const char* p2=static_cast<const char*>(memchr(p1+1,'.',e-p1-1));
+        if(!p2) plumed_merror("seems there is only one coordinates in the gro file");
+        ddist=p2-p1;
+        const char* p3=static_cast<const char*>(memchr(p2+1,'.',e-p2-1));
+        if(!p3) plumed_merror("seems there are only two coordinates in the gro file");
+        if(p3-p2!=ddist) plumed_merror("not uniform spacing in fields in the gro file");
+      }
+      for(unsigned j=0; j<3; j++) {
+        const char* fb=b+20+j*ddist;
+        const char* fe=fb+ddist;
+        if(fe>e) fe=e;
+        if(fb>=fe) plumed_merror("cannot read line"+std::string(b,e));
+        const char* q=fb;
+        while(q<fe && *q==' ') q++;
+        if(!Tools::convertFast(q,fe,cc[j])) Tools::convert(std::string(fb,fe),cc[j]);
+      }
+    }
+    coordinates[3*iatom]=real(cc[0]);
+    coordinates[3*iatom+1]=real(cc[1]);
+    coordinates[3*iatom+2]=real(cc[2]);
+  }
+  if(gro) {
+    if(!getLine(p,end,b,e)) plumed_merror("premature end of trajectory file");
+    double c[9];
+    unsigned n=0;
+    const char* q=b;
+    while(n<9 && parseToken(q,e,c[n])) n++;
+    if(n<3) plumed_merror("cannot understand box format");
+    const unsigned index[9]= {0,4,8,1,2,3,5,6,7};
+    for(unsigned j=0; j<n; j++) cell[index[j]]=real(c[j]);
+  }
+}
+
 template<typename real>
 class Driver : public CLTool {
 public:
   static void registerKeywords( Keywords& keys );
   explicit Driver(const CLToolOptions& co );
   int main(FILE* in,FILE*out,Communicator& pc);
+/// Merge the output files written by the processes with --frame-parallel
+  void mergeFrameParallelFiles( const std::vector<std::string>& files, Communicator& pc, FILE* out );
   void evaluateNumericalDerivatives( const long int& step, PlumedMain& p, const std::vector<real>& coordinates,
                                      const std::vector<real>& masses, const std::vector<real>& charges,
                                      std::vector<real>& cell, const double& base, std::vector<real>& numder );
@@ -220,6 +525,8 @@ void Driver<real>::registerKeywords( Keywords& keys ) {
 #endif
           );
   keys.add("compulsory","--multi","0","set number of replicas for multi environment (needs MPI)");
+  keys.add("compulsory","--prefetch","0","number of frames that are read in advance by a separate thread while plumed is calculating, 0 means that frames are read when needed");
+  keys.addFlag("--frame-parallel",false,"distribute the frames among the MPI processes, each of them calculating its frames independently");
   keys.addFlag("--noatoms",false,"don't read in a trajectory.  Just use colvar files as specified in plumed.dat");
   keys.addFlag("--parse-only",false,"read the plumed input file and stop");
   keys.add("atoms","--ixyz","the trajectory in xyz format");
@@ -328,9 +635,20 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 // set up for multi replica driver:
   int multi=0;
   parse("--multi",multi);
+  bool frameparallel; parseFlag("--frame-parallel",frameparallel);
+  unsigned prefetch=0; parse("--prefetch",prefetch);
+  if(frameparallel) {
+    if(multi) error("cannot use --frame-parallel and --multi at the same time");
+    if(debug_pd || debug_dd) error("cannot use --frame-parallel and debug domain/particle decomposition at the same time");
+    if(noatoms) error("--frame-parallel requires a trajectory");
+    if(!Communicator::initialized() || pc.Get_size()==1) frameparallel=false;
+  }
   Communicator intracomm;
   Communicator intercomm;
-  if(multi) {
+  if(frameparallel) {
+// each process runs its own copy of plumed
+    pc.Split(pc.Get_rank(),0,intracomm);
+  } else if(multi) {
     int ntot=pc.Get_size();
     int nintra=ntot/multi;
     if(multi*nintra!=ntot) error("invalid number of processes for multi environment");
@@ -494,7 +812,8 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
     if( !Communicator::initialized() ) error("needs mpi for debug-pd");
   }
 
-  PlumedMain p;
+  std::unique_ptr<PlumedMain> pp(new PlumedMain);
+  PlumedMain& p(*pp);
   int rr=sizeof(real);
   p.cmd("setRealPrecision",&rr);
   int checknatoms=-1;
@@ -515,9 +834,16 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
   p.cmd("setMDEngine","driver");
   p.cmd("setTimestep",&timestep);
   p.cmd("setPlumedDat",plumedFile.c_str());
-  p.cmd("setLog",out);
+  if(frameparallel) {
+    string n; Tools::convert(pc.Get_rank(),n);
+    p.setSuffix("."+n);
+    if(pc.Get_rank()==0) p.cmd("setLog",out);
+    else p.cmd("setLogFile","/dev/null");
+  } else {
+    p.cmd("setLog",out);
+  }
 
-  int natoms;
+  int natoms=0;
 
   if(parseOnly) {
     if(command_line_natoms<0) error("--parseOnly requires setting the number of atoms with --natoms");
@@ -526,12 +852,16 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 
 
   FILE* fp=NULL; FILE* fp_forces=NULL; OFile fp_dforces;
+// xyz and gro files are mapped in memory if possible
+  std::unique_ptr<DriverMappedText> mapped;
 #ifdef __PLUMED_HAS_XDRFILE
   XDRFILE* xd=NULL;
 #endif
   if(!noatoms&&!parseOnly) {
-    if (trajectoryFile=="-")
+    if (trajectoryFile=="-") {
+      if(frameparallel) error("--frame-parallel cannot read the trajectory from standard input");
       fp=in;
+    }
     else {
       if(multi) {
         string n;
@@ -562,8 +892,12 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
         if(trajectory_fmt=="xdr-trr") read_trr_natoms(&trajectoryFile[0],&natoms);
 #endif
       } else {
-        fp=fopen(trajectoryFile.c_str(),"r");
-        if(!fp) {
+        if(trajectory_fmt=="xyz" || trajectory_fmt=="gro") {
+          mapped.reset(new DriverMappedText);
+          if(!mapped->open(trajectoryFile,trajectory_fmt=="gro")) mapped.reset();
+        }
+        if(!mapped) fp=fopen(trajectoryFile.c_str(),"r");
+        if(!mapped && !fp) {
           string msg="ERROR: Error opening trajectory file "+trajectoryFile;
           fprintf(stderr,"%s\n",msg.c_str());
           return 1;
@@ -588,12 +922,9 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
     }
   }
 
-  std::string line;
-  std::vector<real> coordinates;
   std::vector<real> forces;
   std::vector<real> masses;
   std::vector<real> charges;
-  std::vector<real> cell;
   std::vector<real> virial;
   std::vector<real> numder;
 
@@ -611,28 +942,206 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 // random stream to choose decompositions
   Random rnd;
 
-  while(true) {
-    if(!noatoms&&!parseOnly) {
-      if(use_molfile==true) {
+// the frame that is currently calculated
+  DriverFrame<real> trajFrame;
+  std::vector<real> & coordinates(trajFrame.coordinates);
+  std::vector<real> & cell(trajFrame.cell);
+
+// the number of atoms is only read from the file for xyz and gro
+  const int reader_natoms=natoms;
+  std::string frameline;
+// with --frame-parallel, only the frames with frame%npe==rank are calculated here
+  const int frame_npe=(frameparallel?pc.Get_size():1);
+  const int frame_rank=(frameparallel?pc.Get_rank():0);
+  long int framesRead=0;
+#ifdef __PLUMED_HAS_XDRFILE
+  std::unique_ptr<rvec[]> xdr_pos;
+  if(xd) xdr_pos.reset(new rvec[natoms]);
+#endif
+
+// Read the next frame of the trajectory, returns false at the end of the file.
+// When prefetching, this is called by the reader thread only, so it should
+// not touch variables that are used by the main loop
+  auto readFrame=[&](DriverFrame<real>& f) -> bool {
+    const bool skip=(framesRead%frame_npe!=frame_rank);
+    framesRead++;
+    f.skip=skip;
+    f.hasStep=false;
+    std::string & line(frameline);
+    std::vector<real> & coordinates(f.coordinates);
+    std::vector<real> & cell(f.cell);
+    if(mapped) {
+      const size_t iframe=framesRead-1;
+      if(iframe>=mapped->getNumberOfFrames()) return false;
+      mapped->read(iframe,skip,!pbc_cli_given,f.natoms,cell,coordinates);
+      if(!skip && trajectory_fmt=="xyz" && pbc_cli_given) for(unsigned i=0; i<9; i++) cell[i]=real(pbc_cli_box[i]);
+      return true;
+    }
+    int natoms=reader_natoms;
+    if(use_molfile==true) {
 #ifdef __PLUMED_HAS_MOLFILE_PLUGINS
-        int rc;
-        rc = api->read_next_timestep(h_in, natoms, &ts_in);
-        if(rc==MOLFILE_EOF) {
-          break;
+      int rc;
+// plugins do not store (and, when possible, do not parse) the frame if no timestep is passed
+      rc = api->read_next_timestep(h_in, natoms, skip?NULL:&ts_in);
+      if(rc==MOLFILE_EOF) return false;
+      if(skip) {
+        f.natoms=natoms;
+        return true;
+      }
+#endif
+    } else if(trajectory_fmt=="xyz" || trajectory_fmt=="gro") {
+      if(!Tools::getline(fp,line)) return false;
+      if(trajectory_fmt=="gro") if(!Tools::getline(fp,line)) error("premature end of trajectory file");
+      sscanf(line.c_str(),"%100d",&natoms);
+    }
+    f.natoms=natoms;
+    if(!skip) {
+      coordinates.assign(3*natoms,real(0.0));
+      cell.assign(9,real(0.0));
+    }
+    if(use_molfile) {
+#ifdef __PLUMED_HAS_MOLFILE_PLUGINS
+      if(pbc_cli_given==false) {
+        if(ts_in.A>0.0) { // this is negative if molfile does not provide box
+          // info on the cell: convert using pbcset.tcl from pbctools in vmd distribution
+          real cosBC=cos(ts_in.alpha*pi/180.);
+          //double sinBC=sin(ts_in.alpha*pi/180.);
+          real cosAC=cos(ts_in.beta*pi/180.);
+          real cosAB=cos(ts_in.gamma*pi/180.);
+          real sinAB=sin(ts_in.gamma*pi/180.);
+          real Ax=ts_in.A;
+          real Bx=ts_in.B*cosAB;
+          real By=ts_in.B*sinAB;
+          real Cx=ts_in.C*cosAC;
+          real Cy=(ts_in.C*ts_in.B*cosBC-Cx*Bx)/By;
+          real Cz=sqrt(ts_in.C*ts_in.C-Cx*Cx-Cy*Cy);
+          cell[0]=Ax/10.; cell[1]=0.; cell[2]=0.;
+          cell[3]=Bx/10.; cell[4]=By/10.; cell[5]=0.;
+          cell[6]=Cx/10.; cell[7]=Cy/10.; cell[8]=Cz/10.;
+        } else {
+          cell[0]=0.0; cell[1]=0.0; cell[2]=0.0;
+          cell[3]=0.0; cell[4]=0.0; cell[5]=0.0;
+          cell[6]=0.0; cell[7]=0.0; cell[8]=0.0;
         }
+      } else {
+        for(unsigned i=0; i<9; i++)cell[i]=pbc_cli_box[i];
+      }
+      // info on coords
+      // the order is xyzxyz...
+      for(int i=0; i<3*natoms; i++) {
+        coordinates[i]=real(ts_in.coords[i]/10.); //convert to nm
+        //cerr<<"COOR "<<coordinates[i]<<endl;
+      }
+#endif
+    } else if(trajectory_fmt=="xdr-xtc" || trajectory_fmt=="xdr-trr") {
+#ifdef __PLUMED_HAS_XDRFILE
+      int localstep;
+      float time;
+      matrix box;
+      float prec,lambda;
+      int ret=exdrOK;
+      if(trajectory_fmt=="xdr-xtc") ret=read_xtc(xd,natoms,&localstep,&time,box,xdr_pos.get(),&prec);
+      if(trajectory_fmt=="xdr-trr") ret=read_trr(xd,natoms,&localstep,&time,&lambda,box,xdr_pos.get(),NULL,NULL);
+      if(ret==exdrENDOFFILE) return false;
+      if(ret!=exdrOK) return false;
+      f.step=localstep;
+      f.hasStep=true;
+      if(skip) return true;
+      for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) cell[3*i+j]=box[i][j];
+      for(int i=0; i<natoms; i++) for(unsigned j=0; j<3; j++)
+          coordinates[3*i+j]=real(xdr_pos[i][j]);
 #endif
-      } else if(trajectory_fmt=="xyz" || trajectory_fmt=="gro") {
-        if(!Tools::getline(fp,line)) break;
+    } else {
+      if(trajectory_fmt=="xyz") {
+        if(!Tools::getline(fp,line)) error("premature end of trajectory file");
+      }
+      if(trajectory_fmt=="xyz" && !skip) {
+        std::vector<double> celld(9,0.0);
+        if(pbc_cli_given==false) {
+          std::vector<std::string> words;
+          words=Tools::getWords(line);
+          if(words.size()==3) {
+            sscanf(line.c_str(),"%100lf %100lf %100lf",&celld[0],&celld[4],&celld[8]);
+          } else if(words.size()==9) {
+            sscanf(line.c_str(),"%100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf",
+                   &celld[0], &celld[1], &celld[2],
+                   &celld[3], &celld[4], &celld[5],
+                   &celld[6], &celld[7], &celld[8]);
+          } else error("needed box in second line of xyz file");
+        } else {			// from command line
+          celld=pbc_cli_box;
+        }
+        for(unsigned i=0; i<9; i++)cell[i]=real(celld[i]);
+      }
+      int ddist=0;
+      // Read coordinates
+      for(int i=0; i<natoms; i++) {
+        bool ok=Tools::getline(fp,line);
+        if(!ok) error("premature end of trajectory file");
+        if(skip) continue;
+        double cc[3];
+        if(trajectory_fmt=="xyz") {
+          char dummy[1000];
+          int ret=std::sscanf(line.c_str(),"%999s %100lf %100lf %100lf",dummy,&cc[0],&cc[1],&cc[2]);
+          if(ret!=4) error("cannot read line"+line);
+        } else if(trajectory_fmt=="gro") {
+          // do the gromacs way
+          if(!i) {
+            //
+            // calculate the distance between dots (as in gromacs gmxlib/confio.c, routine get_w_conf )
+            //
+            const char      *p1, *p2, *p3;
+            p1 = strchr(line.c_str(), '.');
+            if (p1 == NULL) error("seems there are no coordinates in the gro file");
+            p2 = strchr(&p1[1], '.');
+            if (p2 == NULL) error("seems there is only one coordinates in the gro file");
+            ddist = p2 - p1;
+            p3 = strchr(&p2[1], '.');
+            if (p3 == NULL)error("seems there are only two coordinates in the gro file");
+            if (p3 - p2 != ddist)error("not uniform spacing in fields in the gro file");
+          }
+          Tools::convert(line.substr(20,ddist),cc[0]);
+          Tools::convert(line.substr(20+ddist,ddist),cc[1]);
+          Tools::convert(line.substr(20+ddist+ddist,ddist),cc[2]);
+        } else plumed_error();
+        coordinates[3*i]=real(cc[0]);
+        coordinates[3*i+1]=real(cc[1]);
+        coordinates[3*i+2]=real(cc[2]);
+      }
+      if(trajectory_fmt=="gro") {
+        if(!Tools::getline(fp,line)) error("premature end of trajectory file");
+        if(skip) return true;
+        std::vector<string> words=Tools::getWords(line);
+        if(words.size()<3) error("cannot understand box format");
+        Tools::convert(words[0],cell[0]);
+        Tools::convert(words[1],cell[4]);
+        Tools::convert(words[2],cell[8]);
+        if(words.size()>3) Tools::convert(words[3],cell[1]);
+        if(words.size()>4) Tools::convert(words[4],cell[2]);
+        if(words.size()>5) Tools::convert(words[5],cell[3]);
+        if(words.size()>6) Tools::convert(words[6],cell[5]);
+        if(words.size()>7) Tools::convert(words[7],cell[6]);
+        if(words.size()>8) Tools::convert(words[8],cell[7]);
       }
     }
+    return true;
+  };
 
-    bool first_step=false;
+// frames can be read in advance by a separate thread while plumed is calculating
+  std::unique_ptr<DriverPrefetcher<real> > prefetcher;
+  if(prefetch>0 && !noatoms && !parseOnly) prefetcher.reset(new DriverPrefetcher<real>(prefetch,readFrame));
+
+  while(true) {
     if(!noatoms&&!parseOnly) {
-      if(use_molfile==false && (trajectory_fmt=="xyz" || trajectory_fmt=="gro")) {
-        if(trajectory_fmt=="gro") if(!Tools::getline(fp,line)) error("premature end of trajectory file");
-        sscanf(line.c_str(),"%100d",&natoms);
+      if(prefetcher) {
+        if(!prefetcher->next(trajFrame)) break;
+      } else {
+        if(!readFrame(trajFrame)) break;
       }
+      natoms=trajFrame.natoms;
     }
+
+    bool first_step=false;
     if(checknatoms<0 && !noatoms) {
       pd_nlocal=natoms;
       pd_start=0;
@@ -669,15 +1178,21 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
       p.cmd("setNatoms",&natoms);
       p.cmd("init");
       if(parseOnly) break;
+      if(frameparallel) {
+        for(const auto & a : p.getActionSet()) if(a->isHistoryDependent())
+            error("action " + a->getLabel() + " depends on the previous frames and cannot be used with --frame-parallel");
+      }
     }
     if(checknatoms!=natoms) {
       std::string stepstr; Tools::convert(step,stepstr);
       error("number of atoms in frame " + stepstr + " does not match number of atoms in first frame");
     }
 
-    coordinates.assign(3*natoms,real(0.0));
+    if(noatoms) {
+      coordinates.assign(3*natoms,real(0.0));
+      cell.assign(9,real(0.0));
+    }
     forces.assign(3*natoms,real(0.0));
-    cell.assign(9,real(0.0));
     virial.assign(9,real(0.0));
 
     if( first_step || rnd.U01()>0.5) {
@@ -735,131 +1250,13 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 
     int plumedStopCondition=0;
     if(!noatoms) {
-      if(use_molfile) {
-#ifdef __PLUMED_HAS_MOLFILE_PLUGINS
-        if(pbc_cli_given==false) {
-          if(ts_in.A>0.0) { // this is negative if molfile does not provide box
-            // info on the cell: convert using pbcset.tcl from pbctools in vmd distribution
-            real cosBC=cos(ts_in.alpha*pi/180.);
-            //double sinBC=sin(ts_in.alpha*pi/180.);
-            real cosAC=cos(ts_in.beta*pi/180.);
-            real cosAB=cos(ts_in.gamma*pi/180.);
-            real sinAB=sin(ts_in.gamma*pi/180.);
-            real Ax=ts_in.A;
-            real Bx=ts_in.B*cosAB;
-            real By=ts_in.B*sinAB;
-            real Cx=ts_in.C*cosAC;
-            real Cy=(ts_in.C*ts_in.B*cosBC-Cx*Bx)/By;
-            real Cz=sqrt(ts_in.C*ts_in.C-Cx*Cx-Cy*Cy);
-            cell[0]=Ax/10.; cell[1]=0.; cell[2]=0.;
-            cell[3]=Bx/10.; cell[4]=By/10.; cell[5]=0.;
-            cell[6]=Cx/10.; cell[7]=Cy/10.; cell[8]=Cz/10.;
-          } else {
-            cell[0]=0.0; cell[1]=0.0; cell[2]=0.0;
-            cell[3]=0.0; cell[4]=0.0; cell[5]=0.0;
-            cell[6]=0.0; cell[7]=0.0; cell[8]=0.0;
-          }
-        } else {
-          for(unsigned i=0; i<9; i++)cell[i]=pbc_cli_box[i];
-        }
-        // info on coords
-        // the order is xyzxyz...
-        for(int i=0; i<3*natoms; i++) {
-          coordinates[i]=real(ts_in.coords[i]/10.); //convert to nm
-          //cerr<<"COOR "<<coordinates[i]<<endl;
-        }
-#endif
-      } else if(trajectory_fmt=="xdr-xtc" || trajectory_fmt=="xdr-trr") {
-#ifdef __PLUMED_HAS_XDRFILE
-        int localstep;
-        float time;
-        matrix box;
-        std::unique_ptr<rvec[]> pos(new rvec[natoms]);
-        float prec,lambda;
-        int ret=exdrOK;
-        if(trajectory_fmt=="xdr-xtc") ret=read_xtc(xd,natoms,&localstep,&time,box,pos.get(),&prec);
-        if(trajectory_fmt=="xdr-trr") ret=read_trr(xd,natoms,&localstep,&time,&lambda,box,pos.get(),NULL,NULL);
-        if(stride==0) step=localstep;
-        if(ret==exdrENDOFFILE) break;
-        if(ret!=exdrOK) break;
-        for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) cell[3*i+j]=box[i][j];
-        for(int i=0; i<natoms; i++) for(unsigned j=0; j<3; j++)
-            coordinates[3*i+j]=real(pos[i][j]);
-#endif
-      } else {
-        if(trajectory_fmt=="xyz") {
-          if(!Tools::getline(fp,line)) error("premature end of trajectory file");
-
-          std::vector<double> celld(9,0.0);
-          if(pbc_cli_given==false) {
-            std::vector<std::string> words;
-            words=Tools::getWords(line);
-            if(words.size()==3) {
-              sscanf(line.c_str(),"%100lf %100lf %100lf",&celld[0],&celld[4],&celld[8]);
-            } else if(words.size()==9) {
-              sscanf(line.c_str(),"%100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf",
-                     &celld[0], &celld[1], &celld[2],
-                     &celld[3], &celld[4], &celld[5],
-                     &celld[6], &celld[7], &celld[8]);
-            } else error("needed box in second line of xyz file");
-          } else {			// from command line
-            celld=pbc_cli_box;
-          }
-          for(unsigned i=0; i<9; i++)cell[i]=real(celld[i]);
-        }
-        int ddist=0;
-        // Read coordinates
-        for(int i=0; i<natoms; i++) {
-          bool ok=Tools::getline(fp,line);
-          if(!ok) error("premature end of trajectory file");
-          double cc[3];
-          if(trajectory_fmt=="xyz") {
-            char dummy[1000];
-            int ret=std::sscanf(line.c_str(),"%999s %100lf %100lf %100lf",dummy,&cc[0],&cc[1],&cc[2]);
-            if(ret!=4) error("cannot read line"+line);
-          } else if(trajectory_fmt=="gro") {
-            // do the gromacs way
-            if(!i) {
-              //
-              // calculate the distance between dots (as in gromacs gmxlib/confio.c, routine get_w_conf )
-              //
-              const char      *p1, *p2, *p3;
-              p1 = strchr(line.c_str(), '.');
-              if (p1 == NULL) error("seems there are no coordinates in the gro file");
-              p2 = strchr(&p1[1], '.');
-              if (p2 == NULL) error("seems there is only one coordinates in the gro file");
-              ddist = p2 - p1;
-              p3 = strchr(&p2[1], '.');
-              if (p3 == NULL)error("seems there are only two coordinates in the gro file");
-              if (p3 - p2 != ddist)error("not uniform spacing in fields in the gro file");
-            }
-            Tools::convert(line.substr(20,ddist),cc[0]);
-            Tools::convert(line.substr(20+ddist,ddist),cc[1]);
-            Tools::convert(line.substr(20+ddist+ddist,ddist),cc[2]);
-          } else plumed_error();
-          if(!debug_pd || ( i>=pd_start && i<pd_start+pd_nlocal) ) {
-            coordinates[3*i]=real(cc[0]);
-            coordinates[3*i+1]=real(cc[1]);
-            coordinates[3*i+2]=real(cc[2]);
-          }
-        }
-        if(trajectory_fmt=="gro") {
-          if(!Tools::getline(fp,line)) error("premature end of trajectory file");
-          std::vector<string> words=Tools::getWords(line);
-          if(words.size()<3) error("cannot understand box format");
-          Tools::convert(words[0],cell[0]);
-          Tools::convert(words[1],cell[4]);
-          Tools::convert(words[2],cell[8]);
-          if(words.size()>3) Tools::convert(words[3],cell[1]);
-          if(words.size()>4) Tools::convert(words[4],cell[2]);
-          if(words.size()>5) Tools::convert(words[5],cell[3]);
-          if(words.size()>6) Tools::convert(words[6],cell[5]);
-          if(words.size()>7) Tools::convert(words[7],cell[6]);
-          if(words.size()>8) Tools::convert(words[8],cell[7]);
-        }
-
+      if(trajFrame.hasStep && stride==0) step=trajFrame.step;
+      if(trajFrame.skip) {
+        step+=stride;
+        continue;
       }
 
+
       p.cmd("setStepLong",&step);
       p.cmd("setStopFlag",&plumedStopCondition);
 
@@ -968,8 +1365,18 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 
     step+=stride;
   }
+// the reader thread is stopped before closing the files it might be reading
+  prefetcher.reset();
   p.cmd("runFinalJobs");
 
+  std::vector<std::string> outputFiles;
+  if(frameparallel) {
+    for(const auto & f : p.getFiles()) if(dynamic_cast<OFile*>(f)) outputFiles.push_back(f->getPath());
+  }
+// this closes all the files
+  pp.reset();
+  if(frameparallel) mergeFrameParallelFiles(outputFiles,pc,out);
+
   if(fp_forces) fclose(fp_forces);
   if(debugforces.length()>0) fp_dforces.close();
   if(fp && fp!=in)fclose(fp);
@@ -984,6 +1391,73 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
   return 0;
 }
 
+template<typename real>
+void Driver<real>::mergeFrameParallelFiles( const std::vector<std::string>& files, Communicator& pc, FILE* out ) {
+  pc.Barrier();
+  if(pc.Get_rank()!=0) return;
+  const int npe=pc.Get_size();
+  const std::string suffix0=".0";
+  std::set<std::string> done;
+  for(const auto & f : files) {
+// remove the suffix of process zero to find the name requested in the input
+    std::string::size_type pos=f.rfind(suffix0);
+    if(pos==std::string::npos) continue;
+    std::string name=f.substr(0,pos)+f.substr(pos+suffix0.length());
+    if(!done.insert(name).second) continue;
+    std::vector<std::unique_ptr<IFile> > ifiles;
+    std::vector<std::string> paths;
+    for(int i=0; i<npe; i++) {
+      string n; Tools::convert(i,n);
+      paths.push_back(FileBase::appendSuffix(name,"."+n));
+      ifiles.emplace_back(new IFile);
+      if(ifiles[i]->FileExist(paths[i])) ifiles[i]->open(paths[i]);
+      else ifiles[i].reset();
+    }
+    if(!ifiles[0]) continue;
+// files are merged using the time in the first field
+    std::string line;
+    std::vector<std::string> header;
+    std::vector<std::string> current(npe);
+    std::vector<double> time(npe);
+    std::vector<bool> active(npe,false);
+    auto setCurrent=[&](int i) {
+      current[i]=line;
+      std::vector<std::string> words=Tools::getWords(line);
+      active[i]=(words.size()>0 && Tools::convert(words[0],time[i]));
+    };
+    auto advance=[&](int i) {
+      active[i]=false;
+      while(ifiles[i]->getline(line)) if(line.compare(0,2,"#!")!=0) { setCurrent(i); break; }
+    };
+    while(ifiles[0]->getline(line)) {
+      if(line.compare(0,2,"#!")!=0) { setCurrent(0); break; }
+      header.push_back(line);
+    }
+    std::vector<std::string> words;
+    if(header.size()>0) words=Tools::getWords(header[0]);
+    if(words.size()<3 || words[1]!="FIELDS" || words[2]!="time") {
+      fprintf(out,"DRIVER: file %s cannot be merged since its first field is not the time, frames are left in files %s etc\n",name.c_str(),paths[0].c_str());
+      continue;
+    }
+    for(int i=1; i<npe; i++) if(ifiles[i]) advance(i);
+    OFile of;
+    of.open(name);
+    for(const auto & h : header) of.printf("%s\n",h.c_str());
+    while(true) {
+      int next=-1;
+      for(int i=0; i<npe; i++) if(active[i] && (next<0 || time[i]<time[next])) next=i;
+      if(next<0) break;
+      of.printf("%s\n",current[next].c_str());
+      advance(next);
+    }
+    of.close();
+    for(int i=0; i<npe; i++) if(ifiles[i]) {
+        ifiles[i]->close();
+        std::remove(paths[i].c_str());
+      }
+  }
+}
+
 template<typename real>
 void Driver<real>::evaluateNumericalDerivatives( const long int& step, PlumedMain& p, const std::vector<real>& coordinates,
     const std::vector<real>& masses, const std::vector<real>& charges,
@@ -125,6 +125,7 @@ Angle::Angle(const ActionOptions&ao):
   addValueWithDerivatives(); setNotPeriodic();
   requestAtoms(atoms);
   checkRead();
+  allowPartialAtoms();
 }
 
 // calculator
@@ -50,6 +50,11 @@ but it can be changed using the optional SWITCH option.
 
 To make your calculation faster you can use a neighbor list, which makes it that only a
 relevant subset of the pairwise distance are calculated at every step.
+When periodic boundary conditions are used the neighbor list is rebuilt using link cells,
+so that the cost of each rebuild grows linearly with the number of atoms.
+A Verlet skin can be added with NL_SKIN: in this case the list includes all the pairs closer
+than NL_CUTOFF+NL_SKIN and, every NL_STRIDE steps, it is rebuilt only if one of the atoms
+moved by more than half the skin since the last rebuild.
 
 If GROUPB is empty, it will sum the \f$\frac{N(N-1)}{2}\f$ pairs in GROUPA. This avoids computing
 twice permuted indexes (e.g. pair (i,j) and (j,i)) thus running at twice the speed.
@@ -66,6 +71,13 @@ The following example instructs plumed to calculate the total coordination numbe
 COORDINATION GROUPA=1-10 GROUPB=20-100 R_0=0.3 NLIST NL_CUTOFF=0.5 NL_STRIDE=100
 \endplumedfile
 
+The following example uses a neighbor list with a Verlet skin. All the atoms are requested at every step,
+but the list is only rebuilt when one of the atoms has moved by more than 0.05 nm.
+
+\plumedfile
+COORDINATION GROUPA=1-10 GROUPB=20-100 R_0=0.3 NLIST NL_CUTOFF=0.5 NL_STRIDE=1 NL_SKIN=0.1
+\endplumedfile
+
 The following is a dummy example which should compute the value 0 because the self interaction
 of atom 1 is skipped. Notice that in plumed 2.0 "self interactions" were not skipped, and the
 same calculation should return 1.
@@ -104,6 +116,7 @@ public:
 // active methods:
   static void registerKeywords( Keywords& keys );
   virtual double pairing(double distance,double&dfunc,unsigned i,unsigned j)const;
+  virtual void pairingBlock(unsigned n,const double*distance2,double*value,double*dfunc,const unsigned*i,const unsigned*j)const;
 };
 
 PLUMED_REGISTER_ACTION(Coordination,"COORDINATION")
@@ -153,6 +166,12 @@ double Coordination::pairing(double distance,double&dfunc,unsigned i,unsigned j)
   return switchingFunction.calculateSqr(distance,dfunc);
 }
 
+void Coordination::pairingBlock(unsigned n,const double*distance2,double*value,double*dfunc,const unsigned*i,const unsigned*j)const {
+  (void) i; // avoid warnings
+  (void) j; // avoid warnings
+  switchingFunction.calculateSqr(n,distance2,value,dfunc);
+}
+
 }
 
 }
@@ -25,6 +25,7 @@
 #include "tools/OpenMP.h"
 
 #include <string>
+#include <algorithm>
 
 using namespace std;
 
@@ -38,6 +39,9 @@ void CoordinationBase::registerKeywords( Keywords& keys ) {
   keys.addFlag("NLIST",false,"Use a neighbor list to speed up the calculation");
   keys.add("optional","NL_CUTOFF","The cutoff for the neighbor list");
   keys.add("optional","NL_STRIDE","The frequency with which we are updating the atoms in the neighbor list");
+  keys.add("optional","NL_SKIN","The Verlet skin of the neighbor list. If present, the list is built with a cutoff NL_CUTOFF+NL_SKIN and, "
+           "every NL_STRIDE steps, it is rebuilt only if one of the atoms moved by more than half the skin since the last rebuild. "
+           "Pairs further than NL_CUTOFF are discarded at every step, so that the skin does not change the result");
   keys.add("atoms","GROUPA","First list of atoms");
   keys.add("atoms","GROUPB","Second list of atoms (if empty, N*(N-1)/2 pairs in GROUPA are counted)");
 }
@@ -47,7 +51,8 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
   pbc(true),
   serial(false),
   invalidateList(true),
-  firsttime(true)
+  firsttime(true),
+  nl_cut2(-1.0)
 {
 
   parseFlag("SERIAL",serial);
@@ -67,6 +72,7 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
 // neighbor list stuff
   bool doneigh=false;
   double nl_cut=0.0;
+  double nl_skin=0.0;
   int nl_st=0;
   parseFlag("NLIST",doneigh);
   if(doneigh) {
@@ -74,18 +80,22 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
     if(nl_cut<=0.0) error("NL_CUTOFF should be explicitly specified and positive");
     parse("NL_STRIDE",nl_st);
     if(nl_st<=0) error("NL_STRIDE should be explicitly specified and positive");
+    parse("NL_SKIN",nl_skin);
+    if(nl_skin<0.0) error("NL_SKIN should be positive");
+    if(nl_skin>0.0) nl_cut2=nl_cut*nl_cut;
   }
 
   addValueWithDerivatives(); setNotPeriodic();
   if(gb_lista.size()>0) {
-    if(doneigh)  nl.reset( new NeighborList(ga_lista,gb_lista,dopair,pbc,getPbc(),nl_cut,nl_st) );
+    if(doneigh)  nl.reset( new NeighborList(ga_lista,gb_lista,dopair,pbc,getPbc(),nl_cut,nl_st,nl_skin) );
     else         nl.reset( new NeighborList(ga_lista,gb_lista,dopair,pbc,getPbc()) );
   } else {
-    if(doneigh)  nl.reset( new NeighborList(ga_lista,pbc,getPbc(),nl_cut,nl_st) );
+    if(doneigh)  nl.reset( new NeighborList(ga_lista,pbc,getPbc(),nl_cut,nl_st,nl_skin) );
     else         nl.reset( new NeighborList(ga_lista,pbc,getPbc()) );
   }
 
   requestAtoms(nl->getFullAtomList());
+  if(serial && !doneigh) allowPartialAtoms();
 
   log.printf("  between two groups of %u and %u atoms\n",static_cast<unsigned>(ga_lista.size()),static_cast<unsigned>(gb_lista.size()));
   log.printf("  first group:\n");
@@ -105,6 +115,7 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
   if(doneigh) {
     log.printf("  using neighbor lists with\n");
     log.printf("  update every %d steps and cutoff %f\n",nl_st,nl_cut);
+    if(nl_skin>0.0) log.printf("  rebuilt only when an atom moves by more than half the skin %f\n",nl_skin);
   }
 }
 
@@ -112,6 +123,10 @@ CoordinationBase::~CoordinationBase() {
 // destructor required to delete forward declared class
 }
 
+bool CoordinationBase::isHistoryDependent()const {
+  return nl->getStride()>1;
+}
+
 void CoordinationBase::prepare() {
   if(nl->getStride()>0) {
     if(firsttime || (getStep()%nl->getStride()==0)) {
@@ -127,14 +142,18 @@ void CoordinationBase::prepare() {
   }
 }
 
+void CoordinationBase::pairingBlock(unsigned n,const double*distance2,double*value,double*dfunc,const unsigned*i,const unsigned*j)const {
+  for(unsigned k=0; k<n; ++k) value[k]=pairing(distance2[k],dfunc[k],i[k],j[k]);
+}
+
 // calculator
 void CoordinationBase::calculate()
 {
 
   double ncoord=0.;
   Tensor virial;
-  vector<Vector> deriv(getNumberOfAtoms());
-// deriv.resize(getPositions().size());
+  const unsigned natoms=getNumberOfAtoms();
+  deriv.assign(natoms,Vector());
 
   if(nl->getStride()>0 && invalidateList) {
     nl->update(getPositions());
@@ -154,48 +173,83 @@ void CoordinationBase::calculate()
   const unsigned nn=nl->size();
   if(nt*stride*10>nn) nt=1;
 
-  #pragma omp parallel num_threads(nt)
-  {
-    std::vector<Vector> omp_deriv(getPositions().size());
-    Tensor omp_virial;
-
-    #pragma omp for reduction(+:ncoord) nowait
-    for(unsigned int i=rank; i<nn; i+=stride) {
-
-      Vector distance;
-      unsigned i0=nl->getClosePair(i).first;
-      unsigned i1=nl->getClosePair(i).second;
+  if(nt>1 && omp_deriv.size()<nt) omp_deriv.resize(nt);
+  omp_virial.assign(nt,Tensor());
 
-      if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
+// this rank takes care of pairs rank, rank+stride, rank+2*stride, ...
+// they are processed in blocks of blocksize pairs
+  const unsigned blocksize=256;
+  const unsigned nmine=(nn>rank ? (nn-rank+stride-1)/stride : 0);
+  const unsigned nblocks=(nmine+blocksize-1)/blocksize;
+  const vector<pair<unsigned,unsigned> > & pairs(nl->getClosePairs());
 
-      if(pbc) {
-        distance=pbcDistance(getPosition(i0),getPosition(i1));
-      } else {
-        distance=delta(getPosition(i0),getPosition(i1));
+  #pragma omp parallel num_threads(nt)
+  {
+    const unsigned t=OpenMP::getThreadNum();
+// buffers are cleared by whichever threads are available, since the team
+// can be smaller than requested (e.g. when nested in another parallel region)
+    if(nt>1) {
+      #pragma omp for
+      for(unsigned j=0; j<nt; j++) omp_deriv[j].assign(natoms,Vector());
+    }
+    vector<Vector> & myderiv(nt>1 ? omp_deriv[t] : deriv);
+    Tensor myvirial;
+
+// the block is stored as a structure of arrays
+    unsigned i0[blocksize],i1[blocksize];
+    double dx[blocksize],dy[blocksize],dz[blocksize];
+    double d2[blocksize],value[blocksize],dfunc[blocksize];
+
+    #pragma omp for reduction(+:ncoord)
+    for(unsigned b=0; b<nblocks; b++) {
+      const unsigned kend=std::min(nmine,(b+1)*blocksize);
+      unsigned n=0;
+      for(unsigned k=b*blocksize; k<kend; k++) {
+        const pair<unsigned,unsigned> & p(pairs[rank+k*stride]);
+
+        if(getAbsoluteIndex(p.first)==getAbsoluteIndex(p.second)) continue;
+
+        Vector distance;
+        if(pbc) {
+          distance=pbcDistance(getPosition(p.first),getPosition(p.second));
+        } else {
+          distance=delta(getPosition(p.first),getPosition(p.second));
+        }
+        const double dist2=distance.modulo2();
+// with a skin the list also contains pairs beyond the cutoff, which are skipped
+// so that the value does not depend on the skin
+        if(nl_cut2>0.0 && dist2>nl_cut2) continue;
+        i0[n]=p.first;
+        i1[n]=p.second;
+        dx[n]=distance[0];
+        dy[n]=distance[1];
+        dz[n]=distance[2];
+        d2[n]=dist2;
+        n++;
       }
 
-      double dfunc=0.;
-      ncoord += pairing(distance.modulo2(), dfunc,i0,i1);
-
-      Vector dd(dfunc*distance);
-      Tensor vv(dd,distance);
-      if(nt>1) {
-        omp_deriv[i0]-=dd;
-        omp_deriv[i1]+=dd;
-        omp_virial-=vv;
-      } else {
-        deriv[i0]-=dd;
-        deriv[i1]+=dd;
-        virial-=vv;
-      }
+      pairingBlock(n,d2,value,dfunc,i0,i1);
 
+      for(unsigned k=0; k<n; k++) {
+        ncoord += value[k];
+        Vector distance(dx[k],dy[k],dz[k]);
+        Vector dd(dfunc[k]*distance);
+        myderiv[i0[k]]-=dd;
+        myderiv[i1[k]]+=dd;
+        myvirial-=Tensor(dd,distance);
+      }
     }
-    #pragma omp critical
+    omp_virial[t]=myvirial;
+
+// reduction of thread-private derivatives, each thread takes care of a subset of the atoms
     if(nt>1) {
-      for(unsigned i=0; i<getPositions().size(); i++) deriv[i]+=omp_deriv[i];
-      virial+=omp_virial;
+      #pragma omp for
+      for(unsigned i=0; i<natoms; i++) {
+        for(unsigned j=0; j<nt; j++) deriv[i]+=omp_deriv[j][i];
+      }
     }
   }
+  for(unsigned j=0; j<nt; j++) virial+=omp_virial[j];
 
   if(!serial) {
     comm.Sum(ncoord);
@@ -23,6 +23,7 @@
 #define __PLUMED_colvar_CoordinationBase_h
 #include "Colvar.h"
 #include <memory>
+#include <vector>
 
 namespace PLMD {
 
@@ -36,6 +37,14 @@ class CoordinationBase : public Colvar {
   std::unique_ptr<NeighborList> nl;
   bool invalidateList;
   bool firsttime;
+/// Square of NL_CUTOFF, used to discard pairs of the list that are in the skin (negative without a skin)
+  double nl_cut2;
+/// Derivatives, kept across steps to avoid reallocations
+  std::vector<Vector> deriv;
+/// Thread-private derivatives, kept across steps to avoid reallocations
+  std::vector<std::vector<Vector> > omp_deriv;
+/// Thread-private virials
+  std::vector<Tensor> omp_virial;
 
 public:
   explicit CoordinationBase(const ActionOptions&);
@@ -44,6 +53,12 @@ public:
   virtual void calculate();
   virtual void prepare();
   virtual double pairing(double distance,double&dfunc,unsigned i,unsigned j)const=0;
+/// Compute the pairing function for a block of n pairs of atoms i[k],j[k].
+/// The default implementation calls pairing() for each pair,
+/// derived classes can override it with a vectorizable kernel.
+  virtual void pairingBlock(unsigned n,const double*distance2,double*value,double*dfunc,const unsigned*i,const unsigned*j)const;
+/// A neighbor list that is not updated at every step depends on the previous steps
+  bool isHistoryDependent()const override;
   static void registerKeywords( Keywords& keys );
 };
 
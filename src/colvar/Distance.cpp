@@ -151,6 +151,7 @@ Distance::Distance(const ActionOptions&ao):
   parseFlag("NOPBC",nopbc);
   pbc=!nopbc;
   checkRead();
+  allowPartialAtoms();
 
   log.printf("  between atoms %d %d\n",atoms[0].serial(),atoms[1].serial());
   if(pbc) log.printf("  using periodic boundary conditions\n");
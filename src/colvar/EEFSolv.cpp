@@ -28,6 +28,9 @@
 #include "core/PlumedMain.h"
 #include "core/SetupMolInfo.h"
 #include "tools/OpenMP.h"
+#include "tools/Communicator.h"
+#include "tools/LinkCells.h"
+#include <algorithm>
 #include <initializer_list>
 
 #define INV_PI_SQRT_PI 0.179587122
@@ -84,8 +87,12 @@ private:
   double delta_g_ref;
   unsigned stride;
   unsigned nl_update;
-  vector<vector<unsigned> > nl;
-  vector<vector<bool> > nlexpo;
+/// The neighbors of atom i are in nl[nl_start[i]] to nl[nl_start[i+1]-1]
+  vector<unsigned> nl_start;
+/// Each neighbor j is stored as 2*j, plus one if the two atoms have the same parameters
+  vector<unsigned> nl;
+  Communicator serialcomm;
+  LinkCells linkcells;
   vector<vector<double> > parameter;
   void setupConstants(const vector<AtomNumber> &atoms, vector<vector<double> > &parameter, bool tcorr);
   map<string, map<string, string> > setupTypeMap();
@@ -96,6 +103,7 @@ public:
   static void registerKeywords(Keywords& keys);
   explicit EEFSolv(const ActionOptions&);
   virtual void calculate();
+  bool isHistoryDependent()const override {return stride>1;}
 };
 
 PLUMED_REGISTER_ACTION(EEFSolv,"EEFSOLV")
@@ -116,7 +124,8 @@ EEFSolv::EEFSolv(const ActionOptions&ao):
   buffer(0.1),
   delta_g_ref(0.),
   stride(10),
-  nl_update(0)
+  nl_update(0),
+  linkcells(serialcomm)
 {
   vector<AtomNumber> atoms;
   parseAtomList("ATOMS", atoms);
@@ -135,8 +144,6 @@ EEFSolv::EEFSolv(const ActionOptions&ao):
   log << "  Bibliography " << plumed.cite("Lazaridis T, Karplus M, Proteins Struct. Funct. Genet. 35, 133 (1999)"); log << "\n";
 
 
-  nl.resize(size);
-  nlexpo.resize(size);
   parameter.resize(size, vector<double>(4, 0));
   setupConstants(atoms, parameter, tcorr);
 
@@ -148,30 +155,68 @@ EEFSolv::EEFSolv(const ActionOptions&ao):
 void EEFSolv::update_neighb() {
   const double lower_c2 = 0.24 * 0.24; // this is the cut-off for bonded atoms
   const unsigned size = getNumberOfAtoms();
-  for (unsigned i=0; i<size; ++i) {
-    nl[i].clear();
-    nlexpo[i].clear();
-    const Vector posi = getPosition(i);
-    // Loop through neighboring atoms, add the ones below cutoff
-    for (unsigned j=i+1; j<size; ++j) {
-      const double d2 = delta(posi, getPosition(j)).modulo2();
-      if (d2 < lower_c2 && j < i+14) {
-        // crude approximation for i-i+1/2 interactions,
-        // we want to exclude atoms separated by less than three bonds
-        continue;
-      }
-      // We choose the maximum lambda value and use a more conservative cutoff
-      double mlambda = 1./parameter[i][2];
-      if (1./parameter[j][2] > mlambda) mlambda = 1./parameter[j][2];
-      const double c2 = (4. * mlambda + buffer) * (4. * mlambda + buffer);
-      if (d2 < c2 ) {
-        nl[i].push_back(j);
-        if(parameter[i][2] == parameter[j][2] && parameter[i][3] == parameter[j][3]) {
-          nlexpo[i].push_back(true);
-        } else nlexpo[i].push_back(false);
+  // The cells are as large as the cutoff for the atoms with the largest lambda
+  double mlambda_max = 0.;
+  for (unsigned i=0; i<size; ++i) mlambda_max = std::max(mlambda_max, 1./parameter[i][2]);
+  vector<unsigned> indices(size);
+  for (unsigned i=0; i<size; ++i) indices[i] = i;
+  linkcells.setCutoff(4. * mlambda_max + buffer);
+  linkcells.buildCellListsWithoutPbc(getPositions(), indices);
+
+  // The atoms are divided among processes and threads, and each thread keeps its neighbors in a separate list
+  const unsigned nrank = comm.Get_size();
+  const unsigned rank = comm.Get_rank();
+  unsigned nt = OpenMP::getNumThreads();
+  if(nt*nrank*10>size) nt=1;
+  vector<vector<unsigned> > thread_nl(nt);
+  vector<unsigned> nneigh(size, 0), thread_of(size), offset_of(size);
+  #pragma omp parallel num_threads(nt)
+  {
+    const unsigned tid = OpenMP::getThreadNum();
+    vector<unsigned> & mynl = thread_nl[tid];
+    vector<unsigned> cells_required, atoms(size+1);
+    #pragma omp for schedule(dynamic,64)
+    for (unsigned i=rank; i<size; i+=nrank) {
+      thread_of[i] = tid;
+      offset_of[i] = mynl.size();
+      const Vector posi = getPosition(i);
+      unsigned natomsper=1; atoms[0]=i;
+      linkcells.retrieveNeighboringAtoms(posi, cells_required, natomsper, atoms);
+      // Loop through neighboring atoms, add the ones below cutoff
+      for (unsigned k=1; k<natomsper; ++k) {
+        const unsigned j = atoms[k];
+        if (j < i) continue;
+        const double d2 = delta(posi, getPosition(j)).modulo2();
+        if (d2 < lower_c2 && j < i+14) {
+          // crude approximation for i-i+1/2 interactions,
+          // we want to exclude atoms separated by less than three bonds
+          continue;
+        }
+        // We choose the maximum lambda value and use a more conservative cutoff
+        double mlambda = 1./parameter[i][2];
+        if (1./parameter[j][2] > mlambda) mlambda = 1./parameter[j][2];
+        const double c2 = (4. * mlambda + buffer) * (4. * mlambda + buffer);
+        if (d2 < c2 ) {
+          const bool same = parameter[i][2] == parameter[j][2] && parameter[i][3] == parameter[j][3];
+          mynl.push_back(2*j + (same ? 1 : 0));
+        }
       }
+      // Neighbors are kept in the order of the all-pairs search
+      std::sort(mynl.begin()+offset_of[i], mynl.end());
+      nneigh[i] = mynl.size() - offset_of[i];
     }
   }
+  comm.Sum(nneigh);
+
+  // And then they are copied into a single list
+  nl_start.resize(size+1); nl_start[0]=0;
+  for (unsigned i=0; i<size; ++i) nl_start[i+1] = nl_start[i] + nneigh[i];
+  nl.assign(nl_start[size], 0);
+  #pragma omp parallel for num_threads(nt)
+  for (unsigned i=rank; i<size; i+=nrank) {
+    std::copy(thread_nl[thread_of[i]].begin()+offset_of[i], thread_nl[thread_of[i]].begin()+offset_of[i]+nneigh[i], nl.begin()+nl_start[i]);
+  }
+  comm.Sum(nl);
 }
 
 void EEFSolv::calculate() {
@@ -185,8 +230,7 @@ void EEFSolv::calculate() {
   double bias = 0.0;
   Tensor deriv_box;
   unsigned nt=OpenMP::getNumThreads();
-  const unsigned nn=nl.size();
-  if(nt*10>nn) nt=1;
+  if(nt*10>size) nt=1;
   #pragma omp parallel num_threads(nt)
   {
     vector<Vector> deriv_omp(size);
@@ -201,8 +245,8 @@ void EEFSolv::calculate() {
       const double vdw_radius_i   = parameter[i][3];
 
       // The pairwise interactions are unsymmetric, but we can get away with calculating the distance only once
-      for (unsigned i_nl=0; i_nl<nl[i].size(); ++i_nl) {
-        const unsigned j = nl[i][i_nl];
+      for (unsigned i_nl=nl_start[i]; i_nl<nl_start[i+1]; ++i_nl) {
+        const unsigned j = nl[i_nl] >> 1;
         const double vdw_volume_j   = parameter[j][0];
         const double delta_g_free_j = parameter[j][1];
         const double inv_lambda_j   = parameter[j][2];
@@ -217,7 +261,7 @@ void EEFSolv::calculate() {
         double deriv = 0.;
 
         // in this case we can calculate a single exponential
-        if(!nlexpo[i][i_nl]) {
+        if(!(nl[i_nl] & 1)) {
           // i-j interaction
           if(inv_rij > 0.25*inv_lambda_i)
           {
@@ -179,6 +179,7 @@ RMSD::RMSD(const ActionOptions&ao):
   parseFlag("NOPBC",nopbc);
 
   checkRead();
+  allowPartialAtoms();
 
 
   addValueWithDerivatives(); setNotPeriodic();
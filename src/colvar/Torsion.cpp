@@ -129,6 +129,7 @@ Torsion::Torsion(const ActionOptions&ao):
   parseFlag("NOPBC",nopbc);
   pbc=!nopbc;
   checkRead();
+  allowPartialAtoms();
 
   if(atoms.size()==4) {
     if(!(v1.empty() && v2.empty() && axis.empty()))
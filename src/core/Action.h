@@ -262,6 +262,10 @@ public:
 /// Check if the action needs gradient
   virtual bool checkNeedsGradients()const {return false;}
 
+/// Check if the action accumulates information from the previous steps,
+/// so that the frames of a trajectory cannot be analysed independently
+  virtual bool isHistoryDependent()const {return false;}
+
 /// Perform calculation using numerical derivatives
 /// N.B. only pass an ActionWithValue to this routine if you know exactly what you
 /// are doing.
@@ -47,6 +47,9 @@ ActionAtomistic::ActionAtomistic(const ActionOptions&ao):
   lockRequestAtoms(false),
   donotretrieve(false),
   donotforce(false),
+  partialatoms(false),
+  hasvirtualatoms(false),
+  atomsowner(-1),
   atoms(plumed.getAtoms())
 {
   atoms.add(this);
@@ -69,9 +72,13 @@ void ActionAtomistic::requestAtoms(const vector<AtomNumber> & a, const bool clea
   int n=atoms.positions.size();
   if(clearDep) clearDependencies();
   unique.clear();
+  hasvirtualatoms=false;
   for(unsigned i=0; i<indexes.size(); i++) {
     if(indexes[i].index()>=n) error("atom out of range");
-    if(atoms.isVirtualAtom(indexes[i])) addDependency(atoms.getVirtualAtomsAction(indexes[i]));
+    if(atoms.isVirtualAtom(indexes[i])) {
+      addDependency(atoms.getVirtualAtomsAction(indexes[i]));
+      hasvirtualatoms=true;
+    }
 // only real atoms are requested to lower level Atoms class
     else unique.insert(indexes[i]);
   }
@@ -255,8 +262,19 @@ void ActionAtomistic::setForcesOnAtoms( const std::vector<double>& forcesToApply
   plumed_dbg_assert( ind+1==forcesToApply.size());
 }
 
+bool ActionAtomistic::isAtomsOwner()const {
+  return atomsowner<0 || atomsowner==atoms.dd.Get_rank();
+}
+
 void ActionAtomistic::applyForces() {
   if(donotforce) return;
+  if(atomsowner>=0) {
+// forces are accumulated separately and sent back to the processes owning the atoms
+    if(atomsowner!=atoms.dd.Get_rank()) return;
+    for(unsigned j=0; j<indexes.size(); j++) atoms.partialForces[indexes[j].index()]+=forces[j];
+    atoms.partialVirial+=virial;
+    return;
+  }
   vector<Vector>   & f(atoms.forces);
   Tensor           & v(atoms.virial);
   for(unsigned j=0; j<indexes.size(); j++) f[indexes[j].index()]+=forces[j];
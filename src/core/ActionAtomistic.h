@@ -68,12 +68,28 @@ class ActionAtomistic :
   bool                  donotretrieve;
   bool                  donotforce;
 
+/// this action can be calculated by a process that only has its own atoms
+  bool                  partialatoms;
+/// this action requested virtual atoms
+  bool                  hasvirtualatoms;
+/// the process calculating this action when atoms are only sent where needed,
+/// -1 if the action is calculated by all processes
+  int                   atomsowner;
+
 protected:
   Atoms&                atoms;
 
   void setExtraCV(const std::string &name);
+/// Declare that this action only needs its own atoms and does not communicate in calculate().
+/// With domain decomposition and PLUMED_PARTIAL_SHARE=yes it is then calculated by
+/// a single process, which is the only one receiving its atoms.
+  void allowPartialAtoms() {partialatoms=true;}
 
 public:
+/// Force this action to be calculated by all processes.
+/// Used by actions reading the derivatives of this action, which are not broadcast
+/// by the process calculating it.
+  void forbidPartialAtoms() {partialatoms=false;}
 /// Request an array of atoms.
 /// This method is used to ask for a list of atoms. Atoms
 /// should be asked for by number. If this routine is called
@@ -189,6 +205,17 @@ public:
   void unlockRequests() override;
   const std::set<AtomNumber> & getUnique()const;
   const std::set<AtomNumber> & getUniqueLocal()const;
+/// Check if this action can be calculated by a single process.
+/// Actions whose gradients are needed (e.g. by METAD with ADAPTIVE=GEOM) are calculated by all processes.
+  bool canUsePartialAtoms()const {return partialatoms && !hasvirtualatoms && extraCV.empty() && !isOptionOn("GRADIENTS");}
+/// Set the process calculating this action, -1 means all processes
+  void setAtomsOwner(int owner) {atomsowner=owner;}
+/// Check if this action is calculated by a single process
+  bool usesPartialAtoms()const {return atomsowner>=0;}
+/// Get the process calculating this action (only if usesPartialAtoms())
+  int getAtomsOwner()const {return atomsowner;}
+/// Check if this action should be calculated by this process
+  bool isAtomsOwner()const;
 /// Read in an input file containing atom positions and calculate the action for the atomic
 /// configuration therin
   void readAtomsFromPDB( const PDB& pdb ) override;
@@ -64,6 +64,7 @@ Atoms::Atoms(PlumedMain&plumed):
   kbT(0.0),
   asyncSent(false),
   atomsNeeded(false),
+  partialActive(false),
   ddStep(0)
 {
 }
@@ -139,6 +140,7 @@ void Atoms::share() {
 // At first step I scatter all the atoms so as to store their mass and charge
 // Notice that this works with the assumption that charges and masses are
 // not changing during the simulation!
+  setupPartialAtoms();
   if(!massAndChargeOK && shareMassAndChargeOnlyAtFirstStep) {
     shareAll();
     return;
@@ -165,7 +167,7 @@ void Atoms::share() {
 
   }
 
-  share(unique);
+  share(unique,partialActive);
 }
 
 void Atoms::shareAll() {
@@ -180,7 +182,7 @@ void Atoms::shareAll() {
   share(unique);
 }
 
-void Atoms::share(const std::set<AtomNumber>& unique) {
+void Atoms::share(const std::set<AtomNumber>& unique,bool partial) {
   plumed_assert( positionsHaveBeenSet==3 && massesHaveBeenSet );
 
   virial.zero();
@@ -189,6 +191,12 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
   } else {
     for(const auto & p : unique) forces[p.index()].zero();
   }
+  if(partialActive) {
+    partialVirial.zero();
+    for(const auto & a : actions) if(a->isActive() && a->usesPartialAtoms() && a->isAtomsOwner()) {
+        for(const auto & p : a->getUnique()) partialForces[p.index()].zero();
+      }
+  }
   for(unsigned i=getNatoms(); i<positions.size(); i++) forces[i].zero(); // virtual atoms
   forceOnEnergy=0.0;
   mdatoms->getBox(box);
@@ -219,7 +227,9 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
     mdatoms->getMasses(gatindex,masses);
   }
 
-  if(dd && shuffledAtoms>0) {
+  if(dd && shuffledAtoms>0 && partial) {
+    sharePartial(ndata);
+  } else if(dd && shuffledAtoms>0) {
     if(dd.async) {
       for(unsigned i=0; i<dd.mpi_request_positions.size(); i++) dd.mpi_request_positions[i].wait();
       for(unsigned i=0; i<dd.mpi_request_index.size(); i++)     dd.mpi_request_index[i].wait();
@@ -258,6 +268,9 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
       dd.Allgatherv(&dd.indexToBeSent[0],count,&dd.indexToBeReceived[0],&counts[0],&displ[0]);
       dd.Allgatherv(&dd.positionsToBeSent[0],ndata*count,&dd.positionsToBeReceived[0],&counts5[0],&displ5[0]);
       int tot=displ[n-1]+counts[n-1];
+      if(partialActive) {
+        for(int r=0; r<n; r++) for(int i=displ[r]; i<displ[r]+counts[r]; i++) dd.homeRank[dd.indexToBeReceived[i]]=r;
+      }
       for(int i=0; i<tot; i++) {
         positions[dd.indexToBeReceived[i]][0]=dd.positionsToBeReceived[ndata*i+0];
         positions[dd.indexToBeReceived[i]][1]=dd.positionsToBeReceived[ndata*i+1];
@@ -293,6 +306,7 @@ void Atoms::wait() {
         dd.Recv(&dd.indexToBeReceived[count],dd.indexToBeReceived.size()-count,i,666,status);
         int c=status.Get_count<int>();
         dd.Recv(&dd.positionsToBeReceived[ndata*count],dd.positionsToBeReceived.size()-ndata*count,i,667);
+        if(partialActive) for(int j=count; j<count+c; j++) dd.homeRank[dd.indexToBeReceived[j]]=i;
         count+=c;
       }
       for(int i=0; i<count; i++) {
@@ -315,6 +329,7 @@ void Atoms::wait() {
 
 void Atoms::updateForces() {
   plumed_assert( forcesHaveBeenSet==3 );
+  if(partialActive) updatePartialForces();
   if(forceOnEnergy*forceOnEnergy>epsilon) {
     double alpha=1.0-forceOnEnergy;
     mdatoms->rescaleForces(gatindex,alpha);
@@ -329,10 +344,118 @@ void Atoms::updateForces() {
   }
 }
 
+void Atoms::setupPartialAtoms() {
+  int k=0;
+  const bool enabled=dd && dd.partial && shuffledAtoms>0;
+  for(const auto & a : actions) {
+    if(enabled && a->canUsePartialAtoms()) a->setAtomsOwner((k++)%dd.Get_size());
+    else a->setAtomsOwner(-1);
+  }
+  partialActive=(k>0);
+  if(partialActive) {
+    dd.partialIndexToBeSent.resize(dd.Get_size());
+    dd.partialPositionsToBeSent.resize(dd.Get_size());
+  }
+}
+
+void Atoms::sharePartial(int ndata) {
+  for(unsigned i=0; i<dd.mpi_request_positions.size(); i++) dd.mpi_request_positions[i].wait();
+  for(unsigned i=0; i<dd.mpi_request_index.size(); i++)     dd.mpi_request_index[i].wait();
+  const int n=dd.Get_size();
+// local atoms needed by the actions calculated by all processes are sent everywhere
+  std::set<AtomNumber> common;
+  for(const auto & a : actions) if(a->isActive() && !a->usesPartialAtoms()) {
+      common.insert(a->getUniqueLocal().begin(),a->getUniqueLocal().end());
+    }
+  for(int r=0; r<n; r++) {
+    std::set<AtomNumber> needed(common);
+    for(const auto & a : actions) if(a->isActive() && a->getAtomsOwner()==r) {
+        needed.insert(a->getUniqueLocal().begin(),a->getUniqueLocal().end());
+      }
+    std::vector<int> & index(dd.partialIndexToBeSent[r]);
+    std::vector<double> & pos(dd.partialPositionsToBeSent[r]);
+    index.resize(needed.size()+1);
+    pos.resize(ndata*needed.size()+1);
+    int count=0;
+    for(const auto & p : needed) {
+      index[count]=p.index();
+      pos[ndata*count+0]=positions[p.index()][0];
+      pos[ndata*count+1]=positions[p.index()][1];
+      pos[ndata*count+2]=positions[p.index()][2];
+      if(!massAndChargeOK) {
+        pos[ndata*count+3]=masses[p.index()];
+        pos[ndata*count+4]=charges[p.index()];
+      }
+      count++;
+    }
+  }
+  asyncSent=true;
+  dd.mpi_request_positions.resize(n);
+  dd.mpi_request_index.resize(n);
+  for(int r=0; r<n; r++) {
+    const int count=dd.partialIndexToBeSent[r].size()-1;
+    dd.mpi_request_index[r]=dd.Isend(&dd.partialIndexToBeSent[r][0],count,r,666);
+    dd.mpi_request_positions[r]=dd.Isend(&dd.partialPositionsToBeSent[r][0],ndata*count,r,667);
+  }
+}
+
+void Atoms::updatePartialForces() {
+  const int n=dd.Get_size();
+  const int rank=dd.Get_rank();
+  for(unsigned i=0; i<dd.mpi_request_positions.size(); i++) dd.mpi_request_positions[i].wait();
+  for(unsigned i=0; i<dd.mpi_request_index.size(); i++)     dd.mpi_request_index[i].wait();
+  for(int r=0; r<n; r++) {
+    dd.partialIndexToBeSent[r].clear();
+    dd.partialPositionsToBeSent[r].clear();
+  }
+// forces on the atoms of the actions calculated here are sent to the process owning the atoms
+  std::set<AtomNumber> computed;
+  for(const auto & a : actions) if(a->isActive() && a->getAtomsOwner()==rank) {
+      computed.insert(a->getUnique().begin(),a->getUnique().end());
+    }
+  for(const auto & p : computed) {
+    const unsigned i=p.index();
+    if(g2l[i]>=0) {
+      forces[i]+=partialForces[i];
+    } else {
+      plumed_assert(dd.homeRank[i]>=0);
+      dd.partialIndexToBeSent[dd.homeRank[i]].push_back(i);
+      for(unsigned k=0; k<3; k++) dd.partialPositionsToBeSent[dd.homeRank[i]].push_back(partialForces[i][k]);
+    }
+  }
+  std::vector<Communicator::Request> requests_index(n);
+  std::vector<Communicator::Request> requests_forces(n);
+  for(int r=0; r<n; r++) {
+    const int count=dd.partialIndexToBeSent[r].size();
+    dd.partialIndexToBeSent[r].push_back(0);
+    dd.partialPositionsToBeSent[r].push_back(0.0);
+    requests_index[r]=dd.Isend(&dd.partialIndexToBeSent[r][0],count,r,668);
+    requests_forces[r]=dd.Isend(&dd.partialPositionsToBeSent[r][0],3*count,r,669);
+  }
+  Communicator::Status status;
+  for(int r=0; r<n; r++) {
+    dd.Recv(&dd.indexToBeReceived[0],dd.indexToBeReceived.size(),r,668,status);
+    int c=status.Get_count<int>();
+    dd.Recv(&dd.positionsToBeReceived[0],dd.positionsToBeReceived.size(),r,669);
+    for(int i=0; i<c; i++) {
+      forces[dd.indexToBeReceived[i]][0]+=dd.positionsToBeReceived[3*i+0];
+      forces[dd.indexToBeReceived[i]][1]+=dd.positionsToBeReceived[3*i+1];
+      forces[dd.indexToBeReceived[i]][2]+=dd.positionsToBeReceived[3*i+2];
+    }
+  }
+  for(int r=0; r<n; r++) {
+    requests_index[r].wait();
+    requests_forces[r].wait();
+  }
+  dd.Sum(partialVirial);
+  virial+=partialVirial;
+}
+
 void Atoms::setNatoms(int n) {
   natoms=n;
   positions.resize(n);
   forces.resize(n);
+  partialForces.resize(n);
   masses.resize(n);
   charges.resize(n);
   gatindex.resize(n);
@@ -361,6 +484,12 @@ void Atoms::DomainDecomposition::enable(Communicator& c) {
     else if(s=="no") async=false;
     else plumed_merror("PLUMED_ASYNC_SHARE variable is set to " + s + "; should be yes or no");
   }
+  if(std::getenv("PLUMED_PARTIAL_SHARE")) {
+    std::string s(std::getenv("PLUMED_PARTIAL_SHARE"));
+    if(s=="yes") partial=true;
+    else if(s=="no") partial=false;
+    else plumed_merror("PLUMED_PARTIAL_SHARE variable is set to " + s + "; should be yes or no");
+  }
 }
 
 void Atoms::setAtomsNlocal(int n) {
@@ -376,6 +505,7 @@ void Atoms::setAtomsNlocal(int n) {
     dd.positionsToBeReceived.resize(natoms*5,0.0);
     dd.indexToBeSent.resize(n,0);
     dd.indexToBeReceived.resize(natoms,0);
+    dd.homeRank.resize(natoms,-1);
   }
 }
 
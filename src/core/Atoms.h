@@ -115,12 +115,20 @@ class Atoms
   bool asyncSent;
   bool atomsNeeded;
 
+/// true if some of the actions are calculated by a single process
+  bool partialActive;
+/// forces and virial from the actions calculated by a single process
+  std::vector<Vector> partialForces;
+  Tensor partialVirial;
+
   class DomainDecomposition:
     public Communicator
   {
   public:
     bool on;
     bool async;
+/// send atoms only to the processes that need them
+    bool partial;
 
     std::vector<Communicator::Request> mpi_request_positions;
     std::vector<Communicator::Request> mpi_request_index;
@@ -129,9 +137,14 @@ class Atoms
     std::vector<double> positionsToBeReceived;
     std::vector<int>    indexToBeSent;
     std::vector<int>    indexToBeReceived;
+/// buffers used when atoms are only sent to the processes that need them
+    std::vector<std::vector<double> > partialPositionsToBeSent;
+    std::vector<std::vector<int> >    partialIndexToBeSent;
+/// rank of the process from which each atom was received
+    std::vector<int>    homeRank;
     operator bool() const {return on;}
     DomainDecomposition():
-      on(false), async(false)
+      on(false), async(false), partial(false)
     {}
     void enable(Communicator& c);
   };
@@ -139,7 +152,13 @@ class Atoms
   DomainDecomposition dd;
   long int ddStep;  //last step in which dd happened
 
-  void share(const std::set<AtomNumber>&);
+  void share(const std::set<AtomNumber>&,bool partial=false);
+/// Assign actions using partial atoms to processes
+  void setupPartialAtoms();
+/// Send local atoms only to the processes that need them
+  void sharePartial(int ndata);
+/// Send forces computed by a single process back to the processes owning the atoms
+  void updatePartialForces();
 
 public:
 
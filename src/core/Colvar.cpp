@@ -60,7 +60,7 @@ void Colvar::apply() {
 
   unsigned stride=1;
   unsigned rank=0;
-  if(ncp>4*comm.Get_size()) {
+  if(ncp>4*comm.Get_size() && !usesPartialAtoms()) {
     stride=comm.Get_size();
     rank=comm.Get_rank();
   }
@@ -100,7 +100,7 @@ void Colvar::apply() {
       }
     }
 
-    if(ncp>4*comm.Get_size()) {
+    if(ncp>4*comm.Get_size() && !usesPartialAtoms()) {
       if(fsz>0) comm.Sum(&f[0][0],3*fsz);
       comm.Sum(&v[0][0],9);
     }
@@ -37,6 +37,7 @@
 #include "tools/Exception.h"
 #include "tools/IFile.h"
 #include "tools/Log.h"
+#include "tools/OFile.h"
 #include "tools/OpenMP.h"
 #include "tools/Tools.h"
 #include "tools/Stopwatch.h"
@@ -45,6 +46,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <set>
+#include <algorithm>
 #include <unordered_map>
 #include <exception>
 #include <stdexcept>
@@ -139,7 +141,8 @@ PlumedMain::PlumedMain():
   stopFlag(NULL),
   stopNow(false),
   novirial(false),
-  detailedTimers(false)
+  detailedTimers(false),
+  parallelActions(false)
 {
   log.link(comm);
   log.setLinePrefix("PLUMED: ");
@@ -761,6 +764,12 @@ void PlumedMain::justCalculate() {
   bias=0.0;
   work=0.0;
 
+// parallelActions is only set by DEBUG PARALLEL_ACTIONS when MPI allows it
+  if(parallelActions && OpenMP::getNumThreads()>1) {
+    calculateActionsConcurrently();
+    return;
+  }
+
   int iaction=0;
 // calculate the active actions in order (assuming *backward* dependence)
   for(const auto & pp : actionSet) {
@@ -778,27 +787,133 @@ void PlumedMain::justCalculate() {
         for(int i=0; i<pad; i++) actionNumberLabel=" "+actionNumberLabel;
         sw=stopwatch.startStop("4A "+actionNumberLabel+" "+p->getLabel());
       }
-      ActionWithValue*av=dynamic_cast<ActionWithValue*>(p);
+// values of actions calculated by a single process are broadcast together,
+// just before an action that needs them
       ActionAtomistic*aa=dynamic_cast<ActionAtomistic*>(p);
-      {
-        if(av) av->clearInputForces();
-        if(av) av->clearDerivatives();
-      }
-      {
-        if(aa) aa->clearOutputForces();
-        if(aa) if(aa->isActive()) aa->retrieveAtoms();
-      }
-      if(p->checkNumericalDerivatives()) p->calculateNumericalDerivatives();
-      else p->calculate();
+      const bool partial=aa && aa->usesPartialAtoms();
+      if(!partial && !partialPending.empty()) for(const auto & d : p->getDependencies()) {
+          if(std::find(partialPending.begin(),partialPending.end(),d)!=partialPending.end()) {
+            broadcastPartialValues();
+            break;
+          }
+        }
+      calculateAction(p);
+      if(partial) partialPending.push_back(aa);
+      ActionWithValue*av=dynamic_cast<ActionWithValue*>(p);
       // This retrieves components called bias
       if(av) bias+=av->getOutputQuantity("bias");
       if(av) work+=av->getOutputQuantity("work");
-      if(av)av->setGradientsIfNeeded();
-      ActionWithVirtualAtom*avv=dynamic_cast<ActionWithVirtualAtom*>(p);
-      if(avv)avv->setGradientsIfNeeded();
     }
     iaction++;
   }
+  if(!partialPending.empty()) broadcastPartialValues();
+}
+
+void PlumedMain::calculateAction(Action* p) {
+  ActionWithValue*av=dynamic_cast<ActionWithValue*>(p);
+  ActionAtomistic*aa=dynamic_cast<ActionAtomistic*>(p);
+  {
+    if(av) av->clearInputForces();
+    if(av) av->clearDerivatives();
+  }
+  {
+    if(aa) aa->clearOutputForces();
+  }
+// actions using partial atoms are only calculated by the process owning their atoms,
+// their values are then set by broadcastPartialValues()
+  if(aa && !aa->isAtomsOwner()) return;
+  if(aa) if(aa->isActive()) aa->retrieveAtoms();
+  if(p->checkNumericalDerivatives()) p->calculateNumericalDerivatives();
+  else p->calculate();
+  if(av)av->setGradientsIfNeeded();
+  ActionWithVirtualAtom*avv=dynamic_cast<ActionWithVirtualAtom*>(p);
+  if(avv)avv->setGradientsIfNeeded();
+}
+
+void PlumedMain::broadcastPartialValues() {
+  std::vector<double> buffer;
+  for(int r=0; r<comm.Get_size(); r++) {
+// all processes fill the buffer, so that it has the same size everywhere
+    buffer.clear();
+    for(const auto & a : partialPending) if(a->getAtomsOwner()==r) {
+        ActionWithValue*av=dynamic_cast<ActionWithValue*>(a);
+        if(av) for(int i=0; i<av->getNumberOfComponents(); i++) buffer.push_back(av->copyOutput(i)->get());
+      }
+    if(buffer.empty()) continue;
+    comm.Bcast(buffer,r);
+    if(r==comm.Get_rank()) continue;
+    unsigned k=0;
+    for(const auto & a : partialPending) if(a->getAtomsOwner()==r) {
+        ActionWithValue*av=dynamic_cast<ActionWithValue*>(a);
+        if(av) for(int i=0; i<av->getNumberOfComponents(); i++) av->copyOutput(i)->set(buffer[k++]);
+      }
+  }
+  partialPending.clear();
+}
+
+void PlumedMain::calculateActionsConcurrently() {
+// Active actions are sorted in levels such that each action only depends
+// on actions in previous levels. Actions in the same level are independent
+// and are calculated concurrently.
+// Some actions are barriers, and are calculated alone after all the previous
+// actions and before all the following ones:
+// - actions without values (e.g. PRINT), that are cheap and whose calculate() might have side effects
+// - atomistic actions that act at given steps, since they might modify
+//   positions of all atoms (e.g. WHOLEMOLECULES or FIT_TO_TEMPLATE)
+// - actions using numerical derivatives, since they perturb their arguments
+  std::vector<Action*> active;
+  std::vector<std::vector<Action*> > levels;
+  std::unordered_map<const Action*,unsigned> levelOf;
+  unsigned firstLevel=0;
+  for(const auto & pp : actionSet) {
+    Action* p(pp.get());
+    if(!p->isActive()) continue;
+    active.push_back(p);
+    const bool barrier=p->checkNumericalDerivatives() || !dynamic_cast<ActionWithValue*>(p) ||
+                       (dynamic_cast<ActionAtomistic*>(p) && dynamic_cast<ActionPilot*>(p));
+    unsigned l=firstLevel;
+    if(barrier) l=levels.size();
+    else for(const auto & d : p->getDependencies()) {
+        auto it=levelOf.find(d);
+        if(it!=levelOf.end() && it->second+1>l) l=it->second+1;
+      }
+    if(l>=levels.size()) levels.resize(l+1);
+    levels[l].push_back(p);
+    levelOf[p]=l;
+    if(barrier) firstLevel=l+1;
+  }
+
+// while actions are calculated concurrently, calls to MPI and writes on files are serialized
+  struct Serialize {
+    Serialize() { Communicator::serializeCalls(true); OFile::serializePrintf(true); }
+    ~Serialize() { Communicator::serializeCalls(false); OFile::serializePrintf(false); }
+  } serialize;
+
+  const unsigned nt=OpenMP::getNumThreads();
+  for(const auto & level : levels) {
+    if(level.size()==1) {
+      calculateAction(level[0]);
+      continue;
+    }
+    std::exception_ptr except;
+    #pragma omp parallel for schedule(dynamic,1) num_threads(nt)
+    for(unsigned i=0; i<level.size(); i++) {
+      try {
+        calculateAction(level[i]);
+      } catch(...) {
+        #pragma omp critical
+        if(!except) except=std::current_exception();
+      }
+    }
+    if(except) std::rethrow_exception(except);
+  }
+
+// bias and work are accumulated in the same order used by the serial loop
+  for(const auto & p : active) {
+    ActionWithValue*av=dynamic_cast<ActionWithValue*>(p);
+    if(av) bias+=av->getOutputQuantity("bias");
+    if(av) work+=av->getOutputQuantity("work");
+  }
 }
 
 void PlumedMain::justApply() {
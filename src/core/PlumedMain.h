@@ -52,6 +52,7 @@ namespace PLMD {
 
 
 
+class Action;
 class ActionAtomistic;
 class ActionPilot;
 class Log;
@@ -199,6 +200,15 @@ private:
 /// Store information used in class \ref generic::UpdateIf
   std::stack<bool> updateFlags;
 
+/// Forward step of a single action: retrieve atoms and calculate
+  void calculateAction(Action*);
+/// Forward loop where independent actions are calculated concurrently
+  void calculateActionsConcurrently();
+/// Actions calculated by a single process whose values have not been broadcast yet
+  std::vector<ActionAtomistic*> partialPending;
+/// Broadcast the values of the actions in partialPending, with one message per process
+  void broadcastPartialValues();
+
 public:
 /// Flag to switch off virial calculation (for debug and MD codes with no barostat)
   bool novirial;
@@ -206,6 +216,9 @@ public:
 /// Flag to switch on detailed timers
   bool detailedTimers;
 
+/// Flag to calculate independent actions concurrently
+  bool parallelActions;
+
 /// Generic map string -> double
 /// intended to pass information across Actions
   std::map<std::string,double> passMap;
@@ -357,6 +370,8 @@ public:
   void insertFile(FileBase&);
 /// Erase a file
   void eraseFile(FileBase&);
+/// Get the files that are currently open
+  const std::set<FileBase*> & getFiles()const {return files;}
 /// Flush all files
   void fflush();
 /// Check if restarting
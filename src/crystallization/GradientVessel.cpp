@@ -40,7 +40,7 @@ public:
   explicit GradientVessel( const vesselbase::VesselOptions& da );
   std::string value_descriptor();
   void resize();
-  void calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const ;
+  void calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const ;
   void finish( const std::vector<double>& buffer );
 };
 
@@ -98,7 +98,7 @@ void GradientVessel::resize() {
   }
 }
 
-void GradientVessel::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
+void GradientVessel::calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {
   unsigned nder;
   if( getAction()->derivativesAreRequired() ) nder=getAction()->getNumberOfDerivatives();
   else nder=0;
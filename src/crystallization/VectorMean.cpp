@@ -37,7 +37,7 @@ public:
   explicit VectorMean( const vesselbase::VesselOptions& da );
   std::string value_descriptor();
   void resize();
-  void calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const ;
+  void calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const ;
   void finish( const std::vector<double>& buffer );
 };
 
@@ -74,7 +74,7 @@ void VectorMean::resize() {
   }
 }
 
-void VectorMean::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
+void VectorMean::calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {
   unsigned ncomp=getAction()->getNumberOfQuantities()-2;
 
   double weight=myvals.get(0); plumed_dbg_assert( weight>=getTolerance() );
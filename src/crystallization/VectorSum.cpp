@@ -37,7 +37,7 @@ public:
   explicit VectorSum( const vesselbase::VesselOptions& da );
   std::string value_descriptor();
   void resize();
-  void calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const ;
+  void calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const ;
   void finish( const std::vector<double>& buffer );
 };
 
@@ -74,7 +74,7 @@ void VectorSum::resize() {
   }
 }
 
-void VectorSum::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
+void VectorSum::calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {
   unsigned ncomp=getAction()->getNumberOfQuantities()-2;
 
   double weight=myvals.get(0);
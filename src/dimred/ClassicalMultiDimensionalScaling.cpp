@@ -21,6 +21,7 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "DimensionalityReductionBase.h"
 #include "core/ActionRegister.h"
+#include "ClassicalScaling.h"
 
 //+PLUMEDOC DIMRED CLASSICAL_MDS
 /*
@@ -150,6 +151,9 @@ we can use this decomposition to write:
 Much as in PCA there are generally a small number of large eigenvalues in \f$\Lambda\f$ and many small eigenvalues.
 We can safely use only the large eigenvalues and their corresponding eigenvectors to express the relationship between
 the coordinates \f$\mathbf{X}\f$.  This gives us our set of low-dimensional projections.
+PLUMED thus only calculates the largest eigenvalues of \f$-\frac{1}{2} \mathbf{J} \mathbf{D}^2(\mathbf{X}) \mathbf{J}\f$ and
+their eigenvectors.  This is done using the Lanczos algorithm, which only requires products of this matrix with vectors,
+so the double centered matrix is never stored.
 
 This derivation makes a number of assumptions about the how the low dimensional points should best be arranged to minimize
 the stress. If you use an interactive optimization algorithm such as SMACOF you may thus be able to find a better
@@ -182,30 +186,7 @@ ClassicalMultiDimensionalScaling::ClassicalMultiDimensionalScaling( const Action
 }
 
 void ClassicalMultiDimensionalScaling::calculateProjections( const Matrix<double>& targets, Matrix<double>& projections ) {
-  // Retrieve the distances from the dimensionality reduction object
-  double half=(-0.5); Matrix<double> distances( half*targets );
-
-  // Apply centering transtion
-  unsigned n=distances.nrows(); double sum;
-  // First HM
-  for(unsigned i=0; i<n; ++i) {
-    sum=0; for(unsigned j=0; j<n; ++j) sum+=distances(i,j);
-    for(unsigned j=0; j<n; ++j) distances(i,j) -= sum/n;
-  }
-  // Now (HM)H
-  for(unsigned i=0; i<n; ++i) {
-    sum=0; for(unsigned j=0; j<n; ++j) sum+=distances(j,i);
-    for(unsigned j=0; j<n; ++j) distances(j,i) -= sum/n;
-  }
-
-  // Diagonalize matrix
-  std::vector<double> eigval(n); Matrix<double> eigvec(n,n);
-  diagMat( distances, eigval, eigvec );
-
-  // Pass final projections to map object
-  for(unsigned i=0; i<n; ++i) {
-    for(unsigned j=0; j<projections.ncols(); ++j) projections(i,j)=sqrt(eigval[n-1-j])*eigvec(n-1-j,i);
-  }
+  ClassicalScaling::run( targets, projections );
 }
 
 }
@@ -0,0 +1,60 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "ClassicalScaling.h"
+#include "tools/Lanczos.h"
+#include "tools/OpenMP.h"
+
+namespace PLMD {
+namespace dimred {
+
+void ClassicalScaling::run( const Matrix<double>& targets, Matrix<double>& projections ) {
+  unsigned n=targets.nrows(), nlow=projections.ncols();
+  // The eigenvectors of the double centered matrix -0.5*HMH, with H the centering
+  // matrix, are found without forming it by multiplying vectors by H, M and H in turn
+  auto product=[&targets,n]( const std::vector<double>& x, std::vector<double>& y ) {
+    double mean=0; for(unsigned i=0; i<n; ++i) mean+=x[i];
+    mean/=n;
+    std::vector<double> hx(n); for(unsigned i=0; i<n; ++i) hx[i]=x[i]-mean;
+    y.resize(n);
+    #pragma omp parallel for num_threads(OpenMP::getNumThreads())
+    for(unsigned i=0; i<n; ++i) {
+      double sum=0; for(unsigned j=0; j<n; ++j) sum+=targets(i,j)*hx[j];
+      y[i]=sum;
+    }
+    mean=0; for(unsigned i=0; i<n; ++i) mean+=y[i];
+    mean/=n;
+    for(unsigned i=0; i<n; ++i) y[i]=-0.5*(y[i]-mean);
+  };
+
+  // Find the largest eigenvalues of the double centered matrix
+  std::vector<double> eigval; Matrix<double> eigvec;
+  int err=diagMatLanczos( n, nlow, product, eigval, eigvec );
+  plumed_massert( err==0, "diagonalization of double centered matrix failed" );
+
+  // Pass final projections to map object
+  for(unsigned i=0; i<n; ++i) {
+    for(unsigned j=0; j<nlow; ++j) projections(i,j)=sqrt(eigval[j])*eigvec(j,i);
+  }
+}
+
+}
+}
@@ -0,0 +1,39 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_dimred_ClassicalScaling_h
+#define __PLUMED_dimred_ClassicalScaling_h
+
+#include "tools/Matrix.h"
+
+namespace PLMD {
+namespace dimred {
+
+class ClassicalScaling {
+public:
+/// Find the projections of the points from the matrix of squared dissimilarities.  The number
+/// of columns in projections is the dimensionality of the low dimensional space.
+  static void run( const Matrix<double>& targets, Matrix<double>& projections );
+};
+
+}
+}
+#endif
@@ -89,8 +89,10 @@ void DimensionalityReductionBase::performAnalysis() {
   }
   // Calculate matrix of dissimilarities
   Matrix<double> targets( getNumberOfDataPoints(), getNumberOfDataPoints() ); targets=0;
+  std::vector<double> row;
   for(unsigned i=1; i<getNumberOfDataPoints(); ++i) {
-    for(unsigned j=0; j<i; ++j) targets(i,j)=targets(j,i)=getDissimilarity( i, j );
+    getDissimilarityRow( i, row );
+    for(unsigned j=0; j<i; ++j) targets(i,j)=targets(j,i)=row[j];
   }
   // This calculates the projections of the points
   calculateProjections( targets, projections );
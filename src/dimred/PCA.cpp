@@ -25,6 +25,8 @@
 #include "reference/ReferenceValuePack.h"
 #include "analysis/ReadAnalysisFrames.h"
 #include "core/ActionRegister.h"
+#include "tools/Lanczos.h"
+#include "tools/OpenMP.h"
 
 //+PLUMEDOC DIMRED PCA
 /*
@@ -52,6 +54,10 @@ be uninteresting.  Consequently, to remedy this problem PLUMED provides the func
 to be analyzed to the first frame in the trajectory.  This can be used to effectively remove translational and/or rotational motions from
 consideration.  The resulting principal components thus describe vibrational motions of the molecule.
 
+Only the NLOW_DIM eigenvectors of the covariance matrix with the largest eigenvalues are calculated.  They are found using the Lanczos
+algorithm, which works with the displacements of the stored frames from the average directly, so the covariance matrix is never stored.
+This makes it possible to perform a PCA using the positions of thousands of atoms.
+
 If you wish to calculate the projection of a trajectory on a set of principal components calculated from this PCA action then the output can be
 used as input for the \ref PCAVARS action.
 
@@ -188,43 +194,50 @@ void PCA::performAnalysis() {
   double inorm = 1.0 / norm ;
   for(unsigned j=0; j<myconf0->getNumberOfReferenceArguments(); ++j) sarg[j] = inorm*sarg[j] + myconf0->getReferenceArguments()[j];
   for(unsigned j=0; j<myconf0->getNumberOfReferencePositions(); ++j) spos[j] = inorm*spos[j] + myconf0->getReferencePositions()[j];
-  // Now accumulate the covariance
+  // Now store the displacements of all the frames from the average.  The covariance matrix is
+  // never formed: products of it with vectors are calculated from these displacements instead.
   unsigned narg=myconf0->getNumberOfReferenceArguments(), natoms=myconf0->getNumberOfReferencePositions();
-  Matrix<double> covar( narg+3*natoms, narg+3*natoms ); covar=0;
-  for(unsigned i=0; i<getNumberOfDataPoints(); ++i) {
+  unsigned ndata=getNumberOfDataPoints(), ncomp=narg+3*natoms;
+  Matrix<double> disp( ndata, ncomp ); std::vector<double> weights( ndata );
+  for(unsigned i=0; i<ndata; ++i) {
+    weights[i] = inorm*getWeight(i);
     my_input_data->getStoredData( i, false ).transferDataToPDB( mypdb );
     for(unsigned j=0; j<getArguments().size(); ++j) mypdb.getArgumentValue( getArguments()[j]->getName(), args[j] );
     double d = myconf0->calc( mypdb.getPositions(), getPbc(), getArguments(), args, mypack, true );
     for(unsigned jarg=0; jarg<narg; ++jarg) {
       // Need sorting for PBC with GAT
       double jarg_d = 0.5*mypack.getArgumentDerivative(jarg) + myconf0->getReferenceArguments()[jarg] - sarg[jarg];
-      for(unsigned karg=0; karg<narg; ++karg) {
-        // Need sorting for PBC with GAT
-        double karg_d = 0.5*mypack.getArgumentDerivative(karg) + myconf0->getReferenceArguments()[karg] - sarg[karg];
-        covar( jarg, karg ) += 0.25*getWeight(i)*jarg_d*karg_d; // mypack.getArgumentDerivative(jarg)*mypack.getArgumentDerivative(karg);
-      }
+      disp( i, jarg ) = 0.5*jarg_d;
     }
     for(unsigned jat=0; jat<natoms; ++jat) {
       for(unsigned jc=0; jc<3; ++jc) {
-        double jdisplace = mypack.getAtomsDisplacementVector()[jat][jc] / displace[jat] + myconf0->getReferencePositions()[jat][jc] - spos[jat][jc];
-        for(unsigned kat=0; kat<natoms; ++kat) {
-          for(unsigned kc=0; kc<3; ++kc) {
-            double kdisplace = mypack.getAtomsDisplacementVector()[kat][kc] /displace[kat] + myconf0->getReferencePositions()[kat][kc] - spos[kat][kc];
-            covar( narg+3*jat + jc, narg+3*kat + kc ) += getWeight(i)*jdisplace*kdisplace;
-          }
-        }
+        disp( i, narg+3*jat + jc ) = mypack.getAtomsDisplacementVector()[jat][jc] / displace[jat] + myconf0->getReferencePositions()[jat][jc] - spos[jat][jc];
       }
     }
   }
-  // Normalise
-  for(unsigned i=0; i<covar.nrows(); ++i) {
-    for(unsigned j=0; j<covar.ncols(); ++j) covar(i,j) *= inorm;
-  }
+  // The covariance has no elements connecting the arguments to the atoms so the
+  // projections of the displacements on the two parts of the vector are kept separate
+  auto product=[&disp,&weights,ndata,ncomp,narg]( const std::vector<double>& x, std::vector<double>& y ) {
+    std::vector<double> parg( ndata ), patoms( ndata );
+    #pragma omp parallel for num_threads(OpenMP::getNumThreads())
+    for(unsigned i=0; i<ndata; ++i) {
+      double sa=0, sp=0;
+      for(unsigned j=0; j<narg; ++j) sa+=disp(i,j)*x[j];
+      for(unsigned j=narg; j<ncomp; ++j) sp+=disp(i,j)*x[j];
+      parg[i]=weights[i]*sa; patoms[i]=weights[i]*sp;
+    }
+    y.resize( ncomp );
+    #pragma omp parallel for num_threads(OpenMP::getNumThreads())
+    for(unsigned j=0; j<ncomp; ++j) {
+      const std::vector<double>& s( j<narg ? parg : patoms );
+      double sum=0; for(unsigned i=0; i<ndata; ++i) sum+=s[i]*disp(i,j);
+      y[j]=sum;
+    }
+  };
 
-  // Diagonalise the covariance
-  std::vector<double> eigval( narg+3*natoms );
-  Matrix<double> eigvec( narg+3*natoms, narg+3*natoms );
-  diagMat( covar, eigval, eigvec );
+  // Find the largest eigenvalues of the covariance and their eigenvectors
+  std::vector<double> eigval; Matrix<double> eigvec;
+  if( diagMatLanczos( ncomp, nlow, product, eigval, eigvec )!=0 ) error("diagonalization of covariance matrix failed");
 
   // Output the reference configuration
   mypdb.setAtomPositions( spos );
@@ -235,10 +248,9 @@ void PCA::performAnalysis() {
   // Store and print the eigenvectors
   std::vector<Vector> tmp_atoms( natoms );
   for(unsigned dim=0; dim<nlow; ++dim) {
-    unsigned idim = covar.ncols() - 1 - dim;
-    for(unsigned i=0; i<narg; ++i) mypdb.setArgumentValue( getArguments()[i]->getName(), eigvec(idim,i) );
+    for(unsigned i=0; i<narg; ++i) mypdb.setArgumentValue( getArguments()[i]->getName(), eigvec(dim,i) );
     for(unsigned i=0; i<natoms; ++i) {
-      for(unsigned k=0; k<3; ++k) tmp_atoms[i][k]=eigvec(idim,narg+3*i+k);
+      for(unsigned k=0; k<3; ++k) tmp_atoms[i][k]=eigvec(dim,narg+3*i+k);
     }
     mypdb.setAtomPositions( tmp_atoms );
     // Create a direction object so that we can calculate other PCA components
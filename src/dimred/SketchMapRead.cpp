@@ -60,6 +60,7 @@ public:
   std::vector<Value*> getArgumentList();
   unsigned getDataPointIndexInBase( const unsigned& idata ) const ;
   double getDissimilarity( const unsigned& i, const unsigned& j );
+  void getDissimilarityRow( const unsigned& i, std::vector<double>& row );
   double getWeight( const unsigned& idata );
 };
 
@@ -169,6 +170,11 @@ std::vector<Value*> SketchMapRead::getArgumentList() {
   return arglist;
 }
 
+void SketchMapRead::getDissimilarityRow( const unsigned& i, std::vector<double>& row ) {
+  row.resize( myframes.size() );
+  for(unsigned j=0; j<myframes.size(); ++j) row[j]=getDissimilarity( i, j );
+}
+
 // Highly unsatisfactory solution to problem GAT
 double SketchMapRead::getDissimilarity( const unsigned& i, const unsigned& j ) {
   plumed_assert( i<myframes.size() && j<myframes.size() );
@@ -22,11 +22,16 @@
 #include "DimensionalityReductionBase.h"
 #include "core/ActionRegister.h"
 #include "SMACOF.h"
+#include "ClassicalScaling.h"
 
 //+PLUMEDOC DIMRED SMACOF_MDS
 /*
 Optimize the multidimensional scaling stress function using the SMACOF algorithm.
 
+The initial projections are taken from the dimensionality reduction action that is given as input.  If the input
+is not a dimensionality reduction action the initial projections are calculated using classical scaling as in \ref CLASSICAL_MDS.
+The dimensionality of the low dimensional space must then be specified using NLOW_DIM.
+
 \par Examples
 
 */
@@ -49,7 +54,7 @@ PLUMED_REGISTER_ACTION(SmacofMDS,"SMACOF_MDS")
 
 void SmacofMDS::registerKeywords( Keywords& keys ) {
   DimensionalityReductionBase::registerKeywords( keys );
-  keys.remove("NLOW_DIM");
+  keys.reset_style("NLOW_DIM","optional");
   keys.add("compulsory","SMACOF_TOL","1E-4","tolerance for the SMACOF optimization algorithm");
   keys.add("compulsory","SMACOF_MAXCYC","1000","maximum number of optimization cycles for SMACOF algorithm");
 }
@@ -58,7 +63,7 @@ SmacofMDS::SmacofMDS( const ActionOptions& ao):
   Action(ao),
   DimensionalityReductionBase(ao)
 {
-  if( !dimredbase ) error("SMACOF must be initialized using output from dimensionality reduction object");
+  if( !dimredbase ) log.printf("  initial projections are calculated using classical multidimensional scaling \n");
 
   parse("SMACOF_TOL",tol); parse("SMACOF_MAXCYC",maxloops);
   log.printf("  running smacof to convergence at %f or for a maximum of %u steps \n",tol,maxloops);
@@ -74,6 +79,8 @@ void SmacofMDS::calculateProjections( const Matrix<double>& targets, Matrix<doub
       weights(i,j)=weights(j,i)=getWeight(i)*getWeight(j);
     }
   }
+  // Use classical scaling to get an initial guess if the input is not a dimensionality reduction object
+  if( !dimredbase ) ClassicalScaling::run( targets, projections );
   // And run SMACOF
   SMACOF::run( weights, targets, tol, maxloops, projections );
 }
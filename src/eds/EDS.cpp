@@ -213,6 +213,7 @@ public:
   explicit EDS(const ActionOptions&);
   void calculate();
   void update();
+  bool isHistoryDependent()const override {return true;}
   void turnOnDerivatives();
   static void registerKeywords(Keywords& keys);
   ~EDS();
@@ -165,8 +165,10 @@ progression (S) and distance (Z) variables \cite perez2015atp.
 class Custom :
   public Function
 {
+/// Function and its derivatives, evaluated together
   lepton::CompiledExpression expression;
-  std::vector<lepton::CompiledExpression> expression_deriv;
+/// Location of each variable in expression, or nullptr if the variable is not used
+  vector<double*> var_ref;
   vector<string> var;
   string func;
   vector<double> values;
@@ -219,7 +221,7 @@ void Custom::registerKeywords(Keywords& keys) {
 Custom::Custom(const ActionOptions&ao):
   Action(ao),
   Function(ao),
-  expression_deriv(getNumberOfArguments()),
+  var_ref(getNumberOfArguments()),
   values(getNumberOfArguments()),
   names(getNumberOfArguments())
 {
@@ -245,40 +247,39 @@ Custom::Custom(const ActionOptions&ao):
 
   lepton::ParsedExpression pe=lepton::Parser::parse(func).optimize(lepton::Constants());
   log<<"  function as parsed by lepton: "<<pe<<"\n";
-  expression=pe.createCompiledExpression();
-  for(auto &p: expression.getVariables()) {
-    if(std::find(var.begin(),var.end(),p)==var.end()) {
-      error("variable " + p + " is not defined");
-    }
-  }
+  vector<lepton::ParsedExpression> pes(1,pe);
   log<<"  derivatives as computed by lepton:\n";
   for(unsigned i=0; i<getNumberOfArguments(); i++) {
     lepton::ParsedExpression pe=lepton::Parser::parse(func).differentiate(var[i]).optimize(lepton::Constants());
     log<<"    "<<pe<<"\n";
-    expression_deriv[i]=pe.createCompiledExpression();
+    pes.push_back(pe);
+  }
+// the function and its derivatives are compiled together, so that their common subexpressions are calculated only once
+  expression=lepton::CompiledExpression(pes);
+  for(auto &p: expression.getVariables()) {
+    if(std::find(var.begin(),var.end(),p)==var.end()) {
+      error("variable " + p + " is not defined");
+    }
   }
-}
-
-void Custom::calculate() {
   for(unsigned i=0; i<getNumberOfArguments(); i++) {
     try {
-      expression.getVariableReference(var[i])=getArgument(i);
+      var_ref[i]=&expression.getVariableReference(var[i]);
     } catch(const PLMD::lepton::Exception& exc) {
 // this is necessary since in some cases lepton things a variable is not present even though it is present
 // e.g. func=0*x
+      var_ref[i]=nullptr;
     }
   }
+}
+
+void Custom::calculate() {
+  for(unsigned i=0; i<getNumberOfArguments(); i++) {
+    if(var_ref[i]) *var_ref[i]=getArgument(i);
+  }
   setValue(expression.evaluate());
+  const vector<double> & results(expression.getResults());
   for(unsigned i=0; i<getNumberOfArguments(); i++) {
-    for(unsigned j=0; j<getNumberOfArguments(); j++) {
-      try {
-        expression_deriv[i].getVariableReference(var[j])=getArgument(j);
-      } catch(const PLMD::lepton::Exception& exc) {
-// this is necessary since in some cases lepton things a variable is not present even though it is present
-// e.g. func=0*x
-      }
-    }
-    setDerivative(i,expression_deriv[i].evaluate());
+    setDerivative(i,results[i+1]);
   }
 }
 
@@ -185,6 +185,7 @@ public:
 // active methods:
   virtual void calculate();
   virtual void prepare();
+  bool isHistoryDependent()const override {return neigh_size>0 && int(neigh_stride/getTimeStep())!=1;}
   static void registerKeywords(Keywords& keys);
 };
 
@@ -23,6 +23,7 @@
 #include "core/ActionPilot.h"
 #include "core/ActionSet.h"
 #include "core/PlumedMain.h"
+#include "tools/Communicator.h"
 
 using namespace std;
 
@@ -44,6 +45,25 @@ DEBUG DETAILED_TIMERS
 DEBUG logRequestedAtoms STRIDE=2
 \endplumedfile
 
+When PARALLEL_ACTIONS is used, actions that do not depend on each other
+are calculated concurrently using OpenMP threads (see \ref Openmp).
+This can be useful when the input contains many independent and expensive CVs that
+are only combined by the bias.
+Forces are still applied in the usual order, and the total bias is summed in the
+usual order, so that results are identical.
+When MPI is initialized, actions are calculated concurrently only if MPI supports calls from several
+threads (i.e. it was initialized with MPI_THREAD_SERIALIZED or MPI_THREAD_MULTIPLE) and PLUMED runs on a single
+MPI process without multiple replicas, since concurrent actions could issue collective calls in a different
+order on different processes. MPI calls and writes on files are serialized while actions are calculated
+concurrently. Otherwise this flag is ignored and a warning is written in the log.
+Actions without values (e.g. \ref PRINT), actions modifying atomic positions (e.g. \ref WHOLEMOLECULES)
+and actions using numerical derivatives are calculated alone, after all the
+actions that precede them in the input and before all the actions that follow them.
+
+\plumedfile
+DEBUG PARALLEL_ACTIONS
+\endplumedfile
+
 */
 //+ENDPLUMEDOC
 class Debug:
@@ -54,6 +74,7 @@ class Debug:
   bool logRequestedAtoms;
   bool novirial;
   bool detailedTimers;
+  bool parallelActions;
 public:
   explicit Debug(const ActionOptions&ao);
 /// Register all the relevant keywords for the action
@@ -72,6 +93,7 @@ void Debug::registerKeywords( Keywords& keys ) {
   keys.addFlag("logRequestedAtoms",false,"write in the log which atoms have been requested at a given time");
   keys.addFlag("NOVIRIAL",false,"switch off the virial contribution for the entirety of the simulation");
   keys.addFlag("DETAILED_TIMERS",false,"switch on detailed timers");
+  keys.addFlag("PARALLEL_ACTIONS",false,"calculate actions that do not depend on each other concurrently using OpenMP threads");
   keys.add("optional","FILE","the name of the file on which to output these quantities");
 }
 
@@ -93,6 +115,18 @@ Debug::Debug(const ActionOptions&ao):
     log.printf("  Detailed timing on\n");
     plumed.detailedTimers=true;
   }
+  parseFlag("PARALLEL_ACTIONS",parallelActions);
+// actions calculated concurrently might issue collective MPI calls in a different order
+// on different processes, so they are only allowed with a single process per replica
+  if(parallelActions && !Communicator::threadsSupported()) {
+    log.printf("  WARNING: MPI was not initialized with at least MPI_THREAD_SERIALIZED, actions will not be calculated concurrently\n");
+  } else if(parallelActions && (comm.Get_size()>1 || multi_sim_comm.Get_size()>1)) {
+    log.printf("  WARNING: PLUMED runs on more than one MPI process, actions will not be calculated concurrently\n");
+  } else if(parallelActions) {
+    log.printf("  Independent actions are calculated concurrently\n");
+    if(plumed.detailedTimers) log.printf("  WARNING: detailed timers are not available for actions calculated concurrently\n");
+    plumed.parallelActions=true;
+  }
   ofile.link(*this);
   std::string file;
   parse("FILE",file);
@@ -22,6 +22,7 @@
 #include "core/ActionPilot.h"
 #include "core/ActionWithValue.h"
 #include "core/ActionWithArguments.h"
+#include "core/ActionAtomistic.h"
 #include "core/ActionRegister.h"
 #include "tools/File.h"
 
@@ -108,6 +109,11 @@ DumpDerivatives::DumpDerivatives(const ActionOptions&ao):
     (getPntrToArgument(i)->getPntrToAction())->turnOnDerivatives();
     if( npar!=getPntrToArgument(i)->getNumberOfDerivatives() ) error("the number of derivatives must be the same in all values being dumped");
   }
+// derivatives are only available on the process calculating an action
+  for(unsigned i=0; i<nargs; i++) {
+    ActionAtomistic* aa=dynamic_cast<ActionAtomistic*>(getPntrToArgument(i)->getPntrToAction());
+    if(aa) aa->forbidPartialAtoms();
+  }
   checkRead();
 }
 
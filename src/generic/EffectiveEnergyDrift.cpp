@@ -119,6 +119,7 @@ public:
   void calculate() {};
   void apply() {};
   void update();
+  bool isHistoryDependent()const override {return true;}
 };
 
 PLUMED_REGISTER_ACTION(EffectiveEnergyDrift,"EFFECTIVE_ENERGY_DRIFT")
@@ -104,6 +104,7 @@ void Print::registerKeywords(Keywords& keys) {
   keys.add("compulsory","STRIDE","1","the frequency with which the quantities of interest should be output");
   keys.add("optional","FILE","the name of the file on which to output these quantities");
   keys.add("optional","FMT","the format that should be used to output real numbers");
+  keys.addFlag("BINARY",false,"write the values in binary format, see \\ref convert_fields");
   keys.add("hidden","_ROTATE","some funky thing implemented by GBussi");
   keys.use("RESTART");
   keys.use("UPDATE_FROM");
@@ -119,10 +120,15 @@ Print::Print(const ActionOptions&ao):
 {
   ofile.link(*this);
   parse("FILE",file);
+  bool binary=false;
+  parseFlag("BINARY",binary);
   if(file.length()>0) {
+    if(binary) ofile.enforceBinary();
     ofile.open(file);
     log.printf("  on file %s\n",file.c_str());
+    if(binary) log.printf("  in binary format\n");
   } else {
+    if(binary) error("BINARY can only be used together with FILE");
     log.printf("  on plumed log file\n");
     ofile.link(log);
   }
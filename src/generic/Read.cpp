@@ -86,6 +86,8 @@ public:
   void apply() {}
   void calculate();
   void update();
+/// Lines are read one step after the other
+  bool isHistoryDependent()const override {return true;}
   std::string getFilename() const;
   IFile* getFile();
   unsigned getNumberOfDerivatives();
@@ -31,7 +31,7 @@ class AverageOnGrid : public HistogramOnGrid {
 public:
   static void registerKeywords( Keywords& keys );
   explicit AverageOnGrid( const vesselbase::VesselOptions& da );
-  void accumulate( const unsigned& ipoint, const double& weight, const double& dens, const std::vector<double>& der, std::vector<double>& buffer ) const ;
+  void accumulate( const unsigned& ipoint, const double& weight, const double& dens, const std::vector<double>& der, AccumulationBuffer& buffer ) const ;
   void accumulateForce( const unsigned& ipoint, const double& weight, const std::vector<double>& der, std::vector<double>& intforce ) const { plumed_error(); }
   double getGridElement( const unsigned& ipoint, const unsigned& jelement ) const ;
   unsigned getNumberOfComponents() const ;
@@ -336,7 +336,7 @@ void GridVessel::addToGridElement( const unsigned& ipoint, const unsigned& jelem
   addDataElement( nper*ipoint + jelement, value );
 }
 
-void GridVessel::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
+void GridVessel::calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {
   plumed_dbg_assert( myvals.getNumberOfValues()==(nper+1) );
   for(unsigned i=0; i<nper; ++i) buffer[bufstart + nper*current + i] += myvals.get(i+1);
 }
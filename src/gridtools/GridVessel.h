@@ -167,7 +167,7 @@ public:
 /// Get the extent of the grid in one of the axis
   double getGridExtent( const unsigned& i ) const ;
 /// Copy data from the action into the grid
-  virtual void calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const ;
+  virtual void calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const ;
 /// Finish the calculation
   virtual void finish( const std::vector<double>& buffer );
 /// This ensures that Gaussian cube fies are in correct units
@@ -105,7 +105,7 @@ std::vector<std::unique_ptr<Value>> HistogramOnGrid::getVectorOfValues() const {
   return vv;
 }
 
-void HistogramOnGrid::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
+void HistogramOnGrid::calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {
   if( addOneKernelAtATime ) {
     plumed_dbg_assert( myvals.getNumberOfValues()==2 && !wasforced );
     std::vector<double> der( dimension );
@@ -175,7 +175,7 @@ void HistogramOnGrid::calculate( const unsigned& current, MultiValue& myvals, st
   }
 }
 
-void HistogramOnGrid::accumulate( const unsigned& ipoint, const double& weight, const double& dens, const std::vector<double>& der, std::vector<double>& buffer ) const {
+void HistogramOnGrid::accumulate( const unsigned& ipoint, const double& weight, const double& dens, const std::vector<double>& der, AccumulationBuffer& buffer ) const {
   buffer[bufstart+nper*ipoint] += weight*dens;
   if( der.size()>0 ) for(unsigned j=0; j<dimension; ++j) buffer[bufstart+nper*ipoint + 1 + j] += weight*der[j];
 }
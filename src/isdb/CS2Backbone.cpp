@@ -40,6 +40,9 @@
 #include "tools/Pbc.h"
 #include "tools/PDB.h"
 #include "tools/Torsion.h"
+#include "tools/Communicator.h"
+#include "tools/LinkCells.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -410,7 +413,6 @@ class CS2Backbone : public MetainferenceBase {
     vector<unsigned> side_chain;// atoms for the current sidechain
     vector<int> xd1;            // additional couple of atoms
     vector<int> xd2;            // additional couple of atoms
-    vector<unsigned> box_nb;    // non-bonded atoms
 
     ChemicalShift():
       exp_cs(0.),
@@ -431,7 +433,6 @@ class CS2Backbone : public MetainferenceBase {
     {
       xd1.reserve(26);
       xd2.reserve(26);
-      box_nb.reserve(150);
     }
   };
 
@@ -470,6 +471,10 @@ class CS2Backbone : public MetainferenceBase {
   bool             camshift;
   bool             pbc;
   bool             serial;
+  vector<unsigned> box_nb_start; // the non-bonded atoms of chemical shift cs are box_nb[box_nb_start[cs]] to box_nb[box_nb_start[cs+1]-1]
+  vector<unsigned> box_nb;       // non-bonded atoms of all the chemical shifts
+  Communicator     serialcomm;
+  LinkCells        linkcells;
 
   void init_cs(const string &file, const string &k, const PDB &pdb);
   void update_neighb();
@@ -523,7 +528,8 @@ CS2Backbone::CS2Backbone(const ActionOptions&ao):
   max_cs_atoms(0),
   camshift(false),
   pbc(true),
-  serial(false)
+  serial(false),
+  linkcells(serialcomm)
 {
   vector<AtomNumber> used_atoms;
   parseAtomList("ATOMS",used_atoms);
@@ -1217,9 +1223,9 @@ void CS2Backbone::calculate()
       //NON BOND
       const double * CONST_CO_SPHERE3 = db.CO_SPHERE(aa_kind,at_kind,0);
       const double * CONST_CO_SPHERE  = db.CO_SPHERE(aa_kind,at_kind,1);
-      const unsigned boxsize = myfrag->box_nb.size();
+      const unsigned boxsize = box_nb_start[cs+1] - box_nb_start[cs];
       for(unsigned q=0; q<boxsize; q++) {
-        const unsigned jpos = myfrag->box_nb[q];
+        const unsigned jpos = box_nb[box_nb_start[cs]+q];
         const Vector distance = delta(getPosition(jpos),getPosition(ipos));
         const double d2 = distance.modulo2();
 
@@ -1352,21 +1358,67 @@ void CS2Backbone::calculate()
 }
 
 void CS2Backbone::update_neighb() {
-  max_cs_atoms=0;
-  // cycle over chemical shifts
-  for(unsigned cs=0; cs<chemicalshifts.size(); cs++) {
-    const unsigned boxsize = getNumberOfAtoms();
-    chemicalshifts[cs].box_nb.clear();
-    chemicalshifts[cs].box_nb.reserve(150);
-    const unsigned res_curr = res_num[chemicalshifts[cs].ipos];
-    for(unsigned bat=0; bat<boxsize; bat++) {
-      const unsigned res_dist = abs(static_cast<int>(res_curr-res_num[bat]));
-      if(res_dist<2) continue;
-      const Vector distance = delta(getPosition(bat),getPosition(chemicalshifts[cs].ipos));
-      const double d2=distance.modulo2();
-      if(d2<cutOffNB2) chemicalshifts[cs].box_nb.push_back(bat);
+  const unsigned natoms = getNumberOfAtoms();
+  const unsigned ncs = chemicalshifts.size();
+  vector<unsigned> indices(natoms);
+  for(unsigned i=0; i<natoms; i++) indices[i] = i;
+  linkcells.setCutoff(cutOffNB);
+  linkcells.buildCellListsWithoutPbc(getPositions(), indices);
+
+  unsigned stride = comm.Get_size();
+  unsigned rank   = comm.Get_rank();
+  if(serial) {
+    stride = 1;
+    rank   = 0;
+  }
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt*stride*2>ncs) nt=1;
+
+  // cycle over chemical shifts, each thread stores the neighbours in its own list
+  vector<vector<unsigned> > thread_nb(nt);
+  vector<unsigned> nneigh(ncs,0), thread_of(ncs), offset_of(ncs);
+  #pragma omp parallel num_threads(nt)
+  {
+    const unsigned tid = OpenMP::getThreadNum();
+    vector<unsigned> & mynb = thread_nb[tid];
+    vector<unsigned> cells_required, atoms(natoms+1);
+    #pragma omp for schedule(dynamic)
+    for(unsigned cs=rank; cs<ncs; cs+=stride) {
+      thread_of[cs] = tid;
+      offset_of[cs] = mynb.size();
+      const unsigned ipos = chemicalshifts[cs].ipos;
+      const unsigned res_curr = res_num[ipos];
+      unsigned natomsper=1; atoms[0]=ipos;
+      linkcells.retrieveNeighboringAtoms(getPosition(ipos), cells_required, natomsper, atoms);
+      for(unsigned k=1; k<natomsper; k++) {
+        const unsigned bat = atoms[k];
+        const unsigned res_dist = abs(static_cast<int>(res_curr-res_num[bat]));
+        if(res_dist<2) continue;
+        const Vector distance = delta(getPosition(bat),getPosition(ipos));
+        const double d2=distance.modulo2();
+        if(d2<cutOffNB2) mynb.push_back(bat);
+      }
+      sort(mynb.begin()+offset_of[cs], mynb.end());
+      nneigh[cs] = mynb.size() - offset_of[cs];
     }
-    chemicalshifts[cs].totcsatoms = chemicalshifts[cs].csatoms + chemicalshifts[cs].box_nb.size();
+  }
+  if(!serial) comm.Sum(nneigh);
+
+  // copy all the neighbours in a single list
+  box_nb_start.resize(ncs+1);
+  box_nb_start[0] = 0;
+  for(unsigned cs=0; cs<ncs; cs++) box_nb_start[cs+1] = box_nb_start[cs] + nneigh[cs];
+  box_nb.assign(box_nb_start[ncs], 0);
+  #pragma omp parallel for num_threads(nt)
+  for(unsigned cs=rank; cs<ncs; cs+=stride) {
+    const vector<unsigned> & mynb = thread_nb[thread_of[cs]];
+    copy(mynb.begin()+offset_of[cs], mynb.begin()+offset_of[cs]+nneigh[cs], box_nb.begin()+box_nb_start[cs]);
+  }
+  if(!serial) comm.Sum(box_nb);
+
+  max_cs_atoms=0;
+  for(unsigned cs=0; cs<ncs; cs++) {
+    chemicalshifts[cs].totcsatoms = chemicalshifts[cs].csatoms + nneigh[cs];
     if(chemicalshifts[cs].totcsatoms>max_cs_atoms) max_cs_atoms = chemicalshifts[cs].totcsatoms;
   }
 }
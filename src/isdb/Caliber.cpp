@@ -93,6 +93,7 @@ class Caliber : public bias::Bias {
 public:
   explicit Caliber(const ActionOptions&);
   void calculate();
+  bool isHistoryDependent()const override {return true;}
   static void registerKeywords( Keywords& keys );
 private:
   vector<double> time;
@@ -199,6 +199,7 @@ public:
 // active methods:
   void prepare();
   virtual void calculate();
+  bool isHistoryDependent()const override {return nl_stride_>1;}
 };
 
 PLUMED_REGISTER_ACTION(EMMI,"EMMI")
@@ -262,6 +262,7 @@ public:
   ~Metainference();
   void calculate();
   void update();
+  bool isHistoryDependent()const override {return true;}
   static void registerKeywords(Keywords& keys);
 };
 
@@ -184,6 +184,7 @@ public:
   void setCalcData(const unsigned index, const double datum);
   void setCalcData(const std::vector<double>& data);
   bool getDoScore();
+  bool isHistoryDependent()const override {return doscore_;}
   unsigned getWstride();
   double getScore();
   void setScore(const double score);
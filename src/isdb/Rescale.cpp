@@ -158,6 +158,7 @@ public:
   explicit Rescale(const ActionOptions&);
   ~Rescale();
   void calculate();
+  bool isHistoryDependent()const override {return true;}
   static void registerKeywords(Keywords& keys);
 };
 
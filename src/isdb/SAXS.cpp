@@ -35,6 +35,7 @@
 #include <string>
 #include <cmath>
 #include <map>
+#include <algorithm>
 
 #ifdef __PLUMED_HAS_GSL
 #include <gsl/gsl_sf_bessel.h>
@@ -71,6 +72,11 @@ if the ARRAYFIRE libraries are installed and correctly linked (). Alternatively
 BESSEL flag. This is very fast for small q values because a short expansion is enough.
 An automatic choice is made for which q Bessel are used and for which the calculation is done by Debye. If one wants to force
 all q values to be calculated using Bessel function this can be done using FORCE_BESSEL.
+The Debye equation can also be solved on CPU using HISTOGRAM_BIN: the pair distances are binned, for each pair of
+atoms with the same structure factors, in a histogram with bins of the given width and the intensities are calculated from the
+histograms, while the forces are calculated interpolating the tabulated derivative of \f$\sin(qr)/(qr)\f$. This avoids
+the calculation of trigonometric functions for each pair of atoms and each q value. The error on the contribution of each pair
+is below \f$(q\Delta)^2/24\f$, where \f$\Delta\f$ is the width of the bins, and its value for the largest q is written in the log.
 Irrespective of the method employed, \ref METAINFERENCE can be activated using DOSCORE and the other relevant keywords.
 
 \par Examples
@@ -119,9 +125,19 @@ private:
   bool                     force_bessel;
   bool                     gpu;
   int                      deviceid;
+  double                   hist_bin;
   vector<double>           q_list;
   vector<double>           FF_rank;
   vector<vector<double> >  FF_value;
+  // structure factors for the histogram: atoms with the same structure factors share the same type
+  unsigned                 ntypes;
+  vector<unsigned>         FF_type;
+  vector<double>           FF_atom;
+  vector<vector<double> >  FF_type_value;
+  // sin(qr)/(qr) and its derivative with respect to r, tabulated on the bins of the histogram
+  unsigned                 nbins_table;
+  vector<double>           sinc_table;
+  vector<double>           dsinc_table;
 #ifdef  __PLUMED_HAS_ARRAYFIRE
   af::array                AFF_value;
 #endif
@@ -130,6 +146,8 @@ private:
 
   void calculate_gpu(vector<Vector> &deriv);
   void calculate_cpu(vector<Vector> &deriv);
+  void calculate_histogram(vector<Vector> &deriv, vector<double> &sum, const unsigned kstart);
+  void setup_sinc_tables(const unsigned nbins);
   void getMartiniSFparam(const vector<AtomNumber> &atoms, vector<vector<long double> > &parameter);
   double calculateASF(const vector<AtomNumber> &atoms, vector<vector<long double> > &FF_tmp, const double rho);
   void bessel_calculate(vector<Vector> &deriv, vector<double> &sum, vector<Vector2d> &qRnm, const vector<double> &r_polar,
@@ -159,6 +177,7 @@ void SAXS::registerKeywords(Keywords& keys) {
   keys.addFlag("FORCE_BESSEL",false,"Perform the calculation using the adaptive spherical harmonic approximation, without adaptive algorithm, useful for debug only");
   keys.add("compulsory","DEVICEID","0","Identifier of the GPU to be used");
   keys.addFlag("GPU",false,"calculate SAXS using ARRAYFIRE on an accelerator device");
+  keys.add("optional","HISTOGRAM_BIN","calculate SAXS from the histograms of the pair distances using bins of this width (in nm)");
   keys.addFlag("ATOMISTIC",false,"calculate SAXS for an atomistic model");
   keys.addFlag("MARTINI",false,"calculate SAXS for a Martini model");
   keys.add("atoms","ATOMS","The atoms to be included in the calculation, e.g. the whole protein.");
@@ -178,7 +197,10 @@ SAXS::SAXS(const ActionOptions&ao):
   bessel(false),
   force_bessel(false),
   gpu(false),
-  deviceid(0)
+  deviceid(0),
+  hist_bin(0.),
+  ntypes(0),
+  nbins_table(0)
 {
   vector<AtomNumber> atoms;
   parseAtomList("ATOMS",atoms);
@@ -213,6 +235,10 @@ SAXS::SAXS(const ActionOptions&ao):
 
   if(bessel&&gpu) error("You CANNOT use BESSEL on GPU!\n");
 
+  parse("HISTOGRAM_BIN",hist_bin);
+  if(hist_bin<0.) error("HISTOGRAM_BIN cannot be negative");
+  if(hist_bin>0.&&gpu) error("You CANNOT use HISTOGRAM_BIN on GPU!\n");
+
   unsigned ntarget=0;
   for(unsigned i=0;; ++i) {
     double t_list;
@@ -311,6 +337,28 @@ SAXS::SAXS(const ActionOptions&ao):
         FF_rank[k]+=FF_value[k][i]*FF_value[k][i];
       }
     }
+    if(hist_bin>0.) {
+      // atoms with the same structure factors for all the q values are binned together
+      map<vector<double>,unsigned> types;
+      FF_type.resize(size);
+      FF_atom.resize(size*numq);
+      for(unsigned i=0; i<size; i++) {
+        vector<double> FF_i(numq);
+        for(unsigned k=0; k<numq; ++k) {
+          FF_i[k] = FF_value[k][i];
+          FF_atom[i*numq+k] = FF_value[k][i];
+        }
+        map<vector<double>,unsigned>::const_iterator it=types.find(FF_i);
+        if(it==types.end()) {
+          FF_type[i] = types.size();
+          types.insert(make_pair(FF_i,FF_type[i]));
+          FF_type_value.push_back(FF_i);
+        } else {
+          FF_type[i] = it->second;
+        }
+      }
+      ntypes = types.size();
+    }
   } else {
     vector<float> FF_new;
     FF_new.resize(numq*size);
@@ -360,6 +408,10 @@ SAXS::SAXS(const ActionOptions&ao):
     q_list[i]=q_list[i]*10.0;    //factor 10 to convert from A^-1 to nm^-1
     if(bessel&&i>0&&q_list[i]<q_list[i-1]) plumed_merror("With BESSEL the Q values should be ordered from the smallest to the largest");
   }
+  if(hist_bin>0.) {
+    log.printf("  using histograms of the distances with bins of %lf nm for %u types of structure factors\n",hist_bin,ntypes);
+    log.printf("  maximum error on the contribution of each pair: %e\n",pow(q_list[numq-1]*hist_bin,2)/24.);
+  }
   log<<"  Bibliography ";
   if(martini) {
     log<<plumed.cite("Niebling, Björling, Westenhoff, J Appl Crystallogr 47, 1190–1198 (2014).");
@@ -494,8 +546,6 @@ void SAXS::calculate_cpu(vector<Vector> &deriv)
   }
 
   vector<double> sum(numq,0);
-  vector<Vector> c_dist(size*size);
-  vector<double> m_dist(size*size);
 
   vector<double> r_polar;
   vector<Vector2d> qRnm;
@@ -513,7 +563,12 @@ void SAXS::calculate_cpu(vector<Vector> &deriv)
     if(algorithm==-1) bessel=false;
   }
 
-  if(direct) {
+  if(direct&&hist_bin>0.) {
+    calculate_histogram(deriv, sum, algorithm+1);
+  } else if(direct) {
+    vector<Vector> c_dist(size*size);
+    vector<double> m_dist(size*size);
+
     #pragma omp parallel for num_threads(OpenMP::getNumThreads())
     for (unsigned i=rank; i<size-1; i+=stride) {
       const Vector posi=getPosition(i);
@@ -575,6 +630,125 @@ void SAXS::calculate_cpu(vector<Vector> &deriv)
   }
 }
 
+void SAXS::setup_sinc_tables(const unsigned nbins)
+{
+  const unsigned numq = q_list.size();
+  nbins_table = nbins;
+  sinc_table.resize(nbins*numq);
+  dsinc_table.resize(nbins*numq);
+  for(unsigned m=0; m<nbins; m++) {
+    const double r = m*hist_bin;
+    for(unsigned k=0; k<numq; k++) {
+      const double qr = q_list[k]*r;
+      if(m==0) {
+        sinc_table[k]  = 1.;
+        dsinc_table[k] = 0.;
+      } else {
+        sinc_table[m*numq+k]  = sin(qr)/qr;
+        dsinc_table[m*numq+k] = (cos(qr)-sin(qr)/qr)/r;
+      }
+    }
+  }
+}
+
+void SAXS::calculate_histogram(vector<Vector> &deriv, vector<double> &sum, const unsigned kstart)
+{
+  const unsigned size = getNumberOfAtoms();
+  const unsigned numq = q_list.size();
+  const unsigned nq = numq-kstart;
+  if(nq==0) return;
+
+  unsigned stride = comm.Get_size();
+  unsigned rank   = comm.Get_rank();
+  if(serial) {
+    stride = 1;
+    rank   = 0;
+  }
+
+  // the largest distance is bound by the diagonal of the box enclosing the atoms
+  Vector pmin = getPosition(0);
+  Vector pmax = getPosition(0);
+  for(unsigned i=1; i<size; i++) {
+    const Vector pos=getPosition(i);
+    for(unsigned l=0; l<3; l++) {
+      pmin[l] = min(pmin[l],pos[l]);
+      pmax[l] = max(pmax[l],pos[l]);
+    }
+  }
+  const unsigned nbins = static_cast<unsigned>((pmax-pmin).modulo()/hist_bin)+2;
+  if(nbins>nbins_table) setup_sinc_tables(nbins+nbins/10);
+
+  const double inv_bin = 1./hist_bin;
+  const unsigned npairs = ntypes*(ntypes+1)/2;
+  vector<double> hist(npairs*nbins,0.);
+
+  #pragma omp parallel num_threads(OpenMP::getNumThreads())
+  {
+    vector<double> omp_hist(npairs*nbins,0.);
+    // derivatives are accumulated with the q index running fastest
+    vector<Vector> omp_deriv(size*nq);
+    vector<Vector> dsum(nq);
+    #pragma omp for schedule(dynamic)
+    for (unsigned i=rank; i<size-1; i+=stride) {
+      const Vector posi=getPosition(i);
+      const unsigned ti=FF_type[i];
+      const double* FFi=&FF_atom[i*numq+kstart];
+      for(unsigned k=0; k<nq; k++) dsum[k].zero();
+      for (unsigned j=i+1; j<size ; j++) {
+        const Vector c_distances = delta(posi,getPosition(j));
+        const double m_distances = c_distances.modulo();
+        // linear assignment to the two closest bins
+        const double x   = m_distances*inv_bin;
+        const unsigned m = static_cast<unsigned>(x);
+        const double f   = x-m;
+        const unsigned tj = FF_type[j];
+        const unsigned p  = (ti<=tj) ? ti*ntypes-ti*(ti+1)/2+tj : tj*ntypes-tj*(tj+1)/2+ti;
+        omp_hist[p*nbins+m]   += 1.-f;
+        omp_hist[p*nbins+m+1] += f;
+        // forces from the interpolated derivative of sin(qr)/(qr)
+        const Vector u = c_distances/m_distances;
+        const double* dsinc0=&dsinc_table[m*numq+kstart];
+        const double* dsinc1=&dsinc_table[(m+1)*numq+kstart];
+        const double* FFj=&FF_atom[j*numq+kstart];
+        Vector* derivj=&omp_deriv[j*nq];
+        for (unsigned k=0; k<nq; k++) {
+          const double tmp = 2.*FFi[k]*FFj[k]*((1.-f)*dsinc0[k]+f*dsinc1[k]);
+          const Vector dd  = tmp*u;
+          dsum[k]   += dd;
+          derivj[k] += dd;
+        }
+      }
+      for(unsigned k=0; k<nq; k++) omp_deriv[i*nq+k] -= dsum[k];
+    }
+    #pragma omp critical
+    {
+      for(unsigned l=0; l<hist.size(); l++) hist[l] += omp_hist[l];
+      for(unsigned i=0; i<size; i++) {
+        for(unsigned k=0; k<nq; k++) deriv[(k+kstart)*size+i] += omp_deriv[i*nq+k];
+      }
+    }
+  }
+
+  // Debye equation applied to the histograms
+  vector<double> hsum(nq);
+  for(unsigned a=0; a<ntypes; a++) {
+    for(unsigned b=a; b<ntypes; b++) {
+      const unsigned p = a*ntypes-a*(a+1)/2+b;
+      fill(hsum.begin(),hsum.end(),0.);
+      bool empty = true;
+      for(unsigned m=0; m<nbins; m++) {
+        const double h = hist[p*nbins+m];
+        if(h==0.) continue;
+        empty = false;
+        const double* sinc=&sinc_table[m*numq+kstart];
+        for(unsigned k=0; k<nq; k++) hsum[k] += h*sinc[k];
+      }
+      if(empty) continue;
+      for(unsigned k=0; k<nq; k++) sum[k+kstart] += 2.*FF_type_value[a][k+kstart]*FF_type_value[b][k+kstart]*hsum[k];
+    }
+  }
+}
+
 void SAXS::calculate()
 {
   if(pbc) makeWhole();
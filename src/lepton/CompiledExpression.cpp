@@ -113,6 +113,30 @@ CompiledExpression::CompiledExpression(const ParsedExpression& expression) : jit
     ParsedExpression expr = expression.optimize(); // Just in case it wasn't already optimized.
     vector<pair<ExpressionTreeNode, int> > temps;
     compileExpression(expr.getRootNode(), temps);
+    resultIndex.push_back(findTempIndex(expr.getRootNode(), temps));
+    results.resize(1);
+    int maxArguments = 1;
+    for (int i = 0; i < (int) operation.size(); i++)
+        if (operation[i]->getNumArguments() > maxArguments)
+            maxArguments = operation[i]->getNumArguments();
+    argValues.resize(maxArguments);
+#ifdef __PLUMED_HAS_ASMJIT
+    if(useAsmJit()) generateJitCode();
+#endif
+}
+
+CompiledExpression::CompiledExpression(const vector<ParsedExpression>& expressions) : jitCode(NULL) {
+    if (expressions.size() == 0)
+        throw Exception("CompiledExpression: no expression to compile");
+    // All the expressions share the list of temporaries, so that nodes already
+    // compiled for one of them are reused by the following ones.
+    vector<pair<ExpressionTreeNode, int> > temps;
+    for (int i = 0; i < (int) expressions.size(); i++) {
+        ParsedExpression expr = expressions[i].optimize(); // Just in case it wasn't already optimized.
+        compileExpression(expr.getRootNode(), temps);
+        resultIndex.push_back(findTempIndex(expr.getRootNode(), temps));
+    }
+    results.resize(resultIndex.size());
     int maxArguments = 1;
     for (int i = 0; i < (int) operation.size(); i++)
         if (operation[i]->getNumArguments() > maxArguments)
@@ -136,6 +160,8 @@ CompiledExpression::CompiledExpression(const CompiledExpression& expression) : j
 CompiledExpression& CompiledExpression::operator=(const CompiledExpression& expression) {
     arguments = expression.arguments;
     target = expression.target;
+    resultIndex = expression.resultIndex;
+    results.resize(expression.results.size());
     variableIndices = expression.variableIndices;
     variableNames = expression.variableNames;
     workspace.resize(expression.workspace.size());
@@ -252,7 +278,13 @@ double CompiledExpression::evaluate() const {
             workspace[target[step]] = operation[step]->evaluate(&argValues[0], dummyVariables);
         }
     }
-    return workspace[workspace.size()-1];
+    for (int i = 0; i < (int) resultIndex.size(); i++)
+        results[i] = workspace[resultIndex[i]];
+    return results[0];
+}
+
+const vector<double>& CompiledExpression::getResults() const {
+    return results;
 }
 
 #ifdef __PLUMED_HAS_ASMJIT
@@ -460,7 +492,13 @@ void CompiledExpression::generateJitCode() {
                 call->setRet(0, workspaceVar[target[step]]);
         }
     }
-    c.ret(workspaceVar[workspace.size()-1]);
+    // Store the values of all the expressions.
+
+    X86Gp resultsPointer = c.newIntPtr();
+    c.mov(resultsPointer, imm_ptr(&results[0]));
+    for (int i = 0; i < (int) resultIndex.size(); i++)
+        c.movsd(x86::ptr(resultsPointer, 8*i, 0), workspaceVar[resultIndex[i]]);
+    c.ret(workspaceVar[resultIndex[0]]);
     c.endFunc();
     c.finalize();
     typedef double (*Func0)(void);
@@ -115,6 +115,13 @@ class ParsedExpression;
 class LEPTON_EXPORT CompiledExpression {
 public:
     CompiledExpression();
+    /**
+     * Create a CompiledExpression that evaluates several expressions at once, e.g. a function together with
+     * its derivatives.  The expressions share the same variables, and subexpressions that appear in more than
+     * one of them are only evaluated once.  After calling evaluate(), the value of each expression can be
+     * retrieved with getResults().
+     */
+    explicit CompiledExpression(const std::vector<ParsedExpression>& expressions);
     CompiledExpression(const CompiledExpression& expression);
     ~CompiledExpression();
     CompiledExpression& operator=(const CompiledExpression& expression);
@@ -135,8 +142,15 @@ public:
     void setVariableLocations(std::map<std::string, double*>& variableLocations);
     /**
      * Evaluate the expression.  The values of all variables should have been set before calling this.
+     * If several expressions were compiled together, all of them are evaluated and the value of the first
+     * one is returned.
      */
     double evaluate() const;
+    /**
+     * Get the values of all the expressions, in the order in which they were given when creating
+     * this CompiledExpression, as calculated by the last call to evaluate().
+     */
+    const std::vector<double>& getResults() const;
 private:
     friend class ParsedExpression;
     CompiledExpression(const ParsedExpression& expression);
@@ -147,6 +161,8 @@ private:
     std::vector<std::vector<int> > arguments;
     std::vector<int> target;
     std::vector<Operation*> operation;
+    std::vector<int> resultIndex;
+    mutable std::vector<double> results;
     std::map<std::string, int> variableIndices;
     std::set<std::string> variableNames;
     mutable std::vector<double> workspace;
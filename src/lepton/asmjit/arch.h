@@ -0,0 +1 @@
+#include "../../asmjit/arch.h"
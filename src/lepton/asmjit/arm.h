@@ -0,0 +1 @@
+#include "../../asmjit/arm.h"
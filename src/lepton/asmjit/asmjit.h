@@ -0,0 +1 @@
+#include "../../asmjit/asmjit.h"
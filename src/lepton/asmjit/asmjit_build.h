@@ -0,0 +1 @@
+#include "../../asmjit/asmjit_build.h"
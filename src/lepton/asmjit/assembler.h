@@ -0,0 +1 @@
+#include "../../asmjit/assembler.h"
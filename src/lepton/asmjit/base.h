@@ -0,0 +1 @@
+#include "../../asmjit/base.h"
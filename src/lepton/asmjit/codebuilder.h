@@ -0,0 +1 @@
+#include "../../asmjit/codebuilder.h"
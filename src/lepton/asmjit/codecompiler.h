@@ -0,0 +1 @@
+#include "../../asmjit/codecompiler.h"
@@ -0,0 +1 @@
+#include "../../asmjit/codeemitter.h"
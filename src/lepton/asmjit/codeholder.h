@@ -0,0 +1 @@
+#include "../../asmjit/codeholder.h"
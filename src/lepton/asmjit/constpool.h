@@ -0,0 +1 @@
+#include "../../asmjit/constpool.h"
@@ -0,0 +1 @@
+#include "../../asmjit/cpuinfo.h"
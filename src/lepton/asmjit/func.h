@@ -0,0 +1 @@
+#include "../../asmjit/func.h"
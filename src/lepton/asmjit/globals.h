@@ -0,0 +1 @@
+#include "../../asmjit/globals.h"
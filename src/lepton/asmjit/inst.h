@@ -0,0 +1 @@
+#include "../../asmjit/inst.h"
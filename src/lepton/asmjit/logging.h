@@ -0,0 +1 @@
+#include "../../asmjit/logging.h"
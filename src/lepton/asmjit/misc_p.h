@@ -0,0 +1 @@
+#include "../../asmjit/misc_p.h"
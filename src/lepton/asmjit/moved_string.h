@@ -0,0 +1 @@
+#include "../../asmjit/moved_string.h"
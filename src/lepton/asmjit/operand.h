@@ -0,0 +1 @@
+#include "../../asmjit/operand.h"
@@ -0,0 +1 @@
+#include "../../asmjit/osutils.h"
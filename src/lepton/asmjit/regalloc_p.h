@@ -0,0 +1 @@
+#include "../../asmjit/regalloc_p.h"
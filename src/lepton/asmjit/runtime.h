@@ -0,0 +1 @@
+#include "../../asmjit/runtime.h"
@@ -0,0 +1 @@
+#include "../../asmjit/simdtypes.h"
@@ -0,0 +1 @@
+#include "../../asmjit/utils.h"
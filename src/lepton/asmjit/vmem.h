@@ -0,0 +1 @@
+#include "../../asmjit/vmem.h"
@@ -0,0 +1 @@
+#include "../../asmjit/x86assembler.h"
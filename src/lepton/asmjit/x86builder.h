@@ -0,0 +1 @@
+#include "../../asmjit/x86builder.h"
@@ -0,0 +1 @@
+#include "../../asmjit/x86instimpl_p.h"
@@ -0,0 +1 @@
+#include "../../asmjit/x86internal_p.h"
@@ -0,0 +1 @@
+#include "../../asmjit/x86logging_p.h"
@@ -0,0 +1 @@
+#include "../../asmjit/x86operand.h"
@@ -0,0 +1 @@
+#include "../../asmjit/x86regalloc_p.h"
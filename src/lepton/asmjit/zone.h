@@ -0,0 +1 @@
+#include "../../asmjit/zone.h"
@@ -410,6 +410,7 @@ public:
   explicit LogMFD(const ActionOptions&);
   void calculate();
   void update();
+  bool isHistoryDependent()const override {return true;}
   void updateNVE();
   void updateNVT();
   void updateVS();
@@ -45,7 +45,11 @@ int main(int argc,char**argv) {
 // stop at first non-option
     if(argv[iarg] && argv[iarg][0]!='-') break;
   }
-  if(!nompi) MPI_Init(&argc,&argv);
+// MPI_THREAD_SERIALIZED allows actions to be calculated concurrently (see DEBUG PARALLEL_ACTIONS)
+  if(!nompi) {
+    int provided;
+    MPI_Init_thread(&argc,&argv,MPI_THREAD_SERIALIZED,&provided);
+  }
 #endif
   int ret=0;
 
@@ -100,6 +100,7 @@ public:
   double getLambda() { return 0.0; }
   double transformHD( const double& dist, double& df ) const ;
   void update();
+  bool isHistoryDependent()const override {return true;}
 };
 
 PLUMED_REGISTER_ACTION(AdaptivePath,"ADAPTIVE_PATH")
@@ -36,7 +36,7 @@ public:
   explicit SpathVessel( const vesselbase::VesselOptions& da );
   std::string value_descriptor();
   void prepare();
-  void calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_index ) const ;
+  void calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_index ) const ;
 };
 
 PLUMED_REGISTER_VESSEL(SpathVessel,"SPATH")
@@ -72,7 +72,7 @@ void SpathVessel::prepare() {
   foundoneclose=false;
 }
 
-void SpathVessel::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_index ) const {
+void SpathVessel::calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_index ) const {
   double pp=mymap->getPropertyValue( current, getLabel() ), weight=myvals.get(0);
   if( weight<getTolerance() ) return;
   unsigned nderivatives=getFinalValue()->getNumberOfDerivatives();
@@ -0,0 +1,73 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "AccumulationBuffer.h"
+#include <algorithm>
+
+namespace PLMD {
+
+AccumulationBuffer::AccumulationBuffer( std::vector<double>& dense ):
+  target(&dense),
+  nsize(dense.size()),
+  maxelements(0)
+{
+}
+
+AccumulationBuffer::AccumulationBuffer( const unsigned& n ):
+  target(NULL),
+  nsize(n),
+  maxelements(1024)
+{
+}
+
+void AccumulationBuffer::compact() {
+  if( target || values.size()>0 ) return;
+  std::sort( elements.begin(), elements.end() );
+  unsigned n=0;
+  for(unsigned i=0; i<elements.size(); ++i) {
+    if( n>0 && elements[n-1].first==elements[i].first ) elements[n-1].second+=elements[i].second;
+    else elements[n++]=elements[i];
+  }
+  elements.resize( n );
+// An index and a value are stored per element, a dense vector is smaller
+  if( 2*n>nsize ) {
+    values.assign( nsize, 0.0 );
+    for(unsigned i=0; i<n; ++i) values[elements[i].first]=elements[i].second;
+    std::vector<std::pair<unsigned,double> >().swap( elements );
+    return;
+  }
+  if( 2*n>maxelements ) maxelements=2*n;
+}
+
+void AccumulationBuffer::addTo( const unsigned& begin, const unsigned& end, std::vector<double>& dense ) const {
+  plumed_dbg_assert( begin<=end && end<=nsize && dense.size()==nsize );
+  if( target ) {
+    for(unsigned i=begin; i<end; ++i) dense[i]+=(*target)[i];
+  } else if( values.size()>0 ) {
+    for(unsigned i=begin; i<end; ++i) dense[i]+=values[i];
+  } else {
+    auto it=std::lower_bound( elements.begin(), elements.end(), begin,
+    [](const std::pair<unsigned,double>& e, const unsigned& i) { return e.first<i; } );
+    for(; it!=elements.end() && it->first<end; ++it) dense[it->first]+=it->second;
+  }
+}
+
+}
@@ -0,0 +1,92 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_AccumulationBuffer_h
+#define __PLUMED_tools_AccumulationBuffer_h
+
+#include <vector>
+#include <utility>
+#include "Exception.h"
+
+namespace PLMD {
+
+/**
+\ingroup TOOLBOX
+A buffer to which contributions are added with buffer[i]+=value.
+
+The contributions are either added directly to a dense std::vector or stored as
+compact (index,value) pairs, so that the memory used scales with the number of
+non-zero elements rather than with the size of the buffer.  This is used by the
+OpenMP threads in PLMD::vesselbase::ActionWithVessel::runAllTasks, as each task only
+contributes to the derivatives that are active in its PLMD::MultiValue.
+The compact buffers of the threads are then added to the dense one with addTo.
+When the non-zero elements are more than half of the buffer the pairs are
+converted to a dense vector, which is then cheaper.
+*/
+class AccumulationBuffer {
+/// The dense vector the contributions are added to in dense mode
+  std::vector<double>* target;
+/// The size of the buffer
+  unsigned nsize;
+/// The dense values once too many elements are non-zero
+  std::vector<double> values;
+/// The (index,value) pairs
+  std::vector<std::pair<unsigned,double> > elements;
+/// The number of pairs above which they are compacted
+  unsigned maxelements;
+public:
+/// An element of the buffer, contributions can only be added to it
+  class Element {
+    AccumulationBuffer& buffer;
+    const unsigned index;
+  public:
+    Element( AccumulationBuffer& b, const unsigned& i ) : buffer(b), index(i) {}
+    Element& operator+=( const double& v ) { buffer.add( index, v ); return *this; }
+  };
+/// Add the contributions directly to a dense vector
+  explicit AccumulationBuffer( std::vector<double>& dense );
+/// Store the contributions to a buffer of size n as (index,value) pairs
+  explicit AccumulationBuffer( const unsigned& n=0 );
+/// Get the size of the buffer
+  unsigned size() const { return nsize; }
+/// Add a contribution to element i
+  void add( const unsigned& i, const double& v );
+/// Access element i
+  Element operator[]( const unsigned& i ) { return Element( *this, i ); }
+/// Sort the pairs and sum the ones with the same index
+  void compact();
+/// Add the elements with index in [begin,end) to a dense vector, compact must be called before
+  void addTo( const unsigned& begin, const unsigned& end, std::vector<double>& dense ) const ;
+};
+
+inline
+void AccumulationBuffer::add( const unsigned& i, const double& v ) {
+  plumed_dbg_assert( i<nsize );
+  if( target ) { (*target)[i]+=v; return; }
+  if( values.size()>0 ) { values[i]+=v; return; }
+  if( v==0.0 ) return;
+  elements.push_back( std::pair<unsigned,double>( i, v ) );
+  if( elements.size()>maxelements ) compact();
+}
+
+}
+
+#endif
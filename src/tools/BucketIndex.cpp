@@ -0,0 +1,194 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2014-2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "BucketIndex.h"
+#include "Exception.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+namespace PLMD {
+
+BucketIndex::BucketIndex(const std::vector<bool>& periodic,const std::vector<double>& min,const std::vector<double>& max,unsigned maxbuckets):
+  dimension_(periodic.size()),
+  periodic_(periodic),
+  min_(min),
+  period_(dimension_,0.0),
+  nbuckets_(dimension_,0),
+  maxbuckets_(maxbuckets),
+  nobjects_(0)
+{
+  plumed_assert(min.size()==dimension_ && max.size()==dimension_);
+  for(unsigned i=0; i<dimension_; ++i) if(periodic_[i]) {
+      period_[i]=max[i]-min[i];
+      plumed_assert(period_[i]>0.0);
+    }
+}
+
+long BucketIndex::getBucket(unsigned i,double x) const {
+  if(periodic_[i]) {
+    long n=static_cast<long>(std::floor((x-min_[i])/width_[i]))%nbuckets_[i];
+    if(n<0) n+=nbuckets_[i];
+    return n;
+  }
+  // avoid overflows for points that are very far away
+  double b=std::floor(x/width_[i]);
+  const double big=1e15;
+  if(b>big) b=big;
+  if(b<-big) b=-big;
+  return static_cast<long>(b);
+}
+
+std::uint64_t BucketIndex::hash(const std::vector<long>& indices) {
+  // collisions only add spurious candidates, so a simple mixing is sufficient
+  std::uint64_t h=1469598103934665603ULL;
+  for(unsigned i=0; i<indices.size(); ++i) {
+    h^=static_cast<std::uint64_t>(indices[i])+0x9e3779b97f4a7c15ULL+(h<<6)+(h>>2);
+    h*=1099511628211ULL;
+  }
+  return h;
+}
+
+void BucketIndex::setWidth(const std::vector<double>& halfwidth) {
+  width_.resize(dimension_);
+  for(unsigned i=0; i<dimension_; ++i) {
+    width_[i]=2.0*halfwidth[i];
+    if(periodic_[i]) {
+      nbuckets_[i]=std::max(1L,static_cast<long>(std::floor(period_[i]/width_[i])));
+      width_[i]=period_[i]/nbuckets_[i];
+    }
+  }
+}
+
+bool BucketIndex::insert(unsigned id,const double* center,const double* halfwidth) {
+  // range of buckets along each dimension, the box is slightly enlarged to be safe against rounding
+  std::vector<long> first(dimension_),nb(dimension_);
+  double ntot=1.0;
+  for(unsigned i=0; i<dimension_; ++i) {
+    const double hw=halfwidth[i]*(1.0+1e-8);
+    if(periodic_[i]) {
+      double lo=std::floor((center[i]-hw-min_[i])/width_[i]);
+      double hi=std::floor((center[i]+hw-min_[i])/width_[i]);
+      if(hi-lo+1>=nbuckets_[i]) {first[i]=0; nb[i]=nbuckets_[i];}
+      else {first[i]=getBucket(i,center[i]-hw); nb[i]=static_cast<long>(hi-lo)+1;}
+    } else {
+      first[i]=getBucket(i,center[i]-hw);
+      nb[i]=getBucket(i,center[i]+hw)-first[i]+1;
+    }
+    ntot*=nb[i];
+  }
+  if(ntot>maxbuckets_) return false;
+
+  std::vector<long> indices(dimension_);
+  for(unsigned n=0; n<static_cast<unsigned>(ntot); ++n) {
+    unsigned k=n;
+    for(unsigned i=0; i<dimension_; ++i) {
+      indices[i]=first[i]+k%nb[i];
+      if(periodic_[i]) indices[i]%=nbuckets_[i];
+      k/=nb[i];
+    }
+    std::vector<unsigned>& b(buckets_[hash(indices)]);
+    // buckets colliding in the hash should not store the same object twice
+    if(b.empty() || b.back()!=id) {
+      plumed_massert(b.empty() || b.back()<id,"objects should be added with increasing index");
+      b.push_back(id);
+    }
+  }
+  return true;
+}
+
+void BucketIndex::add(unsigned id,const std::vector<double>& center,const std::vector<double>& halfwidth) {
+  plumed_assert(center.size()==dimension_ && halfwidth.size()==dimension_);
+  nobjects_++;
+  bool global=false;
+  for(unsigned i=0; i<dimension_; ++i) if(!(halfwidth[i]>0.0) || !std::isfinite(halfwidth[i])) global=true;
+  if(global) {global_.push_back(id); return;}
+
+  if(width_.empty()) setWidth(halfwidth);
+  else {
+    // buckets are enlarged when the object does not fit in them, the new size is doubled
+    // so that the objects are redistributed only a logarithmic number of times
+    bool grow=false;
+    std::vector<double> hw(dimension_);
+    for(unsigned i=0; i<dimension_; ++i) {
+      hw[i]=0.5*width_[i];
+      if(2.0*halfwidth[i]>width_[i] && !(periodic_[i] && nbuckets_[i]==1)) {
+        hw[i]=2.0*halfwidth[i];
+        grow=true;
+      }
+    }
+    if(grow) {
+      setWidth(hw);
+      buckets_.clear();
+      std::vector<unsigned> ids;
+      std::vector<double> centers, halfwidths;
+      ids.swap(ids_); centers.swap(centers_); halfwidths.swap(halfwidths_);
+      std::vector<unsigned> large;
+      for(unsigned n=0; n<ids.size(); ++n) {
+        if(insert(ids[n],&centers[n*dimension_],&halfwidths[n*dimension_])) {
+          ids_.push_back(ids[n]);
+          centers_.insert(centers_.end(),&centers[n*dimension_],&centers[n*dimension_]+dimension_);
+          halfwidths_.insert(halfwidths_.end(),&halfwidths[n*dimension_],&halfwidths[n*dimension_]+dimension_);
+        } else large.push_back(ids[n]);
+      }
+      if(!large.empty()) {
+        std::vector<unsigned> merged(global_.size()+large.size());
+        std::merge(global_.begin(),global_.end(),large.begin(),large.end(),merged.begin());
+        global_.swap(merged);
+      }
+    }
+  }
+
+  if(!insert(id,center.data(),halfwidth.data())) {global_.push_back(id); return;}
+  ids_.push_back(id);
+  centers_.insert(centers_.end(),center.begin(),center.end());
+  halfwidths_.insert(halfwidths_.end(),halfwidth.begin(),halfwidth.end());
+}
+
+void BucketIndex::getCandidates(const std::vector<double>& x,std::vector<unsigned>& ids) const {
+  plumed_assert(x.size()==dimension_);
+  ids.clear();
+  const std::vector<unsigned>* local=NULL;
+  if(!width_.empty()) {
+    std::vector<long> indices(dimension_);
+    for(unsigned i=0; i<dimension_; ++i) indices[i]=getBucket(i,x[i]);
+    auto it=buckets_.find(hash(indices));
+    if(it!=buckets_.end()) local=&(it->second);
+  }
+  if(!local) ids=global_;
+  else if(global_.empty()) ids=*local;
+  else {
+    ids.resize(local->size()+global_.size());
+    std::merge(local->begin(),local->end(),global_.begin(),global_.end(),ids.begin());
+  }
+}
+
+void BucketIndex::clear() {
+  buckets_.clear();
+  global_.clear();
+  width_.clear();
+  ids_.clear();
+  centers_.clear();
+  halfwidths_.clear();
+  nobjects_=0;
+}
+
+}
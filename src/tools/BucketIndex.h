@@ -0,0 +1,100 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2014-2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_BucketIndex_h
+#define __PLUMED_tools_BucketIndex_h
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace PLMD {
+
+/// \ingroup TOOLBOX
+/// A spatial index for objects with a finite support in a low dimensional space.
+/// The space is divided in buckets and every object is stored in the buckets overlapping
+/// with the box that bounds its support. A query returns the objects stored in the bucket
+/// containing the query point, so that its cost grows with the local density of objects
+/// and not with their total number. Buckets are at least as large as the widest object
+/// that has been added, so that every object is stored in at most two buckets per dimension.
+/// When a wider object is added all the objects are redistributed in larger buckets. Objects are identified by an index that must be increasing with the
+/// order of insertion, and queries return them in increasing order.
+/// Periodic dimensions are wrapped, unbounded dimensions are hashed.
+class BucketIndex {
+private:
+/// Dimensionality of the space
+  unsigned dimension_;
+/// Periodicity of each dimension
+  std::vector<bool> periodic_;
+/// Lower boundary and period of periodic dimensions
+  std::vector<double> min_, period_;
+/// Size of the buckets
+  std::vector<double> width_;
+/// Number of buckets along periodic dimensions
+  std::vector<long> nbuckets_;
+/// Maximum number of buckets an object can be stored in
+  unsigned maxbuckets_;
+/// The buckets, identified by a hash of their indices
+  std::unordered_map<std::uint64_t,std::vector<unsigned> > buckets_;
+/// Objects that are too large and are thus returned by every query
+  std::vector<unsigned> global_;
+/// Total number of objects
+  unsigned nobjects_;
+/// Indexes, centers and half widths of the objects stored in buckets, used to redistribute them
+  std::vector<unsigned> ids_;
+  std::vector<double> centers_, halfwidths_;
+/// Choose the size of the buckets so that they can hold objects with a given half width
+  void setWidth(const std::vector<double>& halfwidth);
+/// Store an object in the buckets, return false if it is too large
+  bool insert(unsigned id,const double* center,const double* halfwidth);
+/// Bucket index along dimension i
+  long getBucket(unsigned i,double x) const;
+/// Hash of the indices of a bucket
+  static std::uint64_t hash(const std::vector<long>& indices);
+public:
+/// Constructor: min and max are only used for periodic dimensions
+  BucketIndex(const std::vector<bool>& periodic,const std::vector<double>& min,const std::vector<double>& max,unsigned maxbuckets=4096);
+/// Add an object with a given center and half width of its bounding box.
+/// A non finite or zero half width makes the object global.
+  void add(unsigned id,const std::vector<double>& center,const std::vector<double>& halfwidth);
+/// Get all the objects whose support might include x, sorted by index
+  void getCandidates(const std::vector<double>& x,std::vector<unsigned>& ids) const;
+/// Remove all the objects
+  void clear();
+/// Number of objects
+  unsigned size() const;
+/// Number of allocated buckets
+  unsigned getNumberOfBuckets() const;
+};
+
+inline
+unsigned BucketIndex::size() const {
+  return nobjects_;
+}
+
+inline
+unsigned BucketIndex::getNumberOfBuckets() const {
+  return buckets_.size();
+}
+
+}
+
+#endif
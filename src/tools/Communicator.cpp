@@ -23,11 +23,26 @@
 #include "Exception.h"
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <atomic>
 
 using namespace std;
 
 namespace PLMD {
 
+namespace {
+/// Serializes MPI calls while actions are calculated concurrently.
+/// The mutex is recursive since some wrappers call other wrappers.
+std::recursive_mutex callMutex;
+std::atomic<int> callsSerialized(0);
+
+std::unique_lock<std::recursive_mutex> callLock() {
+  std::unique_lock<std::recursive_mutex> lock(callMutex,std::defer_lock);
+  if(callsSerialized.load(std::memory_order_relaxed)>0) lock.lock();
+  return lock;
+}
+}
+
 Communicator::Communicator()
 #ifdef __PLUMED_HAS_MPI
   : communicator(MPI_COMM_SELF)
@@ -49,6 +64,7 @@ Communicator& Communicator::operator=(const Communicator&pc) {
 }
 
 int Communicator::Get_rank()const {
+  auto lock=callLock();
   int r=0;
 #ifdef __PLUMED_HAS_MPI
   if(initialized()) MPI_Comm_rank(communicator,&r);
@@ -57,6 +73,7 @@ int Communicator::Get_rank()const {
 }
 
 int Communicator::Get_size()const {
+  auto lock=callLock();
   int s=1;
 #ifdef __PLUMED_HAS_MPI
   if(initialized()) MPI_Comm_size(communicator,&s);
@@ -116,6 +133,7 @@ void Communicator::Abort(int errorcode) {
 }
 
 void Communicator::Bcast(Data data,int root) {
+  auto lock=callLock();
 #if defined(__PLUMED_HAS_MPI)
   if(initialized()) MPI_Bcast(data.pointer,data.size,data.type,root,communicator);
 #else
@@ -125,6 +143,7 @@ void Communicator::Bcast(Data data,int root) {
 }
 
 void Communicator::Sum(Data data) {
+  auto lock=callLock();
 #if defined(__PLUMED_HAS_MPI)
   if(initialized()) MPI_Allreduce(MPI_IN_PLACE,data.pointer,data.size,data.type,MPI_SUM,communicator);
 #else
@@ -133,6 +152,7 @@ void Communicator::Sum(Data data) {
 }
 
 void Communicator::Prod(Data data) {
+  auto lock=callLock();
 #if defined(__PLUMED_HAS_MPI)
   if(initialized()) MPI_Allreduce(MPI_IN_PLACE,data.pointer,data.size,data.type,MPI_PROD,communicator);
 #else
@@ -141,6 +161,7 @@ void Communicator::Prod(Data data) {
 }
 
 void Communicator::Max(Data data) {
+  auto lock=callLock();
 #if defined(__PLUMED_HAS_MPI)
   if(initialized()) MPI_Allreduce(MPI_IN_PLACE,data.pointer,data.size,data.type,MPI_MAX,communicator);
 #else
@@ -149,6 +170,7 @@ void Communicator::Max(Data data) {
 }
 
 void Communicator::Min(Data data) {
+  auto lock=callLock();
 #if defined(__PLUMED_HAS_MPI)
   if(initialized()) MPI_Allreduce(MPI_IN_PLACE,data.pointer,data.size,data.type,MPI_MIN,communicator);
 #else
@@ -157,6 +179,7 @@ void Communicator::Min(Data data) {
 }
 
 Communicator::Request Communicator::Isend(ConstData data,int source,int tag) {
+  auto lock=callLock();
   Request req;
 #ifdef __PLUMED_HAS_MPI
   plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
@@ -172,6 +195,7 @@ Communicator::Request Communicator::Isend(ConstData data,int source,int tag) {
 }
 
 void Communicator::Allgatherv(ConstData in,Data out,const int*recvcounts,const int*displs) {
+  auto lock=callLock();
   void*s=const_cast<void*>((const void*)in.pointer);
   void*r=const_cast<void*>((const void*)out.pointer);
   int*rc=const_cast<int*>(recvcounts);
@@ -199,6 +223,7 @@ void Communicator::Allgatherv(ConstData in,Data out,const int*recvcounts,const i
 }
 
 void Communicator::Allgather(ConstData in,Data out) {
+  auto lock=callLock();
   void*s=const_cast<void*>((const void*)in.pointer);
   void*r=const_cast<void*>((const void*)out.pointer);
 #if defined(__PLUMED_HAS_MPI)
@@ -218,6 +243,7 @@ void Communicator::Allgather(ConstData in,Data out) {
 }
 
 void Communicator::Recv(Data data,int source,int tag,Status&status) {
+  auto lock=callLock();
 #ifdef __PLUMED_HAS_MPI
   plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
   if(&status==&StatusIgnore) MPI_Recv(data.pointer,data.size,data.type,source,tag,communicator,MPI_STATUS_IGNORE);
@@ -236,6 +262,7 @@ void Communicator::Recv(Data data,int source,int tag,Status&status) {
 
 
 void Communicator::Barrier()const {
+  auto lock=callLock();
 #ifdef __PLUMED_HAS_MPI
   if(initialized()) MPI_Barrier(communicator);
 #endif
@@ -245,6 +272,22 @@ MPI_Comm & Communicator::Get_comm() {
   return communicator;
 }
 
+bool Communicator::threadsSupported() {
+#if defined(__PLUMED_HAS_MPI)
+  if(initialized()) {
+    int provided;
+    MPI_Query_thread(&provided);
+    return provided>=MPI_THREAD_SERIALIZED;
+  }
+#endif
+  return true;
+}
+
+void Communicator::serializeCalls(bool s) {
+  if(s) callsSerialized++;
+  else callsSerialized--;
+}
+
 bool Communicator::initialized() {
 #if defined(__PLUMED_HAS_MPI)
   int flag=0;
@@ -256,6 +299,7 @@ bool Communicator::initialized() {
 }
 
 void Communicator::Request::wait(Status&s) {
+  auto lock=callLock();
 #ifdef __PLUMED_HAS_MPI
   plumed_massert(initialized(),"you are trying to use an MPI function, but MPI is not initialized");
   if(&s==&StatusIgnore) MPI_Wait(&r,MPI_STATUS_IGNORE);
@@ -284,6 +328,7 @@ template<> MPI_Datatype Communicator::getMPIType<long unsigned>() { return MPI_D
 
 
 void Communicator::Split(int color,int key,Communicator&pc)const {
+  auto lock=callLock();
 #ifdef __PLUMED_HAS_MPI
   MPI_Comm_split(communicator,color,key,&pc.communicator);
 #else
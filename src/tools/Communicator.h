@@ -171,6 +171,11 @@ public:
   void Barrier()const;
 /// Tests if MPI library is initialized
   static bool initialized();
+/// Tests if MPI can be called from threads other than the main one, one at a time
+/// (i.e. MPI was initialized with at least MPI_THREAD_SERIALIZED). True if MPI is not initialized
+  static bool threadsSupported();
+/// Serialize the MPI calls done by all the communicators among threads, until it is called again with false
+  static void serializeCalls(bool);
 /// Wrapper for MPI_Allreduce with MPI_SUM (data struct)
   void Sum(Data);
 /// Wrapper for MPI_Allreduce with MPI_SUM (pointer)
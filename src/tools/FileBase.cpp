@@ -114,6 +114,7 @@ FileBase::FileBase():
   eof(false),
   err(false),
   heavyFlush(false),
+  binary(false),
   enforcedSuffix_(false)
 {
 }
@@ -160,6 +161,12 @@ FileBase& FileBase::enforceSuffix(const std::string&suffix) {
   return *this;
 }
 
+std::string FileBase::getBinaryHeader() {
+  const unsigned one=1;
+  if(*reinterpret_cast<const char*>(&one)==1) return "#! BINARY little_endian";
+  else return "#! BINARY big_endian";
+}
+
 std::string FileBase::getSuffix()const {
   if(enforcedSuffix_) return enforcedSuffix;
   if(plumed) return plumed->getSuffix();
@@ -79,6 +79,13 @@ protected:
   std::string mode;
 /// Set to true if you want flush to be heavy (close/reopen)
   bool heavyFlush;
+/// Set to true for files with fields written in binary format
+  bool binary;
+/// Tag written before each line of values in binary files.
+/// Header lines start with '#' and are written as text.
+  static const char binaryRecordTag='\0';
+/// First line of binary files, which includes the byte order of the machine writing them
+  static std::string getBinaryHeader();
 public:
 /// Append suffix.
 /// It appends the desired suffix to the string. Notice that
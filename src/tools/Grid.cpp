@@ -36,6 +36,7 @@
 #include <cstdio>
 #include <cfloat>
 #include <array>
+#include <algorithm>
 
 using namespace std;
 namespace PLMD {
@@ -651,8 +652,8 @@ void Grid::writeCubeFile(OFile& ofile, const double& lunit) {
 
 std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile,
                                    const vector<std::string> & gmin,const vector<std::string> & gmax,
-                                   const vector<unsigned> & nbin,bool dosparse, bool dospline, bool doder) {
-  std::unique_ptr<Grid> grid=Grid::create(funcl,args,ifile,dosparse,dospline,doder);
+                                   const vector<unsigned> & nbin,bool dosparse, bool dospline, bool doder, bool doblocks) {
+  std::unique_ptr<Grid> grid=Grid::create(funcl,args,ifile,dosparse,dospline,doder,doblocks);
   std::vector<unsigned> cbin( grid->getNbin() );
   std::vector<std::string> cmin( grid->getMin() ), cmax( grid->getMax() );
   for(unsigned i=0; i<args.size(); ++i) {
@@ -667,7 +668,7 @@ std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<V
   return grid;
 }
 
-std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile, bool dosparse, bool dospline, bool doder)
+std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile, bool dosparse, bool dospline, bool doder, bool doblocks)
 {
   std::unique_ptr<Grid> grid;
   unsigned nvar=args.size(); bool hasder=false; std::string pstring;
@@ -703,7 +704,8 @@ std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<V
     }
   }
 
-  if(!dosparse) {grid.reset(new Grid(funcl,args,gmin,gmax,gbin,dospline,doder));}
+  if(doblocks) {grid.reset(new BlockSparseGrid(funcl,args,gmin,gmax,gbin,dospline,doder));}
+  else if(!dosparse) {grid.reset(new Grid(funcl,args,gmin,gmax,gbin,dospline,doder));}
   else {grid.reset(new SparseGrid(funcl,args,gmin,gmax,gbin,dospline,doder));}
 
   vector<double> xx(nvar),dder(nvar);
@@ -858,6 +860,249 @@ void SparseGrid::writeToFile(OFile& ofile) {
 }
 
 
+BlockSparseGrid::BlockSparseGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
+                                 const std::vector<std::string> & gmax,
+                                 const std::vector<unsigned> & nbin, bool dospline, bool usederiv):
+  Grid(funcl,args,gmin,gmax,nbin,dospline,usederiv,false),
+  blockbins_(dimension_),
+  nblocks_(dimension_),
+  blocksize_(1),
+  totalblocks_(1)
+{
+// blocks contain about 4096 points, with the same number of bins on each side
+  const unsigned side=std::max(2u,static_cast<unsigned>(std::floor(std::pow(4096.0,1.0/dimension_)+1.0e-8)));
+  for(unsigned j=0; j<dimension_; ++j) {
+    blockbins_[j]=std::min(side,nbin_[j]);
+    nblocks_[j]=(nbin_[j]+blockbins_[j]-1)/blockbins_[j];
+    blocksize_*=blockbins_[j];
+    totalblocks_*=nblocks_[j];
+  }
+}
+
+void BlockSparseGrid::clear() {
+  blocks_.clear();
+}
+
+unsigned BlockSparseGrid::getNumberOfBlocks() const {
+  return blocks_.size();
+}
+
+unsigned BlockSparseGrid::getBlockSize() const {
+  return blocksize_;
+}
+
+void BlockSparseGrid::locate(index_t index, index_t& block, unsigned& offset) const {
+  plumed_dbg_assert(index<maxsize_);
+  index_t kk=index;
+  index_t bstride=1;
+  unsigned ostride=1;
+  block=0; offset=0;
+  for(unsigned j=0; j<dimension_; ++j) {
+    const unsigned ind=kk%nbin_[j];
+    kk/=nbin_[j];
+    block+=(ind/blockbins_[j])*bstride;
+    offset+=(ind%blockbins_[j])*ostride;
+    bstride*=nblocks_[j];
+    ostride*=blockbins_[j];
+  }
+}
+
+bool BlockSparseGrid::getGlobalIndex(index_t block, unsigned offset, index_t& index) const {
+  index_t stride=1;
+  index=0;
+  for(unsigned j=0; j<dimension_; ++j) {
+    const unsigned ind=(block%nblocks_[j])*blockbins_[j]+offset%blockbins_[j];
+    if(ind>=nbin_[j]) return false;
+    block/=nblocks_[j];
+    offset/=blockbins_[j];
+    index+=ind*stride;
+    stride*=nbin_[j];
+  }
+  return true;
+}
+
+BlockSparseGrid::Block& BlockSparseGrid::getBlock(index_t block) {
+  auto it=blocks_.find(block);
+  if(it!=blocks_.end()) return it->second;
+  Block & newblock(blocks_[block]);
+  newblock.value.assign(blocksize_,0.0);
+  if(usederiv_) newblock.der.assign(blocksize_*dimension_,0.0);
+  return newblock;
+}
+
+bool BlockSparseGrid::isAllocated(index_t block) const {
+  return blocks_.find(block)!=blocks_.end();
+}
+
+void BlockSparseGrid::allocateAllBlocks() {
+  for(index_t block=0; block<totalblocks_; ++block) getBlock(block);
+}
+
+double BlockSparseGrid::getValue(index_t index) const {
+  index_t block; unsigned offset;
+  locate(index,block,offset);
+  const auto it=blocks_.find(block);
+  if(it==blocks_.end()) return 0.0;
+  return it->second.value[offset];
+}
+
+double BlockSparseGrid::getMinValue() const {
+// points outside the allocated blocks are zero
+  double minval=DBL_MAX;
+  if(blocks_.size()<totalblocks_) minval=0.0;
+  for(const auto & it : blocks_) {
+    for(unsigned i=0; i<blocksize_; ++i) {
+      index_t index;
+      if(getGlobalIndex(it.first,i,index) && it.second.value[i]<minval) minval=it.second.value[i];
+    }
+  }
+  return minval;
+}
+
+double BlockSparseGrid::getMaxValue() const {
+// points outside the allocated blocks are zero
+  double maxval=-DBL_MAX;
+  if(blocks_.size()<totalblocks_) maxval=0.0;
+  for(const auto & it : blocks_) {
+    for(unsigned i=0; i<blocksize_; ++i) {
+      index_t index;
+      if(getGlobalIndex(it.first,i,index) && it.second.value[i]>maxval) maxval=it.second.value[i];
+    }
+  }
+  return maxval;
+}
+
+double BlockSparseGrid::getValueAndDerivatives(index_t index, vector<double>& der) const {
+  plumed_dbg_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
+  index_t block; unsigned offset;
+  locate(index,block,offset);
+  const auto it=blocks_.find(block);
+  if(it==blocks_.end()) {
+    for(unsigned j=0; j<dimension_; ++j) der[j]=0.0;
+    return 0.0;
+  }
+  const double* d=&it->second.der[offset*dimension_];
+  for(unsigned j=0; j<dimension_; ++j) der[j]=d[j];
+  return it->second.value[offset];
+}
+
+void BlockSparseGrid::setValue(index_t index, double value) {
+  plumed_dbg_assert(index<maxsize_ && !usederiv_);
+  index_t block; unsigned offset;
+  locate(index,block,offset);
+// points in blocks that do not exist are already zero (e.g. when a dense grid is read from file)
+  if(value==0.0 && !isAllocated(block)) return;
+  getBlock(block).value[offset]=value;
+}
+
+void BlockSparseGrid::setValueAndDerivatives(index_t index, double value, vector<double>& der) {
+  plumed_dbg_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
+  index_t block; unsigned offset;
+  locate(index,block,offset);
+  if(value==0.0 && !isAllocated(block)) {
+    bool allzero=true;
+    for(unsigned j=0; j<dimension_; ++j) if(der[j]!=0.0) allzero=false;
+    if(allzero) return;
+  }
+  Block & b(getBlock(block));
+  b.value[offset]=value;
+  for(unsigned j=0; j<dimension_; ++j) b.der[offset*dimension_+j]=der[j];
+}
+
+void BlockSparseGrid::addValue(index_t index, double value) {
+  plumed_dbg_assert(index<maxsize_ && !usederiv_);
+  index_t block; unsigned offset;
+  locate(index,block,offset);
+// adding zero to a block that does not exist would allocate it for nothing
+  if(value==0.0 && !isAllocated(block)) return;
+  getBlock(block).value[offset]+=value;
+}
+
+void BlockSparseGrid::addValueAndDerivatives(index_t index, double value, vector<double>& der) {
+  plumed_dbg_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
+  index_t block; unsigned offset;
+  locate(index,block,offset);
+  if(value==0.0 && !isAllocated(block)) {
+    bool allzero=true;
+    for(unsigned j=0; j<dimension_; ++j) if(der[j]!=0.0) allzero=false;
+    if(allzero) return;
+  }
+  Block & b(getBlock(block));
+  b.value[offset]+=value;
+  for(unsigned j=0; j<dimension_; ++j) b.der[offset*dimension_+j]+=der[j];
+}
+
+void BlockSparseGrid::scaleAllValuesAndDerivatives( const double& scalef ) {
+  for(auto & it : blocks_) {
+    for(auto & v : it.second.value) v*=scalef;
+    for(auto & d : it.second.der) d*=scalef;
+  }
+}
+
+void BlockSparseGrid::logAllValuesAndDerivatives( const double& scalef ) {
+  allocateAllBlocks();
+  for(auto & it : blocks_) {
+    for(auto & v : it.second.value) v=scalef*log(v);
+    for(auto & d : it.second.der) d=scalef/d;
+  }
+}
+
+void BlockSparseGrid::setMinToZero() {
+  const double min=getMinValue();
+  if(min==0.0) return;
+  allocateAllBlocks();
+  for(auto & it : blocks_) {
+    for(auto & v : it.second.value) v-=min;
+  }
+}
+
+void BlockSparseGrid::applyFunctionAllValuesAndDerivatives( double (*func)(double val), double (*funcder)(double valder) ) {
+// the points that have not been written only change if the function does not map zero to zero
+  if(func(0.0)!=0.0 || (usederiv_ && funcder(0.0)!=0.0)) allocateAllBlocks();
+  for(auto & it : blocks_) {
+    for(auto & v : it.second.value) v=func(v);
+    for(auto & d : it.second.der) d=funcder(d);
+  }
+}
+
+void BlockSparseGrid::writeToFile(OFile& ofile) {
+// points are written in the same order used for dense grids
+  vector<index_t> indices;
+  indices.reserve(blocks_.size()*blocksize_);
+  for(const auto & it : blocks_) {
+    for(unsigned i=0; i<blocksize_; ++i) {
+      index_t index;
+      if(getGlobalIndex(it.first,i,index)) indices.push_back(index);
+    }
+  }
+  std::sort(indices.begin(),indices.end());
+// at least one point is written, so that the file can be read back
+  if(indices.empty()) indices.push_back(0);
+
+  vector<double> xx(dimension_);
+  vector<double> der(dimension_);
+  double f;
+  writeHeader(ofile);
+  for(unsigned k=0; k<indices.size(); ++k) {
+    index_t i=indices[k];
+    getPoint(i,xx);
+    if(usederiv_) {f=getValueAndDerivatives(i,der);}
+    else {f=getValue(i);}
+    if(k>0 && dimension_>1 && getIndices(i)[dimension_-2]==0) ofile.printf("\n");
+    for(unsigned j=0; j<dimension_; ++j) {
+      ofile.printField("min_" + argnames[j], str_min_[j] );
+      ofile.printField("max_" + argnames[j], str_max_[j] );
+      ofile.printField("nbins_" + argnames[j], static_cast<int>(nbin_[j]) );
+      if( pbc_[j] ) ofile.printField("periodic_" + argnames[j], "true" );
+      else          ofile.printField("periodic_" + argnames[j], "false" );
+    }
+    for(unsigned j=0; j<dimension_; ++j) { ofile.fmtField(" "+fmt_); ofile.printField(argnames[j],xx[j]); }
+    ofile.fmtField(" "+fmt_); ofile.printField(funcname,f);
+    if(usederiv_) for(unsigned j=0; j<dimension_; ++j) { ofile.fmtField(" "+fmt_); ofile.printField("der_" + argnames[j],der[j]); }
+    ofile.printField();
+  }
+}
+
 void Grid::projectOnLowDimension(double &val, std::vector<int> &vHigh, WeightBase * ptr2obj ) {
   unsigned i=0;
   for(i=0; i<vHigh.size(); i++) {
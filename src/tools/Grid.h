@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <cmath>
 #include <memory>
 
@@ -162,12 +163,13 @@ public:
 /// write header for grid file
   void writeHeader(OFile& file);
 
-/// read grid from file
-  static std::unique_ptr<Grid> create(const std::string&,const std::vector<Value*>&,IFile&,bool,bool,bool);
+/// read grid from file.
+/// The last flag can be used to store the grid in a BlockSparseGrid
+  static std::unique_ptr<Grid> create(const std::string&,const std::vector<Value*>&,IFile&,bool,bool,bool,bool doblocks=false);
 /// read grid from file and check boundaries are what is expected from input
   static std::unique_ptr<Grid> create(const std::string&,const std::vector<Value*>&, IFile&,
                                       const std::vector<std::string>&,const std::vector<std::string>&,
-                                      const std::vector<unsigned>&,bool,bool,bool);
+                                      const std::vector<unsigned>&,bool,bool,bool,bool doblocks=false);
 /// get grid size
   virtual index_t getSize() const;
 /// get grid value
@@ -280,6 +282,93 @@ public:
 
   virtual ~SparseGrid() {}
 };
+
+/// \ingroup TOOLBOX
+/// Grid made of dense blocks of points that are only allocated when they are first written.
+/// Blocks are stored in a hash table indexed by the position of the block in the grid.
+/// Points in blocks that have not been allocated have zero value and derivatives.
+/// Memory thus scales with the explored region, whereas the cost of a lookup
+/// is a hash table access plus the same arithmetic needed for a dense grid.
+class BlockSparseGrid : public Grid
+{
+/// A dense block of the grid
+  struct Block {
+    std::vector<double> value;
+    std::vector<double> der;
+  };
+/// Number of bins on each side of a block
+  std::vector<unsigned> blockbins_;
+/// Number of blocks along each dimension
+  std::vector<unsigned> nblocks_;
+/// Number of points in a block
+  unsigned blocksize_;
+/// Total number of blocks in the grid
+  index_t totalblocks_;
+/// The allocated blocks
+  std::unordered_map<index_t,Block> blocks_;
+/// Find the block containing a point and the position of the point inside the block
+  void locate(index_t index, index_t& block, unsigned& offset) const;
+/// Find the point corresponding to a position inside a block. Returns false if the point is outside the grid.
+  bool getGlobalIndex(index_t block, unsigned offset, index_t& index) const;
+/// Get a block, allocating it if it does not exist yet
+  Block& getBlock(index_t block);
+/// Check if a block has been allocated
+  bool isAllocated(index_t block) const;
+/// Allocate all the blocks, before applying a function that changes the value of the points that have not been written
+  void allocateAllBlocks();
+
+protected:
+  void clear() override;
+
+public:
+  BlockSparseGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
+                  const std::vector<std::string> & gmax,
+                  const std::vector<unsigned> & nbin, bool dospline, bool usederiv);
+
+/// Number of allocated blocks
+  unsigned getNumberOfBlocks() const;
+/// Number of points in each block
+  unsigned getBlockSize() const;
+
+/// this is to access to Grid:: version of these methods (allowing overloading of virtual methods)
+  using Grid::getValue;
+  using Grid::getValueAndDerivatives;
+  using Grid::setValue;
+  using Grid::setValueAndDerivatives;
+  using Grid::addValue;
+  using Grid::addValueAndDerivatives;
+
+/// get grid value
+  double getValue(index_t index) const override;
+/// get minimum value
+  double getMinValue() const override;
+/// get maximum value
+  double getMaxValue() const override;
+/// get grid value and derivatives
+  double getValueAndDerivatives(index_t index, std::vector<double>& der) const override;
+
+/// set grid value
+  void setValue(index_t index, double value) override;
+/// set grid value and derivatives
+  void setValueAndDerivatives(index_t index, double value, std::vector<double>& der) override;
+/// add to grid value
+  void addValue(index_t index, double value) override;
+/// add to grid value and derivatives
+  void addValueAndDerivatives(index_t index, double value, std::vector<double>& der) override;
+/// Scale all grid values and derivatives by a constant factor
+  void scaleAllValuesAndDerivatives( const double& scalef ) override;
+/// Takes the scaled log of all grid values and derivatives. All blocks are allocated, since the log of zero is not zero.
+  void logAllValuesAndDerivatives( const double& scalef ) override;
+/// Set the minimum value of the grid to zero. All blocks are allocated if the minimum is not zero.
+  void setMinToZero() override;
+/// Apply function to all values and derivatives. All blocks are allocated if the function does not map zero to zero.
+  void applyFunctionAllValuesAndDerivatives( double (*func)(double val), double (*funcder)(double valder) ) override;
+
+/// dump grid on file, only the points in allocated blocks are written
+  void writeToFile(OFile&) override;
+
+  virtual ~BlockSparseGrid() {}
+};
 }
 
 #endif
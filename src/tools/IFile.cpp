@@ -27,6 +27,7 @@
 #include "Communicator.h"
 #include "Tools.h"
 #include <cstdarg>
+#include <cstdio>
 #include <cstring>
 #include <cmath>
 
@@ -60,31 +61,86 @@ size_t IFile::llread(char*ptr,size_t s) {
 
 IFile& IFile::advanceField() {
   plumed_assert(!inMiddleOfField);
-  std::string line;
+  std::string& line(lineBuffer);
   bool done=false;
   while(!done) {
-    getline(line);
+    if(binary) {
+// in binary files each line starts either with # (header lines, written as text)
+// or with a tag followed by the values of the variable fields
+      fpos_t pos;
+      fgetpos(fp,&pos);
+      char tag=0;
+      if(llread(&tag,1)!=1) {eof=true; return *this;}
+      if(tag==binaryRecordTag) {
+        unsigned nf=0;
+        for(unsigned i=0; i<fields.size(); i++) if(!fields[i].constant) nf++;
+        binaryBuffer.resize(nf*sizeof(double));
+        if(nf>0 && llread(binaryBuffer.data(),binaryBuffer.size())!=binaryBuffer.size()) {
+// incomplete line (e.g. a file that is being written), the position is reset as in getline()
+          eof=true;
+          if(!err && !gzfp) fsetpos(fp,&pos);
+          return *this;
+        }
+        unsigned j=0;
+        for(unsigned i=0; i<fields.size(); i++) {
+          if(fields[i].constant) continue;
+          std::memcpy(&fields[i].number,&binaryBuffer[j*sizeof(double)],sizeof(double));
+          fields[i].read=false;
+          j++;
+        }
+        done=true;
+        continue;
+      }
+      if(tag!='#') plumed_merror("file " + getPath() + ": corrupted binary file");
+      getline(line);
 // using explicit conversion not to confuse cppcheck 1.86
-    if(!bool(*this)) {return *this;}
-    std::vector<std::string> words=Tools::getWords(line);
-    if(words.size()>=2 && words[0]=="#!" && words[1]=="FIELDS") {
-      fields.clear();
-      for(unsigned i=2; i<words.size(); i++) {
-        Field field;
-        field.name=words[i];
-        fields.push_back(field);
+      if(!bool(*this)) {
+        if(!err && !gzfp) fsetpos(fp,&pos);
+        return *this;
       }
-    } else if(words.size()==4 && words[0]=="#!" && words[1]=="SET") {
-      Field field;
-      field.name=words[2];
-      field.value=words[3];
-      field.constant=true;
-      fields.push_back(field);
+      line.insert(0,1,'#');
     } else {
-      unsigned nf=0;
-      for(unsigned i=0; i<fields.size(); i++) if(!fields[i].constant) nf++;
+      getline(line);
+// using explicit conversion not to confuse cppcheck 1.86
+      if(!bool(*this)) {return *this;}
+    }
+    const char* p=line.c_str();
+    const char* end=p+line.length();
+    while(p<end && (*p==' ' || *p=='\t')) p++;
+// header lines are rare and are split in words
+    if(end-p>=2 && p[0]=='#' && p[1]=='!') {
+      std::vector<std::string> words=Tools::getWords(line);
+      if(words.size()>=2 && words[0]=="#!" && words[1]=="FIELDS") {
+        fields.clear();
+        fieldIndex.clear();
+        for(unsigned i=2; i<words.size(); i++) {
+          Field field;
+          field.name=words[i];
+          addField(field);
+        }
+        continue;
+      } else if(words.size()==4 && words[0]=="#!" && words[1]=="SET") {
+        Field field;
+        field.name=words[2];
+        field.value=words[3];
+        field.constant=true;
+        addField(field);
+        continue;
+      } else if(words.size()==3 && words[0]=="#!" && words[1]=="BINARY") {
+        if("#! BINARY "+words[2]!=getBinaryHeader())
+          plumed_merror("file " + getPath() + ": binary file written on a machine with a different byte order");
+        binary=true;
+        continue;
+      }
+    }
+    unsigned nf=0;
+    for(unsigned i=0; i<fields.size(); i++) if(!fields[i].constant) nf++;
+    const char* comment=static_cast<const char*>(std::memchr(p,'#',end-p));
+    if(comment) end=comment;
+    if(std::memchr(p,'{',end-p) || std::memchr(p,'}',end-p)) {
+// braces group words, this is left to Tools::getWords
       Tools::trimComments(line);
-      words=Tools::getWords(line);
+      std::vector<std::string> words=Tools::getWords(line);
       if( words.size()==nf ) {
         unsigned j=0;
         for(unsigned i=0; i<fields.size(); i++) {
@@ -97,18 +153,48 @@ IFile& IFile::advanceField() {
       } else if( !words.empty() ) {
         plumed_merror("file " + getPath() + ": mismatch between number of fields in file and expected number");
       }
+      continue;
+    }
+// the words are copied directly from the line buffer to the fields.
+// values are assigned to existing strings, so that their memory is reused
+    unsigned nwords=0;
+    unsigned i=0;
+    while(true) {
+      while(p<end && (*p==' ' || *p=='\t' || *p=='\n')) p++;
+      if(p>=end) break;
+      const char* b=p;
+      while(p<end && *p!=' ' && *p!='\t' && *p!='\n') p++;
+      while(i<fields.size() && fields[i].constant) i++;
+      if(i<fields.size()) {
+        fields[i].value.assign(b,p-b);
+        fields[i].read=false;
+        i++;
+      }
+      nwords++;
+    }
+    if( nwords==nf ) {
+      done=true;
+    } else if( nwords>0 ) {
+      plumed_merror("file " + getPath() + ": mismatch between number of fields in file and expected number");
     }
   }
   inMiddleOfField=true;
   return *this;
 }
 
+void IFile::addField(const Field&field) {
+// in case of duplicates, the first field is found as in a linear search
+  fieldIndex.insert(std::pair<std::string,unsigned>(field.name,fields.size()));
+  fields.push_back(field);
+}
+
 IFile& IFile::open(const std::string&path) {
   plumed_massert(!cloned,"file "+path+" appears to be cloned");
   eof=false;
   err=false;
   fp=NULL;
   gzfp=NULL;
+  binary=false;
   bool do_exist=FileExist(path);
   plumed_massert(do_exist,"file " + path + " cannot be found");
   fp=std::fopen(const_cast<char*>(this->path.c_str()),"r");
@@ -134,11 +220,17 @@ IFile& IFile::scanFieldList(std::vector<std::string>&s) {
 }
 
 bool IFile::FieldExist(const std::string& s) {
-  std::vector<std::string> slist;
-  scanFieldList(slist);
-  int mycount = (int) std::count(slist.begin(), slist.end(), s);
-  if(mycount>0) return true;
-  else return false;
+  if(!inMiddleOfField) advanceField();
+// using explicit conversion not to confuse cppcheck 1.86
+  if(!bool(*this)) return false;
+  return fieldIndex.count(s)>0;
+}
+
+bool IFile::FieldIsConstant(const std::string& s) {
+  if(!inMiddleOfField) advanceField();
+// using explicit conversion not to confuse cppcheck 1.86
+  if(!bool(*this)) return false;
+  return fields[findField(s)].constant;
 }
 
 IFile& IFile::scanField(const std::string&name,std::string&str) {
@@ -146,15 +238,28 @@ IFile& IFile::scanField(const std::string&name,std::string&str) {
 // using explicit conversion not to confuse cppcheck 1.86
   if(!bool(*this)) return *this;
   unsigned i=findField(name);
-  str=fields[i].value;
+  if(binary && !fields[i].constant) {
+    char buffer[32];
+    std::snprintf(buffer,sizeof(buffer),"%.17g",fields[i].number);
+    str=buffer;
+  } else str=fields[i].value;
   fields[i].read=true;
   return *this;
 }
 
 IFile& IFile::scanField(const std::string&name,double &x) {
-  std::string str;
-  scanField(name,str);
-  if(*this) Tools::convert(str,x);
+  if(!inMiddleOfField) advanceField();
+// using explicit conversion not to confuse cppcheck 1.86
+  if(!bool(*this)) return *this;
+  Field& field(fields[findField(name)]);
+  field.read=true;
+  if(binary && !field.constant) {
+    x=field.number;
+    return *this;
+  }
+  const std::string& str(field.value);
+// plain numbers are converted in place, anything else (e.g. expressions) with Tools::convert
+  if(!Tools::convertFast(str.data(),str.data()+str.length(),x)) Tools::convert(str,x);
   return *this;
 }
 
@@ -203,11 +308,22 @@ IFile::~IFile() {
 
 IFile& IFile::getline(std::string &str) {
   char tmp=0;
-  str="";
+  str.clear();
   fpos_t pos;
   fgetpos(fp,&pos);
-  while(llread(&tmp,1)==1 && tmp && tmp!='\n' && tmp!='\r' && !eof && !err) {
-    str+=tmp;
+  if(!gzfp) {
+// uncompressed files are read with getc, which is much faster than fread of single characters
+    int c;
+    while((c=std::getc(fp))!=EOF && c && c!='\n' && c!='\r') str+=char(c);
+    if(c==EOF) {
+      tmp=0;
+      if(std::feof(fp))   eof=true;
+      if(std::ferror(fp)) err=true;
+    } else tmp=char(c);
+  } else {
+    while(llread(&tmp,1)==1 && tmp && tmp!='\n' && tmp!='\r' && !eof && !err) {
+      str+=tmp;
+    }
   }
   if(tmp=='\r') {
     llread(&tmp,1);
@@ -231,12 +347,11 @@ IFile& IFile::getline(std::string &str) {
 }
 
 unsigned IFile::findField(const std::string&name)const {
-  unsigned i;
-  for(i=0; i<fields.size(); i++) if(fields[i].name==name) break;
-  if(i>=fields.size()) {
+  const auto f=fieldIndex.find(name);
+  if(f==fieldIndex.end()) {
     plumed_merror("file " + getPath() + ": field " + name + " cannot be found");
   }
-  return i;
+  return f->second;
 }
 
 void IFile::reset(bool reset) {
@@ -24,6 +24,8 @@
 
 #include "FileBase.h"
 #include <vector>
+#include <map>
+#include <string>
 
 namespace PLMD {
 
@@ -44,13 +46,21 @@ class IFile:
     public FieldBase {
   public:
     bool read;
-    Field(): read(false) {}
+/// Value of the field, only used when reading binary files
+    double number;
+    Field(): read(false), number(0.0) {}
   };
 /// Low-level read.
 /// Note: in parallel, all processes read
   size_t llread(char*,size_t);
 /// All the defined fields
   std::vector<Field> fields;
+/// Index of each field in fields, updated when the header is read
+  std::map<std::string,unsigned> fieldIndex;
+/// Buffer for the last line, reused to avoid allocations
+  std::string lineBuffer;
+/// Buffer for a line of values in binary files
+  std::vector<char> binaryBuffer;
 /// Flag set in the middle of a field reading
   bool inMiddleOfField;
 /// Set to true if you want to allow fields to be ignored in the read in file
@@ -61,6 +71,8 @@ class IFile:
   IFile& advanceField();
 /// Find field index by name
   unsigned findField(const std::string&name)const;
+/// Add a field and update the index
+  void addField(const Field&);
 public:
 /// Constructor
   IFile();
@@ -91,6 +103,8 @@ public:
   void reset(bool);
 /// Check if a field exist
   bool FieldExist(const std::string& s);
+/// Check if a field is constant (i.e. it was defined with #! SET)
+  bool FieldIsConstant(const std::string& s);
 /// Read in a value
   IFile& scanField(Value* val);
 /// Allow some of the fields in the input to be ignored
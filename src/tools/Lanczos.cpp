@@ -0,0 +1,132 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Lanczos.h"
+#include "Random.h"
+#include <algorithm>
+#include <cmath>
+
+namespace PLMD {
+
+/// Generate a random unit vector that is orthogonal to all the vectors in basis
+static void randomOrthogonalVector( Random& random, const std::vector<std::vector<double> >& basis, std::vector<double>& v ) {
+  for(unsigned i=0; i<v.size(); ++i) v[i]=random.Gaussian();
+  // Two passes of Gram-Schmidt are enough to get orthogonality to machine precision
+  for(unsigned pass=0; pass<2; ++pass) {
+    for(unsigned l=0; l<basis.size(); ++l) {
+      double c=0; for(unsigned i=0; i<v.size(); ++i) c+=v[i]*basis[l][i];
+      for(unsigned i=0; i<v.size(); ++i) v[i]-=c*basis[l][i];
+    }
+  }
+  double norm=0; for(unsigned i=0; i<v.size(); ++i) norm+=v[i]*v[i];
+  norm=std::sqrt(norm); plumed_assert( norm>0 );
+  for(unsigned i=0; i<v.size(); ++i) v[i]/=norm;
+}
+
+int diagMatLanczos( const unsigned& n, const unsigned& k,
+                    const std::function<void(const std::vector<double>& x, std::vector<double>& y)>& product,
+                    std::vector<double>& eigenvals, Matrix<double>& eigenvecs, const double& tol ) {
+  plumed_assert( k>0 && k<=n );
+  // The starting vector is random but always the same so that results are reproducible
+  Random random; random.setSeed(-1);
+
+  std::vector<std::vector<double> > basis; std::vector<double> alpha, beta;
+  std::vector<double> v(n), w(n), ritzval; Matrix<double> ritzvec;
+  randomOrthogonalVector( random, basis, v );
+  double anorm=0; unsigned block_start=0;
+  while( true ) {
+    basis.push_back( v ); unsigned m=basis.size();
+    product( v, w ); plumed_assert( w.size()==n );
+    double a=0; for(unsigned i=0; i<n; ++i) a+=w[i]*v[i];
+    alpha.push_back( a );
+    // Orthogonalize the new vector against the whole Krylov basis.  In exact arithmetic only the
+    // last two vectors would be needed but rounding errors make the basis lose orthogonality.
+    for(unsigned pass=0; pass<2; ++pass) {
+      for(unsigned l=0; l<m; ++l) {
+        double c=0; for(unsigned i=0; i<n; ++i) c+=w[i]*basis[l][i];
+        for(unsigned i=0; i<n; ++i) w[i]-=c*basis[l][i];
+      }
+    }
+    double b=0; for(unsigned i=0; i<n; ++i) b+=w[i]*w[i];
+    b=std::sqrt(b);
+    // Estimate of the norm of the matrix from the Gershgorin circles of the tridiagonal matrix
+    anorm=std::max( anorm, std::fabs(a) + b + ( m>1 ? beta[m-2] : 0.0 ) );
+    // The Krylov space is invariant when b vanishes
+    bool breakdown=( b<=1.e-10*anorm );
+
+    // Check for convergence of the Ritz pairs every few iterations
+    if( m>=k && ( m==n || breakdown || m%5==0 ) ) {
+      Matrix<double> tmat( m, m ); tmat=0;
+      for(unsigned j=0; j<m; ++j) {
+        tmat(j,j)=alpha[j];
+        if( j+1<m ) tmat(j,j+1)=tmat(j+1,j)=beta[j];
+      }
+      int err=diagMat( tmat, ritzval, ritzvec );
+      if( err!=0 ) return err;
+      bool converged=true;
+      if( m==n ) {
+        // The basis spans the whole space so the Ritz pairs are exact
+      } else if( breakdown ) {
+        // When the Krylov space is invariant the eigenvalues of the matrix in the rest of the space are
+        // further copies of the eigenvalues found since the last restart.  These copies only matter if
+        // one of them is larger than the k-th largest Ritz value.
+        unsigned nb=m-block_start; Matrix<double> bmat( nb, nb ); std::vector<double> bval; Matrix<double> bvec;
+        for(unsigned j=0; j<nb; ++j) for(unsigned l=0; l<nb; ++l) bmat(j,l)=tmat(block_start+j,block_start+l);
+        err=diagMat( bmat, bval, bvec );
+        if( err!=0 ) return err;
+        converged=( bval[nb-1]<=ritzval[m-k]+tol*anorm );
+      } else {
+        // The residual of each Ritz pair is the product of b and the last component of the eigenvector of tmat
+        for(unsigned i=0; i<k; ++i) {
+          if( std::fabs( b*ritzvec(m-1-i,m-1) )>tol*anorm ) { converged=false; break; }
+        }
+      }
+      if( converged ) break;
+    }
+
+    // Continue from a new random direction if the Krylov space is invariant
+    if( breakdown ) {
+      beta.push_back( 0.0 ); randomOrthogonalVector( random, basis, v ); block_start=m;
+    } else {
+      beta.push_back( b ); for(unsigned i=0; i<n; ++i) v[i]=w[i]/b;
+    }
+  }
+
+  // Now compute the Ritz vectors, which are the approximate eigenvectors
+  unsigned m=basis.size();
+  if( eigenvals.size()!=k ) eigenvals.resize( k );
+  if( eigenvecs.nrows()!=k || eigenvecs.ncols()!=n ) eigenvecs.resize( k, n );
+  eigenvecs=0;
+  for(unsigned i=0; i<k; ++i) {
+    eigenvals[i]=ritzval[m-1-i];
+    for(unsigned l=0; l<m; ++l) {
+      double c=ritzvec(m-1-i,l);
+      for(unsigned j=0; j<n; ++j) eigenvecs(i,j)+=c*basis[l][j];
+    }
+    // This uses the same convention for the phase as diagMat
+    unsigned j;
+    for(j=0; j<n; j++) if(eigenvecs(i,j)*eigenvecs(i,j)>1e-14) break;
+    if(j<n) if(eigenvecs(i,j)<0.0) for(j=0; j<n; j++) eigenvecs(i,j)*=-1;
+  }
+  return 0;
+}
+
+}
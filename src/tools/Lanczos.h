@@ -0,0 +1,45 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_Lanczos_h
+#define __PLUMED_tools_Lanczos_h
+
+#include "Matrix.h"
+#include <functional>
+#include <vector>
+
+namespace PLMD {
+
+/// Calculate the k largest eigenvalues of a real symmetric matrix of size n and the
+/// corresponding eigenvectors using the Lanczos algorithm with full reorthogonalization.
+/// The matrix is never stored as it is only accessed through the function product, which
+/// must set y equal to the product of the matrix and the vector x.  This is far cheaper
+/// than diagMat when only a few of the eigenvalues of a large matrix are required.
+/// The eigenvalues are returned in descending order.  As in diagMat the eigenvectors are
+/// stored ROW-wise and the first non-null element of each of them is positive.
+/// Returns zero if successful.
+int diagMatLanczos( const unsigned& n, const unsigned& k,
+                    const std::function<void(const std::vector<double>& x, std::vector<double>& y)>& product,
+                    std::vector<double>& eigenvals, Matrix<double>& eigenvecs, const double& tol=1.e-10 );
+
+}
+
+#endif
@@ -102,6 +102,23 @@ void LinkCells::buildCellLists( const std::vector<Vector>& pos, const std::vecto
   }
 }
 
+void LinkCells::buildCellListsWithoutPbc( const std::vector<Vector>& pos, const std::vector<unsigned>& indices ) {
+  plumed_assert( cutoffwasset );
+  // The cells are built in an orthorhombic box that is larger than the region containing the atoms by
+  // one cutoff, so that the periodic images of this box are never within the cutoff of one another
+  Vector lower, upper;
+  if( pos.size()>0 ) lower=upper=pos[0];
+  for(unsigned i=1; i<pos.size(); ++i) {
+    for(unsigned j=0; j<3; ++j) {
+      if( pos[i][j]<lower[j] ) lower[j]=pos[i][j];
+      if( pos[i][j]>upper[j] ) upper[j]=pos[i][j];
+    }
+  }
+  Tensor box; for(unsigned j=0; j<3; ++j) box[j][j]=upper[j]-lower[j]+link_cutoff;
+  Pbc boundingbox; boundingbox.setBox( box );
+  buildCellLists( pos, indices, boundingbox );
+}
+
 #define LINKC_MIN(n) ((n<2)? 0 : -1)
 #define LINKC_MAX(n) ((n<3)? 1 : 2)
 #define LINKC_PBC(n,num) ((n<0)? num-1 : n%num )
@@ -67,6 +67,8 @@ public:
   unsigned getNumberOfCells() const ;
 /// Build the link cell lists
   void buildCellLists( const std::vector<Vector>& pos, const std::vector<unsigned>& indices, const Pbc& pbc );
+/// Build the link cell lists for atoms that are not in a periodic box
+  void buildCellListsWithoutPbc( const std::vector<Vector>& pos, const std::vector<unsigned>& indices );
 /// Take three indices and return the index of the corresponding cell
   unsigned convertIndicesToIndex( const unsigned& nx, const unsigned& ny, const unsigned& nz ) const ;
 /// Find the cell index in which this position is contained
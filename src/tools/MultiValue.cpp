@@ -20,6 +20,7 @@
    along with plumed.  If not, see <http://www.gnu.org/licenses/>.
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "MultiValue.h"
+#include "AccumulationBuffer.h"
 
 namespace PLMD {
 
@@ -62,7 +63,7 @@ void MultiValue::clearTemporyDerivatives() {
 }
 
 void MultiValue::chainRule( const unsigned& ival, const unsigned& iout, const unsigned& stride, const unsigned& off,
-                            const double& df, const unsigned& bufstart, std::vector<double>& buffer ) {
+                            const double& df, const unsigned& bufstart, AccumulationBuffer& buffer ) {
   if( !hasDerivatives.updateComplete() ) hasDerivatives.updateActiveMembers();
 
   plumed_dbg_assert( off<stride );
@@ -28,6 +28,8 @@
 
 namespace PLMD {
 
+class AccumulationBuffer;
+
 class MultiValue {
 private:
 /// Used to ensure rapid accumulation of derivatives
@@ -96,7 +98,7 @@ public:
 ///
   unsigned getActiveIndex( const unsigned& ) const ;
 /// Transfer derivatives to buffer
-  void chainRule( const unsigned&, const unsigned&, const unsigned&, const unsigned&, const double&, const unsigned&, std::vector<double>& buffer );
+  void chainRule( const unsigned&, const unsigned&, const unsigned&, const unsigned&, const double&, const unsigned&, AccumulationBuffer& buffer );
 ///
   void copyValues( MultiValue& ) const ;
 ///
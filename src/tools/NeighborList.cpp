@@ -32,9 +32,11 @@ using namespace std;
 
 NeighborList::NeighborList(const vector<AtomNumber>& list0, const vector<AtomNumber>& list1,
                            const bool& do_pair, const bool& do_pbc, const Pbc& pbc,
-                           const double& distance, const unsigned& stride): reduced(false),
+                           const double& distance, const unsigned& stride,
+                           const double& skin): reduced(false),
   do_pair_(do_pair), do_pbc_(do_pbc), pbc_(&pbc),
-  distance_(distance), stride_(stride)
+  distance_(distance), skin_(skin), stride_(stride),
+  linkcells_(serialcomm_)
 {
 // store full list of atoms needed
   fullatomlist_=list0;
@@ -55,9 +57,10 @@ NeighborList::NeighborList(const vector<AtomNumber>& list0, const vector<AtomNum
 
 NeighborList::NeighborList(const vector<AtomNumber>& list0, const bool& do_pbc,
                            const Pbc& pbc, const double& distance,
-                           const unsigned& stride): reduced(false),
-  do_pbc_(do_pbc), pbc_(&pbc),
-  distance_(distance), stride_(stride) {
+                           const unsigned& stride, const double& skin): reduced(false),
+  do_pair_(false), do_pbc_(do_pbc), pbc_(&pbc),
+  distance_(distance), skin_(skin), stride_(stride),
+  linkcells_(serialcomm_) {
   fullatomlist_=list0;
   nlist0_=list0.size();
   twolists_=false;
@@ -92,11 +95,55 @@ pair<unsigned,unsigned> NeighborList::getIndexPair(unsigned ipair) {
   return index;
 }
 
-void NeighborList::update(const vector<Vector>& positions) {
-  neighbors_.clear();
-  const double d2=distance_*distance_;
+bool NeighborList::update(const vector<Vector>& positions) {
 // check if positions array has the correct length
   plumed_assert(positions.size()==fullatomlist_.size());
+// with a skin, the list built at the last rebuild is still valid
+// as long as no atom moved by more than half the skin
+  if(skin_>0.0 && !needsRebuild(positions)) {
+    neighbors_=full_neighbors_;
+    reduced=false;
+    return false;
+  }
+  neighbors_.clear();
+  const double cutoff=distance_+skin_;
+  if(useLinkCells(cutoff)) buildWithLinkCells(positions,cutoff);
+  else buildAllPairs(positions,cutoff*cutoff);
+  if(skin_>0.0) {
+    reference_positions_=positions;
+    full_neighbors_=neighbors_;
+  }
+  setRequestList();
+  return true;
+}
+
+bool NeighborList::needsRebuild(const vector<Vector>& positions) const {
+  if(reference_positions_.size()!=positions.size()) return true;
+  const double maxdisp2=0.25*skin_*skin_;
+  for(unsigned i=0; i<positions.size(); ++i) {
+    Vector displacement;
+    if(do_pbc_) {
+      displacement=pbc_->distance(reference_positions_[i],positions[i]);
+    } else {
+      displacement=delta(reference_positions_[i],positions[i]);
+    }
+    if(modulo2(displacement)>maxdisp2) return true;
+  }
+  return false;
+}
+
+bool NeighborList::useLinkCells(const double& cutoff) const {
+// link cells require a box, and with PAIR the list is already linear in the number of atoms
+  if(!do_pbc_ || !pbc_->isSet() || (twolists_ && do_pair_)) return false;
+// link cells only pay off if the box can be divided in at least three cells in one direction
+  Tensor reciprocal(transpose(pbc_->getInvBox()));
+  for(unsigned j=0; j<3; ++j) {
+    if(1.0/reciprocal.getRow(j).modulo()>=3.0*cutoff) return true;
+  }
+  return false;
+}
+
+void NeighborList::buildAllPairs(const vector<Vector>& positions, const double& d2) {
   for(unsigned int i=0; i<nallpairs_; ++i) {
     pair<unsigned,unsigned> index=getIndexPair(i);
     unsigned index0=index.first;
@@ -110,7 +157,37 @@ void NeighborList::update(const vector<Vector>& positions) {
     double value=modulo2(distance);
     if(value<=d2) {neighbors_.push_back(index);}
   }
-  setRequestList();
+}
+
+void NeighborList::buildWithLinkCells(const vector<Vector>& positions, const double& cutoff) {
+  const double d2=cutoff*cutoff;
+// atoms that are binned in the link cells: the second list, or the whole list if there is only one
+  const unsigned first=(twolists_ ? nlist0_ : 0);
+  const unsigned nbinned=positions.size()-first;
+  vector<Vector> binned_pos(nbinned);
+  vector<unsigned> binned_ind(nbinned);
+  for(unsigned i=0; i<nbinned; ++i) {
+    binned_pos[i]=positions[first+i];
+    binned_ind[i]=first+i;
+  }
+  linkcells_.setCutoff(cutoff);
+  linkcells_.buildCellLists(binned_pos,binned_ind,*pbc_);
+
+  vector<unsigned> cells_required(linkcells_.getNumberOfCells());
+  vector<unsigned> atoms(nbinned+1);
+  for(unsigned i=0; i<nlist0_; ++i) {
+    unsigned natomsper=1; atoms[0]=i;
+    linkcells_.retrieveNeighboringAtoms(positions[i],cells_required,natomsper,atoms);
+    for(unsigned k=1; k<natomsper; ++k) {
+      unsigned j=atoms[k];
+// with a single list each pair is only counted once
+      if(!twolists_ && j<i) continue;
+      Vector distance=pbc_->distance(positions[i],positions[j]);
+      if(modulo2(distance)<=d2) neighbors_.push_back(pair<unsigned,unsigned>(i,j));
+    }
+  }
+// keep the same ordering that is obtained looping over all pairs
+  std::sort(neighbors_.begin(),neighbors_.end());
 }
 
 void NeighborList::setRequestList() {
@@ -141,6 +218,10 @@ unsigned NeighborList::getStride() const {
   return stride_;
 }
 
+double NeighborList::getSkin() const {
+  return skin_;
+}
+
 unsigned NeighborList::getLastUpdate() const {
   return lastupdate_;
 }
@@ -157,6 +238,10 @@ pair<unsigned,unsigned> NeighborList::getClosePair(unsigned i) const {
   return neighbors_[i];
 }
 
+const vector<pair<unsigned,unsigned> >& NeighborList::getClosePairs() const {
+  return neighbors_;
+}
+
 pair<AtomNumber,AtomNumber> NeighborList::getClosePairAtomNumber(unsigned i) const {
   pair<AtomNumber,AtomNumber> Aneigh;
   Aneigh=pair<AtomNumber,AtomNumber>(fullatomlist_[neighbors_[i].first],fullatomlist_[neighbors_[i].second]);
@@ -24,6 +24,8 @@
 
 #include "Vector.h"
 #include "AtomNumber.h"
+#include "Communicator.h"
+#include "LinkCells.h"
 
 #include <vector>
 
@@ -40,10 +42,26 @@ class NeighborList
   const PLMD::Pbc* pbc_;
   std::vector<PLMD::AtomNumber> fullatomlist_,requestlist_;
   std::vector<std::pair<unsigned,unsigned> > neighbors_;
-  double distance_;
+  double distance_,skin_;
   unsigned stride_,nlist0_,nlist1_,nallpairs_,lastupdate_;
+/// Serial communicator used by the link cells (every rank builds the full list)
+  Communicator serialcomm_;
+/// Link cells used to bin atoms when the list is rebuilt
+  LinkCells linkcells_;
+/// Positions at the time of the last rebuild (only used with a skin)
+  std::vector<PLMD::Vector> reference_positions_;
+/// Copy of the list of pairs, in the full ordering, at the last rebuild (only used with a skin)
+  std::vector<std::pair<unsigned,unsigned> > full_neighbors_;
 /// Initialize the neighbor list with all possible pairs
   void initialize();
+/// Check if an atom has moved by more than half the skin since the last rebuild
+  bool needsRebuild(const std::vector<PLMD::Vector>& positions) const;
+/// Check if link cells can be used to rebuild the list
+  bool useLinkCells(const double& cutoff) const;
+/// Rebuild the list testing all possible pairs
+  void buildAllPairs(const std::vector<PLMD::Vector>& positions, const double& d2);
+/// Rebuild the list testing only pairs in neighboring link cells
+  void buildWithLinkCells(const std::vector<PLMD::Vector>& positions, const double& cutoff);
 /// Return the pair of indexes in the positions array
 /// of the two atoms forming the i-th pair among all possible pairs
   std::pair<unsigned,unsigned> getIndexPair(unsigned i);
@@ -53,10 +71,11 @@ public:
   NeighborList(const std::vector<PLMD::AtomNumber>& list0,
                const std::vector<PLMD::AtomNumber>& list1,
                const bool& do_pair, const bool& do_pbc, const PLMD::Pbc& pbc,
-               const double& distance=1.0e+30, const unsigned& stride=0);
+               const double& distance=1.0e+30, const unsigned& stride=0,
+               const double& skin=0.0);
   NeighborList(const std::vector<PLMD::AtomNumber>& list0, const bool& do_pbc,
                const PLMD::Pbc& pbc, const double& distance=1.0e+30,
-               const unsigned& stride=0);
+               const unsigned& stride=0, const double& skin=0.0);
 /// Return the list of all atoms. These are needed to rebuild the neighbor list.
   std::vector<PLMD::AtomNumber>& getFullAtomList();
 /// Update the indexes in the neighbor list to match the
@@ -64,10 +83,14 @@ public:
 /// and return the new list of atoms that must be requested to the main code
   std::vector<PLMD::AtomNumber>& getReducedAtomList();
 /// Update the neighbor list and prepare the new
-/// list of atoms that will be requested to the main code
-  void update(const std::vector<PLMD::Vector>& positions);
+/// list of atoms that will be requested to the main code.
+/// If a skin was set, the list is rebuilt only if an atom moved by more than half the skin
+/// since the last rebuild. Returns true if the list was rebuilt.
+  bool update(const std::vector<PLMD::Vector>& positions);
 /// Get the update stride of the neighbor list
   unsigned getStride() const;
+/// Get the Verlet skin of the neighbor list
+  double getSkin() const;
 /// Get the last step in which the neighbor list was updated
   unsigned getLastUpdate() const;
 /// Set the step of the last update
@@ -76,6 +99,8 @@ public:
   unsigned size() const;
 /// Get the i-th pair of the neighbor list
   std::pair<unsigned,unsigned> getClosePair(unsigned i) const;
+/// Get all the pairs of the neighbor list, stored contiguously
+  const std::vector<std::pair<unsigned,unsigned> >& getClosePairs() const;
 /// Get the list of neighbors of the i-th atom
   std::vector<unsigned> getNeighbors(unsigned i);
   ~NeighborList() {}
@@ -35,6 +35,8 @@
 #include <cerrno>
 
 #include <memory>
+#include <mutex>
+#include <atomic>
 #include <utility>
 
 #ifdef __PLUMED_HAS_ZLIB
@@ -101,7 +103,21 @@ OFile& OFile::setLinePrefix(const std::string&l) {
   return *this;
 }
 
+namespace {
+/// Serializes printf() while actions are calculated concurrently
+/// (e.g. writing on the log from different threads)
+std::mutex printfMutex;
+std::atomic<int> printfSerialized(0);
+}
+
+void OFile::serializePrintf(bool s) {
+  if(s) printfSerialized++;
+  else printfSerialized--;
+}
+
 int OFile::printf(const char*fmt,...) {
+  std::unique_lock<std::mutex> lock(printfMutex,std::defer_lock);
+  if(printfSerialized.load(std::memory_order_relaxed)>0) lock.lock();
   va_list arg;
   va_start(arg, fmt);
   int r=std::vsnprintf(&buffer[actual_buffer_length],buflen-actual_buffer_length,fmt,arg);
@@ -128,8 +144,15 @@ int OFile::printf(const char*fmt,...) {
   char*psearch=p1+actual_buffer_length;
   actual_buffer_length+=r;
   while((p2=strchr(psearch,'\n'))) {
-    if(linePrefix.length()>0) llwrite(linePrefix.c_str(),linePrefix.length());
-    llwrite(p1,p2-p1+1);
+    if(binary) {
+// in binary files only header and comment lines can be written as text,
+// empty lines (e.g. those separating blocks in grids) are skipped
+      if(p2>p1 && *p1!='#') plumed_merror("file " + getPath() + ": only fields and lines starting with # can be written to binary files");
+      if(p2>p1) llwrite(p1,p2-p1+1);
+    } else {
+      if(linePrefix.length()>0) llwrite(linePrefix.c_str(),linePrefix.length());
+      llwrite(p1,p2-p1+1);
+    }
     actual_buffer_length-=(p2-p1)+1;
     p1=p2+1;
     psearch=p1;
@@ -168,12 +191,21 @@ OFile& OFile::printField(const std::string&name,double v) {
 // The distinction between +nan and -nan is not well defined
 // Always printing nan simplifies some regtest (special functions computed our of range).
   if(std::isnan(v)) v=std::numeric_limits<double>::quiet_NaN();
+  if(binary && !isConstantField(name)) {
+// numbers are stored as they are, without formatting them
+    Field field;
+    field.name=name;
+    field.number=v;
+    fields.push_back(field);
+    return *this;
+  }
   sprintf(buffer_string.get(),fieldFmt.c_str(),v);
   printField(name,buffer_string.get());
   return *this;
 }
 
 OFile& OFile::printField(const std::string&name,int v) {
+  if(binary && !isConstantField(name)) return printField(name,double(v));
   sprintf(buffer_string.get()," %d",v);
   printField(name,buffer_string.get());
   return *this;
@@ -186,6 +218,8 @@ OFile& OFile::printField(const std::string&name,const std::string & v) {
     Field field;
     field.name=name;
     field.value=v;
+    if(binary && !Tools::convert(v,field.number))
+      plumed_merror("file " + getPath() + ": field " + name + " with value " + v + " cannot be written to a binary file since it is not a number");
     fields.push_back(field);
   } else {
     if(const_fields[i].value!=v) fieldChanged=true;
@@ -194,6 +228,11 @@ OFile& OFile::printField(const std::string&name,const std::string & v) {
   return *this;
 }
 
+bool OFile::isConstantField(const std::string&name)const {
+  for(unsigned i=0; i<const_fields.size(); i++) if(const_fields[i].name==name) return true;
+  return false;
+}
+
 OFile& OFile::setupPrintValue( Value *val ) {
   if( val->isPeriodic() ) {
     addConstantField("min_" + val->getName() );
@@ -232,8 +271,16 @@ OFile& OFile::printField() {
       printf("\n");
     }
   }
-  for(unsigned i=0; i<fields.size(); i++) printf("%s",fields[i].value.c_str());
-  printf("\n");
+  if(binary) {
+    plumed_massert(actual_buffer_length==0,"file " + getPath() + ": a line without newline was printed before the fields");
+    binaryBuffer.resize(1+fields.size()*sizeof(double));
+    binaryBuffer[0]=binaryRecordTag;
+    for(unsigned i=0; i<fields.size(); i++) std::memcpy(&binaryBuffer[1+i*sizeof(double)],&fields[i].number,sizeof(double));
+    llwrite(binaryBuffer.data(),binaryBuffer.size());
+  } else {
+    for(unsigned i=0; i<fields.size(); i++) printf("%s",fields[i].value.c_str());
+    printf("\n");
+  }
   previous_fields=fields;
   fields.clear();
   fieldChanged=false;
@@ -318,6 +365,7 @@ OFile& OFile::open(const std::string&path) {
 #endif
     }
   }
+  if(binary) printf("%s\n",getBinaryHeader().c_str());
   if(plumed) plumed->insertFile(*this);
   return *this;
 }
@@ -347,6 +395,7 @@ OFile& OFile::rewind() {
     gzfp=(void*)gzopen(const_cast<char*>(this->path.c_str()),"w9");
 #endif
   } else fp=std::fopen(const_cast<char*>(path.c_str()),"w");
+  if(binary) printf("%s\n",getBinaryHeader().c_str());
   return *this;
 }
 
@@ -393,5 +442,11 @@ OFile& OFile::enforceBackup() {
   return *this;
 }
 
+OFile& OFile::enforceBinary() {
+  plumed_massert(!fp,"enforceBinary() should be called before opening the file");
+  binary=true;
+  return *this;
+}
+
 
 }
@@ -72,6 +72,13 @@ plumed: test2
                      18                     67
 \endverbatim
 
+If enforceBinary() is called before opening the file, the file is written
+in binary format. The `#! FIELDS` and `#! SET` lines are written as text, after a first line
+reporting the byte order, but each line of values is written as a tag character followed
+by the values of the variable fields stored as double precision numbers.
+IFile recognizes these files automatically, so that the same code can be used
+to read text and binary files.
+
 Notes
 - "x2" is declared as "constant", which means that it is written using the "SET"
 keyword. Thus, everytime it is modified, all the headers are repeated in the output file.
@@ -163,6 +170,10 @@ class OFile:
 /// Class identifying a single field for fielded output
   class Field:
     public FieldBase {
+  public:
+/// Value of the field, only used when writing binary files
+    double number;
+    Field(): number(0.0) {}
   };
 /// Low-level write
   size_t llwrite(const char*,size_t);
@@ -186,6 +197,10 @@ class OFile:
   std::string backstring;
 /// Find field index given name
   unsigned findField(const std::string&name)const;
+/// Check if name is a constant field
+  bool isConstantField(const std::string&name)const;
+/// Buffer for a line of values in binary files
+  std::vector<char> binaryBuffer;
 /// check if we are restarting
   bool checkRestart()const;
 /// True if restart behavior should be forced
@@ -220,7 +235,8 @@ public:
 /// Typically "PLUMED: ". Notice that lines with a prefix cannot
 /// be parsed using fields in a IFile.
   OFile& setLinePrefix(const std::string&);
-/// Set the format for writing double precision fields
+/// Set the format for writing double precision fields.
+/// It has no effect on binary files, where numbers are written with full precision
   OFile& fmtField(const std::string&);
 /// Reset the format for writing double precision fields to its default
   OFile& fmtField();
@@ -251,6 +267,9 @@ public:
   OFile& clearFields();
 /// Formatted output with explicit format - a la printf
   int printf(const char*fmt,...);
+/// Serialize printf() among threads, on all files, until it is called again with false.
+/// Used while actions are calculated concurrently, since they might write on the same file (e.g. the log)
+  static void serializePrintf(bool);
 /// Formatted output with << operator
   template <class T>
   friend OFile& operator<<(OFile&,const T &);
@@ -263,6 +282,8 @@ public:
   OFile&enforceRestart();
 /// Enforce backup, even if the attached plumed object is restarting.
   OFile&enforceBackup();
+/// Write values in binary format. Should be called before opening the file.
+  OFile&enforceBinary();
 };
 
 /// Write using << syntax
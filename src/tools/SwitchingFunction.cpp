@@ -25,6 +25,8 @@
 #include "OpenMP.h"
 #include <vector>
 #include <limits>
+#include <algorithm>
+#include <set>
 
 #define PI 3.14159265358979323846
 
@@ -265,36 +267,28 @@ void SwitchingFunction::set(const std::string & definition,std::string& errormsg
     Tools::parse(data,"FUNC",func);
     lepton::ParsedExpression pe=lepton::Parser::parse(func).optimize(lepton::Constants());
     lepton_func=func;
+    std::string arg="x";
+    {
+      std::set<std::string> variables(pe.createCompiledExpression().getVariables());
+      if(variables.find("x")==variables.end() && variables.find("x2")!=variables.end()) {
+        arg="x2";
+        leptonx2=true;
+      }
+    }
+    lepton::ParsedExpression ped=lepton::Parser::parse(func).differentiate(arg).optimize(lepton::Constants());
+// the function and its derivative are compiled together, so that their common subexpressions are calculated only once
+    std::vector<lepton::ParsedExpression> pes(1,pe);
+    pes.push_back(ped);
     expression.resize(OpenMP::getNumThreads());
-    for(auto & e : expression) e=pe.createCompiledExpression();
+    for(auto & e : expression) e=lepton::CompiledExpression(pes);
     lepton_ref.resize(expression.size());
     for(unsigned t=0; t<lepton_ref.size(); t++) {
       try {
-        lepton_ref[t]=&const_cast<lepton::CompiledExpression*>(&expression[t])->getVariableReference("x");
+        lepton_ref[t]=&const_cast<lepton::CompiledExpression*>(&expression[t])->getVariableReference(arg);
       } catch(const PLMD::lepton::Exception& exc) {
-        try {
-          lepton_ref[t]=&const_cast<lepton::CompiledExpression*>(&expression[t])->getVariableReference("x2");
-          leptonx2=true;
-        } catch(const PLMD::lepton::Exception& exc) {
 // this is necessary since in some cases lepton things a variable is not present even though it is present
 // e.g. func=0*x
-          lepton_ref[t]=nullptr;
-        }
-      }
-    }
-    std::string arg="x";
-    if(leptonx2) arg="x2";
-    lepton::ParsedExpression ped=lepton::Parser::parse(func).differentiate(arg).optimize(lepton::Constants());
-    expression_deriv.resize(OpenMP::getNumThreads());
-    for(auto & e : expression_deriv) e=ped.createCompiledExpression();
-    lepton_ref_deriv.resize(expression_deriv.size());
-    for(unsigned t=0; t<lepton_ref_deriv.size(); t++) {
-      try {
-        lepton_ref_deriv[t]=&const_cast<lepton::CompiledExpression*>(&expression_deriv[t])->getVariableReference(arg);
-      } catch(const PLMD::lepton::Exception& exc) {
-// this is necessary since in some cases lepton things a variable is not present even though it is present
-// e.g. func=3*x
-        lepton_ref_deriv[t]=nullptr;
+        lepton_ref[t]=nullptr;
       }
     }
 
@@ -404,9 +398,8 @@ double SwitchingFunction::calculateSqr(double distance2,double&dfunc)const {
     const double rdist_2 = distance2*invr0_2;
     plumed_assert(t<expression.size());
     if(lepton_ref[t]) *lepton_ref[t]=rdist_2;
-    if(lepton_ref_deriv[t]) *lepton_ref_deriv[t]=rdist_2;
     double result=expression[t].evaluate();
-    dfunc=expression_deriv[t].evaluate();
+    dfunc=expression[t].getResults()[1];
 // chain rule:
     dfunc*=2*invr0_2;
 // stretch:
@@ -419,6 +412,136 @@ double SwitchingFunction::calculateSqr(double distance2,double&dfunc)const {
   }
 }
 
+namespace {
+
+/// Number of distances processed at once by the vectorized kernels
+const unsigned kernelChunk=64;
+
+/// Same as Tools::fastpow, applied to n<=kernelChunk numbers.
+/// The loop on the bits of the exponent is outside so that the loops on the numbers can be vectorized.
+void fastpowArray(unsigned n,const double*base,int exp,double*result) {
+  double b[kernelChunk];
+  if(exp<0) {
+    exp=-exp;
+    for(unsigned k=0; k<n; ++k) b[k]=1.0/base[k];
+  } else {
+    for(unsigned k=0; k<n; ++k) b[k]=base[k];
+  }
+  for(unsigned k=0; k<n; ++k) result[k]=1.0;
+  while(exp) {
+    if(exp & 1) for(unsigned k=0; k<n; ++k) result[k]*=b[k];
+    exp >>= 1;
+    for(unsigned k=0; k<n; ++k) b[k]*=b[k];
+  }
+}
+
+}
+
+void SwitchingFunction::do_rational(unsigned n,const double*rdist,double*result,double*dfunc,int nn,int mm)const {
+  double rNdist[kernelChunk],rMdist[kernelChunk];
+  fastpowArray(n,rdist,nn-1,rNdist);
+  if(2*nn==mm) {
+// if 2*N==M, then (1.0-rdist^N)/(1.0-rdist^M) = 1.0/(1.0+rdist^N)
+    for(unsigned k=0; k<n; ++k) {
+      double iden=1.0/(1+rNdist[k]*rdist[k]);
+      dfunc[k] = -nn*rNdist[k]*iden*iden;
+      result[k] = iden;
+    }
+  } else {
+    fastpowArray(n,rdist,mm-1,rMdist);
+    const double result1=nn/mm;
+    const double dfunc1=0.5*nn*(nn-mm)/mm;
+    for(unsigned k=0; k<n; ++k) {
+      double num = 1.-rNdist[k]*rdist[k];
+      double iden = 1./(1.-rMdist[k]*rdist[k]);
+      double func = num*iden;
+      double dfun = ((-nn*rNdist[k]*iden)+(func*(iden*mm)*rMdist[k]));
+      const bool one=(rdist[k]>(1.-100.0*epsilon) && rdist[k]<(1+100.0*epsilon));
+      result[k] = (one ? result1 : func);
+      dfunc[k] = (one ? dfunc1 : dfun);
+    }
+  }
+}
+
+void SwitchingFunction::finalize(unsigned n,const double*distance,const double*rdist,double*result,double*dfunc)const {
+  for(unsigned k=0; k<n; ++k) {
+// chain rule, and division by the distance (see calculate()):
+    double dd=dfunc[k]*invr0;
+    dd/=distance[k];
+    double rr=result[k];
+    if(rdist[k]<=0.) {
+      rr=1.;
+      dd=0.0;
+    }
+// stretch:
+    rr=rr*stretch+shift;
+    dd*=stretch;
+    const bool out=(distance[k]>dmax);
+    result[k] = (out ? 0.0 : rr);
+    dfunc[k] = (out ? 0.0 : dd);
+  }
+}
+
+void SwitchingFunction::calculateSqr(unsigned n,const double*distance2,double*value,double*dfunc)const {
+  plumed_massert(init,"you are trying to use an unset SwitchingFunction");
+  if(fastrational) {
+    double rdist[kernelChunk];
+    for(unsigned start=0; start<n; start+=kernelChunk) {
+      const unsigned nk=std::min(kernelChunk,n-start);
+      const double*d2=distance2+start;
+      double*res=value+start;
+      double*df=dfunc+start;
+      for(unsigned k=0; k<nk; ++k) rdist[k]=d2[k]*invr0_2;
+      do_rational(nk,rdist,res,df,nn/2,mm/2);
+      for(unsigned k=0; k<nk; ++k) {
+// chain rule:
+        double dd=df[k]*(2*invr0_2);
+// stretch:
+        double rr=res[k]*stretch+shift;
+        dd*=stretch;
+        const bool out=(d2[k]>dmax_2);
+        res[k] = (out ? 0.0 : rr);
+        df[k] = (out ? 0.0 : dd);
+      }
+    }
+  } else if(leptonx2 || (type!=rational && type!=exponential && type!=gaussian && type!=cubic)) {
+    for(unsigned k=0; k<n; ++k) value[k]=calculateSqr(distance2[k],dfunc[k]);
+  } else {
+    double distance[kernelChunk],rdist[kernelChunk];
+    for(unsigned start=0; start<n; start+=kernelChunk) {
+      const unsigned nk=std::min(kernelChunk,n-start);
+      const double*d2=distance2+start;
+      double*res=value+start;
+      double*df=dfunc+start;
+      for(unsigned k=0; k<nk; ++k) {
+        distance[k]=std::sqrt(d2[k]);
+        rdist[k]=(distance[k]-d0)*invr0;
+      }
+// values are computed for all distances, and then discarded by finalize() if rdist<=0 or distance>dmax
+      if(type==rational) {
+        do_rational(nk,rdist,res,df,nn,mm);
+      } else if(type==exponential) {
+        for(unsigned k=0; k<nk; ++k) {
+          res[k]=exp(-rdist[k]);
+          df[k]=-res[k];
+        }
+      } else if(type==gaussian) {
+        for(unsigned k=0; k<nk; ++k) {
+          res[k]=exp(-0.5*rdist[k]*rdist[k]);
+          df[k]=-rdist[k]*res[k];
+        }
+      } else if(type==cubic) {
+        for(unsigned k=0; k<nk; ++k) {
+          double tmp1=rdist[k]-1, tmp2=(1+2*rdist[k]);
+          res[k]=tmp1*tmp1*tmp2;
+          df[k]=2*tmp1*tmp2 + 2*tmp1*tmp1;
+        }
+      }
+      finalize(nk,distance,rdist,res,df);
+    }
+  }
+}
+
 double SwitchingFunction::calculate(double distance,double&dfunc)const {
   plumed_massert(init,"you are trying to use an unset SwitchingFunction");
   if(distance>dmax) {
@@ -482,9 +605,8 @@ double SwitchingFunction::calculate(double distance,double&dfunc)const {
       const unsigned t=OpenMP::getThreadNum();
       plumed_assert(t<expression.size());
       if(lepton_ref[t]) *lepton_ref[t]=rdist;
-      if(lepton_ref_deriv[t]) *lepton_ref_deriv[t]=rdist;
       result=expression[t].evaluate();
-      dfunc=expression_deriv[t].evaluate();
+      dfunc=expression[t].getResults()[1];
     } else plumed_merror("Unknown switching function type");
 // this is for the chain rule:
     dfunc*=invr0;
@@ -73,16 +73,18 @@ class SwitchingFunction {
 /// Low-level tool to compute rational functions.
 /// It is separated since it is called both by calculate() and calculateSqr()
   double do_rational(double rdist,double&dfunc,int nn,int mm)const;
+/// Same as do_rational(), for n numbers at once.
+/// n should not be larger than the size of the chunks used in the vectorized kernels
+  void do_rational(unsigned n,const double*rdist,double*result,double*dfunc,int nn,int mm)const;
+/// Apply the chain rule, the stretching and the cutoffs to n values computed on (distance-d0)/r0.
+/// This is the final part of calculate(), for n numbers at once
+  void finalize(unsigned n,const double*distance,const double*rdist,double*result,double*dfunc)const;
 /// Function for lepton;
   std::string lepton_func;
-/// Lepton expression.
+/// Lepton expression, calculating the function and its derivative together.
 /// \warning Since lepton::CompiledExpression is mutable, a vector is necessary for multithreading!
   std::vector<lepton::CompiledExpression> expression;
-/// Lepton expression for derivative
-/// \warning Since lepton::CompiledExpression is mutable, a vector is necessary for multithreading!
-  std::vector<lepton::CompiledExpression> expression_deriv;
   std::vector<double*> lepton_ref;
-  std::vector<double*> lepton_ref_deriv;
 /// Set to true for fast rational functions (depending on x**2 only)
   bool fastrational=false;
 /// Set to true if lepton only uses x2
@@ -110,6 +112,11 @@ public:
 /// The advantage is that in some case the expensive square root can be avoided
 /// (namely for rational functions, if nn and mm are even and d0 is zero)
   double calculateSqr(double distance2,double&dfunc)const;
+/// Compute the switching function on n squared distances at once.
+/// Equivalent to calling calculateSqr() on each of the n distances, but the type
+/// of the function is only checked once and rational, exponential, gaussian and cubic
+/// functions are computed with vectorizable kernels.
+  void calculateSqr(unsigned n,const double*distance2,double*value,double*dfunc)const;
 /// Returns d0
   double get_d0() const;
 /// Returns r0
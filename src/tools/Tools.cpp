@@ -24,6 +24,7 @@
 #include "Exception.h"
 #include "IFile.h"
 #include "lepton/Lepton.h"
+#include <cstdlib>
 #include <cstring>
 #include <dirent.h>
 #include <iostream>
@@ -119,6 +120,55 @@ bool Tools::convert(const string & str,string & t) {
   return true;
 }
 
+bool Tools::convertFast(const char* b,const char* e,double & t) {
+// exact powers of ten: a product or quotient of a mantissa smaller than 2^53
+// and one of these numbers is correctly rounded
+  static const double pow10[]= {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+                                1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22
+                               };
+  bool neg=false;
+  if(b<e && (*b=='-' || *b=='+')) { neg=(*b=='-'); b++; }
+  unsigned long long mantissa=0;
+  int ndigits=0, exponent=0;
+  bool any=false, exact=true;
+  for(; b<e && *b>='0' && *b<='9'; b++) {
+    any=true;
+    if(mantissa==0 && *b=='0') continue;
+    if(ndigits>=19) { exact=false; continue; }
+    mantissa=10*mantissa+(*b-'0'); ndigits++;
+  }
+  if(b<e && *b=='.') {
+    for(b++; b<e && *b>='0' && *b<='9'; b++) {
+      any=true;
+      if(mantissa==0 && *b=='0') { exponent--; continue; }
+      if(ndigits>=19) { exact=false; continue; }
+      exponent--;
+      mantissa=10*mantissa+(*b-'0'); ndigits++;
+    }
+  }
+  if(!any) return false;
+  if(b<e && (*b=='e' || *b=='E')) {
+    b++;
+    bool eneg=false;
+    if(b<e && (*b=='-' || *b=='+')) { eneg=(*b=='-'); b++; }
+    if(b>=e || *b<'0' || *b>'9') return false;
+    int ee=0;
+    for(; b<e && *b>='0' && *b<='9'; b++) { if(ee<10000) ee=10*ee+(*b-'0'); }
+    exponent+=(eneg?-ee:ee);
+  }
+  if(b!=e) return false;
+  if(exact && mantissa<=(1ULL<<53) && exponent>=-22 && exponent<=22) {
+    double d=double(mantissa);
+    if(exponent<0) d/=pow10[-exponent];
+    else d*=pow10[exponent];
+    t=(neg?-d:d);
+    return true;
+  }
+// valid number that cannot be converted exactly with the fast path,
+// it is left to convert()
+  return false;
+}
+
 vector<string> Tools::getWords(const string & line,const char* separators,int * parlevel,const char* parenthesis) {
   plumed_massert(strlen(parenthesis)==1,"multiple parenthesis type not available");
   plumed_massert(parenthesis[0]=='(' || parenthesis[0]=='[' || parenthesis[0]=='{',
@@ -87,6 +87,12 @@ public:
   static bool convert(const std::string & str,AtomNumber & t);
 /// Convert a string to a string (i.e. copy)
   static bool convert(const std::string & str,std::string & t);
+/// Convert the characters in [begin,end) to a double without allocating memory.
+/// Only plain decimal numbers (e.g. -1.5e-3) that can be converted exactly
+/// (at most 19 significant digits and exponents within +-22) are accepted.
+/// If false is returned t is not modified and convert() should be used, which also interprets
+/// expressions, PI, etc.
+  static bool convertFast(const char* begin,const char* end,double & t);
 /// Convert anything into a string
   template<typename T>
   static void convert(T i,std::string & str);
@@ -24,6 +24,7 @@
 
 #include "core/ActionRegister.h"
 #include "lepton/Lepton.h"
+#include "tools/OpenMP.h"
 
 
 namespace PLMD {
@@ -104,10 +105,12 @@ BF_CUSTOM ...
 
 class BF_Custom : public BasisFunctions {
 private:
-  lepton::CompiledExpression transf_value_expression_;
-  lepton::CompiledExpression transf_deriv_expression_;
-  std::vector<lepton::CompiledExpression> bf_values_expressions_;
-  std::vector<lepton::CompiledExpression> bf_derivs_expressions_;
+  // the values and the derivatives are calculated together, with one copy
+  // of the expressions for each thread as lepton::CompiledExpression is mutable
+  std::vector<lepton::CompiledExpression> transf_expressions_;
+  std::vector<double*> transf_refs_;
+  std::vector<lepton::CompiledExpression> bf_expressions_;
+  std::vector<double*> bf_refs_;
   std::string variable_str_;
   std::string transf_variable_str_;
   bool do_transf_;
@@ -134,8 +137,10 @@ void BF_Custom::registerKeywords(Keywords& keys) {
 
 BF_Custom::BF_Custom(const ActionOptions&ao):
   PLUMED_VES_BASISFUNCTIONS_INIT(ao),
-  bf_values_expressions_(0),
-  bf_derivs_expressions_(0),
+  transf_expressions_(0),
+  transf_refs_(0),
+  bf_expressions_(0),
+  bf_refs_(0),
   variable_str_("x"),
   transf_variable_str_("t"),
   do_transf_(false),
@@ -170,8 +175,8 @@ BF_Custom::BF_Custom(const ActionOptions&ao):
   bf_values_parsed[0] = "1";
   bf_derivs_parsed[0] = "0";
   //
-  bf_values_expressions_.resize(getNumberOfBasisFunctions());
-  bf_derivs_expressions_.resize(getNumberOfBasisFunctions());
+  std::vector<lepton::ParsedExpression> bf_values_pes(getNumberOfBasisFunctions()-1);
+  std::vector<lepton::ParsedExpression> bf_derivs_pes(getNumberOfBasisFunctions()-1);
   //
   for(unsigned int i=1; i<getNumberOfBasisFunctions(); i++) {
     std::string is; Tools::convert(i,is);
@@ -179,14 +184,15 @@ BF_Custom::BF_Custom(const ActionOptions&ao):
       lepton::ParsedExpression pe_value = lepton::Parser::parse(bf_str[i]).optimize(lepton::Constants());
       std::ostringstream tmp_stream; tmp_stream << pe_value;
       bf_values_parsed[i] = tmp_stream.str();
-      bf_values_expressions_[i] = pe_value.createCompiledExpression();
+      bf_values_pes[i-1] = pe_value;
     }
     catch(PLMD::lepton::Exception& exc) {
       plumed_merror("There was some problem in parsing the function "+bf_str[i]+" given in FUNC"+is + " with lepton");
     }
 
     std::vector<std::string> var_str;
-    for(auto &p: bf_values_expressions_[i].getVariables()) {
+    lepton::CompiledExpression ce_value = bf_values_pes[i-1].createCompiledExpression();
+    for(auto &p: ce_value.getVariables()) {
       var_str.push_back(p);
     }
     if(var_str.size()!=1) {
@@ -200,14 +206,27 @@ BF_Custom::BF_Custom(const ActionOptions&ao):
       lepton::ParsedExpression pe_deriv = lepton::Parser::parse(bf_str[i]).differentiate(variable_str_).optimize(lepton::Constants());
       std::ostringstream tmp_stream2; tmp_stream2 << pe_deriv;
       bf_derivs_parsed[i] = tmp_stream2.str();
-      bf_derivs_expressions_[i] = pe_deriv.createCompiledExpression();
+      bf_derivs_pes[i-1] = pe_deriv;
     }
     catch(PLMD::lepton::Exception& exc) {
       plumed_merror("There was some problem in parsing the derivative of the function "+bf_str[i]+" given in FUNC"+is + " with lepton");
     }
 
   }
+  // all the basis functions and their derivatives are compiled together,
+  // so that their common subexpressions are calculated only once
+  std::vector<lepton::ParsedExpression> bf_pes(bf_values_pes);
+  bf_pes.insert(bf_pes.end(),bf_derivs_pes.begin(),bf_derivs_pes.end());
+  bf_expressions_.resize(OpenMP::getNumThreads());
+  bf_refs_.resize(bf_expressions_.size());
+  for(unsigned int t=0; t<bf_expressions_.size(); t++) {
+    bf_expressions_[t] = lepton::CompiledExpression(bf_pes);
+    try {
+      bf_refs_[t] = &bf_expressions_[t].getVariableReference(variable_str_);
+    } catch(PLMD::lepton::Exception& exc) {bf_refs_[t] = NULL;}
+  }
 
+  lepton::ParsedExpression transf_value_pe;
   std::string transf_value_parsed;
   std::string transf_deriv_parsed;
   std::string transf_str;
@@ -228,14 +247,15 @@ BF_Custom::BF_Custom(const ActionOptions&ao):
       lepton::ParsedExpression pe_value = lepton::Parser::parse(transf_str).optimize(lepton::Constants());;
       std::ostringstream tmp_stream; tmp_stream << pe_value;
       transf_value_parsed = tmp_stream.str();
-      transf_value_expression_ = pe_value.createCompiledExpression();
+      transf_value_pe = pe_value;
     }
     catch(PLMD::lepton::Exception& exc) {
       plumed_merror("There was some problem in parsing the function "+transf_str+" given in TRANSFORM with lepton");
     }
 
     std::vector<std::string> var_str;
-    for(auto &p: transf_value_expression_.getVariables()) {
+    lepton::CompiledExpression ce_value = transf_value_pe.createCompiledExpression();
+    for(auto &p: ce_value.getVariables()) {
       var_str.push_back(p);
     }
     if(var_str.size()!=1) {
@@ -249,7 +269,16 @@ BF_Custom::BF_Custom(const ActionOptions&ao):
       lepton::ParsedExpression pe_deriv = lepton::Parser::parse(transf_str).differentiate(transf_variable_str_).optimize(lepton::Constants());;
       std::ostringstream tmp_stream2; tmp_stream2 << pe_deriv;
       transf_deriv_parsed = tmp_stream2.str();
-      transf_deriv_expression_ = pe_deriv.createCompiledExpression();
+      std::vector<lepton::ParsedExpression> transf_pes(1,transf_value_pe);
+      transf_pes.push_back(pe_deriv);
+      transf_expressions_.resize(OpenMP::getNumThreads());
+      transf_refs_.resize(transf_expressions_.size());
+      for(unsigned int t=0; t<transf_expressions_.size(); t++) {
+        transf_expressions_[t] = lepton::CompiledExpression(transf_pes);
+        try {
+          transf_refs_[t] = &transf_expressions_[t].getVariableReference(transf_variable_str_);
+        } catch(PLMD::lepton::Exception& exc) {transf_refs_[t] = NULL;}
+      }
     }
     catch(PLMD::lepton::Exception& exc) {
       plumed_merror("There was some problem in parsing the derivative of the function "+transf_str+" given in TRANSFORM with lepton");
@@ -288,21 +317,13 @@ void BF_Custom::getAllValues(const double arg, double& argT, bool& inside_range,
   inside_range=true;
   argT=checkIfArgumentInsideInterval(arg,inside_range);
   double transf_derivf=1.0;
+  const unsigned int t=OpenMP::getThreadNum();
   //
   if(do_transf_) {
-    // has to copy as the function is const
-    lepton::CompiledExpression ce_value = transf_value_expression_;
-    try {
-      ce_value.getVariableReference(transf_variable_str_) = argT;
-    } catch(PLMD::lepton::Exception& exc) {}
-
-    lepton::CompiledExpression ce_deriv = transf_deriv_expression_;
-    try {
-      ce_deriv.getVariableReference(transf_variable_str_) = argT;
-    } catch(PLMD::lepton::Exception& exc) {}
-
-    argT = ce_value.evaluate();
-    transf_derivf = ce_deriv.evaluate();
+    plumed_assert(t<transf_expressions_.size());
+    if(transf_refs_[t]) {*transf_refs_[t] = argT;}
+    argT = transf_expressions_[t].evaluate();
+    transf_derivf = transf_expressions_[t].getResults()[1];
 
     if(check_nan_inf_ && (std::isnan(argT) || std::isinf(argT)) ) {
       std::string vs; Tools::convert(argT,vs);
@@ -317,18 +338,14 @@ void BF_Custom::getAllValues(const double arg, double& argT, bool& inside_range,
   //
   values[0]=1.0;
   derivs[0]=0.0;
+  plumed_assert(t<bf_expressions_.size());
+  if(bf_refs_[t]) {*bf_refs_[t] = argT;}
+  bf_expressions_[t].evaluate();
+  const std::vector<double>& results = bf_expressions_[t].getResults();
+  const unsigned int nfuncs = getNumberOfBasisFunctions()-1;
   for(unsigned int i=1; i < getNumberOfBasisFunctions(); i++) {
-    lepton::CompiledExpression ce_value = bf_values_expressions_[i];
-    try {
-      ce_value.getVariableReference(variable_str_) = argT;
-    } catch(PLMD::lepton::Exception& exc) {}
-    values[i] = ce_value.evaluate();
-
-    lepton::CompiledExpression ce_deriv = bf_derivs_expressions_[i];
-    try {
-      ce_deriv.getVariableReference(variable_str_) = argT;
-    } catch(PLMD::lepton::Exception& exc) {}
-    derivs[i] = ce_deriv.evaluate();
+    values[i] = results[i-1];
+    derivs[i] = results[nfuncs+i-1];
     if(do_transf_) {derivs[i]*=transf_derivf;}
     // NaN checks
     if(check_nan_inf_ && (std::isnan(values[i]) || std::isinf(values[i])) ) {
@@ -32,6 +32,10 @@
 #include "tools/Keywords.h"
 #include "tools/Grid.h"
 #include "tools/Communicator.h"
+#include "tools/OpenMP.h"
+#include "blas/blas.h"
+
+#include <algorithm>
 
 #include "GridProjWeights.h"
 
@@ -191,11 +195,15 @@ void LinearBasisSetExpansion::updateBiasGrid() {
   if(action_pntr_!=NULL &&  getStepOfLastBiasGridUpdate()==action_pntr_->getStep()) {
     return;
   }
+  std::vector<double> bias_values;
+  std::vector< std::vector<double> > forces_values;
+  getBiasAndForcesOnGrid(bias_grid_pntr_,bias_values,forces_values);
+  std::vector<double> forces(nargs_,0.0);
   for(Grid::index_t l=0; l<bias_grid_pntr_->getSize(); l++) {
-    std::vector<double> forces(nargs_);
-    std::vector<double> args = bias_grid_pntr_->getPoint(l);
-    bool all_inside=true;
-    double bias=getBiasAndForces(args,all_inside,forces);
+    double bias=bias_values[l];
+    for(unsigned int k=0; k<forces_values.size(); k++) {
+      forces[k]=forces_values[k][l];
+    }
     //
     if(biasCutoffActive()) {
       vesbias_pntr_->applyBiasCutoff(bias,forces);
@@ -226,11 +234,15 @@ void LinearBasisSetExpansion::updateBiasWithoutCutoffGrid() {
     return;
   }
   //
+  std::vector<double> bias_values;
+  std::vector< std::vector<double> > forces_values;
+  getBiasAndForcesOnGrid(bias_withoutcutoff_grid_pntr_,bias_values,forces_values);
+  std::vector<double> forces(nargs_,0.0);
   for(Grid::index_t l=0; l<bias_withoutcutoff_grid_pntr_->getSize(); l++) {
-    std::vector<double> forces(nargs_);
-    std::vector<double> args = bias_withoutcutoff_grid_pntr_->getPoint(l);
-    bool all_inside=true;
-    double bias=getBiasAndForces(args,all_inside,forces);
+    double bias=bias_values[l];
+    for(unsigned int k=0; k<forces_values.size(); k++) {
+      forces[k]=forces_values[k][l];
+    }
     if(bias_withoutcutoff_grid_pntr_->hasDerivatives()) {
       bias_withoutcutoff_grid_pntr_->setValueAndDerivatives(l,bias,forces);
     }
@@ -367,12 +379,160 @@ void LinearBasisSetExpansion::writeTargetDistributionToFile(const std::string& f
 }
 
 
+// Multiply the column-major tensor in, which has shape[k] elements along dimension k,
+// by a matrix M along dimension k, i.e. out[..,a,..] = alpha * sum_b M(a,b) in[..,b,..].
+// M is table, stored as a nout x shape[k] column-major matrix, or its transpose if transpose is true.
+// Only the slices of the tensor with index r in [r_begin,r_end) for the dimensions following k are calculated.
+static void multiplyAlongDimension(const double* in, const std::vector<unsigned int>& shape, const unsigned int k, const double* table, const bool transpose, const unsigned int nout, const double alpha, double* out, const size_t r_begin, const size_t r_end) {
+  if(r_end<=r_begin) {return;}
+  int nleft=1;
+  for(unsigned int i=0; i<k; i++) {nleft*=shape[i];}
+  int nin=shape[k];
+  int nout_int=nout;
+  double zero=0.0;
+  double alpha_tmp=alpha;
+  int ldtable = transpose ? nin : nout_int;
+  unsigned nt=OpenMP::getNumThreads();
+  if(k==0) {
+    // a single product of matrices, with columns split in nt blocks
+    // that are distributed among the threads
+    if(nt>r_end-r_begin) {nt=r_end-r_begin;}
+    size_t nr=(r_end-r_begin+nt-1)/nt;
+    #pragma omp parallel for num_threads(nt)
+    for(unsigned int t=0; t<nt; t++) {
+      size_t rb=std::min(r_begin+t*nr,r_end);
+      int ncols=std::min(rb+nr,r_end)-rb;
+      if(ncols>0) {
+        plumed_blas_dgemm(transpose?"T":"N","N",&nout_int,&ncols,&nin,&alpha_tmp,const_cast<double*>(table),&ldtable,
+                          const_cast<double*>(in)+nin*rb,&nin,&zero,out+nout_int*rb,&nout_int);
+      }
+    }
+  }
+  else {
+    // one product of matrices for each slice
+    if(nt>r_end-r_begin) {nt=r_end-r_begin;}
+    #pragma omp parallel for num_threads(nt)
+    for(size_t r=r_begin; r<r_end; r++) {
+      int nleft_tmp=nleft;
+      plumed_blas_dgemm("N",transpose?"N":"T",&nleft_tmp,&nout_int,&nin,&alpha_tmp,const_cast<double*>(in)+nleft*nin*r,&nleft_tmp,
+                        const_cast<double*>(table),&ldtable,&zero,out+nleft*nout_int*r,&nleft_tmp);
+    }
+  }
+}
+
+
+// Contract the first index of the column-major tensor a, which has n rows and ncols columns,
+// with the vector x, i.e. out[m] = sum_i a[i+n*m]*x[i]
+static void contractFirstIndex(const double* a, const unsigned int n, const size_t ncols, const double* x, double* out) {
+  if(ncols==0) {return;}
+  int nrows_int=n;
+  int ncols_int=ncols;
+  int inc=1;
+  double one=1.0;
+  double zero=0.0;
+  plumed_blas_dgemv("T",&nrows_int,&ncols_int,&one,const_cast<double*>(a),&nrows_int,const_cast<double*>(x),&inc,&zero,out,&inc);
+}
+
+
+void LinearBasisSetExpansion::setupGridBasisFunctions(const Grid* grid_pntr) {
+  plumed_assert(grid_pntr->getDimension()==nargs_);
+  if(grid_bf_nbin_==grid_pntr->getNbin() && grid_bf_min_==grid_pntr->getMin() && grid_bf_max_==grid_pntr->getMax()) {
+    return;
+  }
+  grid_bf_nbin_=grid_pntr->getNbin();
+  grid_bf_min_=grid_pntr->getMin();
+  grid_bf_max_=grid_pntr->getMax();
+  grid_bf_values_.assign(nargs_,std::vector<double>());
+  grid_bf_derivs_.assign(nargs_,std::vector<double>());
+  // the grid is a tensor product, so that the basis functions of each argument
+  // only need to be evaluated on the points along the corresponding axis
+  std::vector<unsigned int> indices(nargs_,0);
+  for(unsigned int k=0; k<nargs_; k++) {
+    unsigned int nbf=basisf_pntrs_[k]->getNumberOfBasisFunctions();
+    unsigned int npoints=grid_bf_nbin_[k];
+    grid_bf_values_[k].assign(npoints*nbf,0.0);
+    grid_bf_derivs_[k].assign(npoints*nbf,0.0);
+    std::vector<double> bf_values(nbf);
+    std::vector<double> bf_derivs(nbf);
+    for(unsigned int a=0; a<npoints; a++) {
+      indices[k]=a;
+      double arg_trsfrm;
+      bool inside=true;
+      basisf_pntrs_[k]->getAllValues(grid_pntr->getPoint(indices)[k],arg_trsfrm,inside,bf_values,bf_derivs);
+      for(unsigned int b=0; b<nbf; b++) {
+        grid_bf_values_[k][a+npoints*b]=bf_values[b];
+        grid_bf_derivs_[k][a+npoints*b]=bf_derivs[b];
+      }
+    }
+    indices[k]=0;
+  }
+}
+
+
+void LinearBasisSetExpansion::getBiasAndForcesOnGrid(const Grid* grid_pntr, std::vector<double>& bias_values, std::vector< std::vector<double> >& forces_values) {
+  setupGridBasisFunctions(grid_pntr);
+  const bool usederiv=grid_pntr->hasDerivatives();
+  //
+  // The coeffs tensor is multiplied by the tables of the basis functions one dimension
+  // at a time, starting from the last one. forces_values[k] follows the same path but uses
+  // the derivatives for dimension k, so it branches off from the bias when k is reached.
+  // All the processes calculate the intermediate results, while the last multiplication,
+  // which gives the full grid, is split among the processes.
+  std::vector<unsigned int> shape=bias_coeffs_pntr_->shapeOfIndices();
+  std::vector<double> values=bias_coeffs_pntr_->getDataAsVector();
+  std::vector< std::vector<double> > derivs(nargs_);
+  std::vector<double> tmp;
+  for(unsigned int k=nargs_-1; k>0; k--) {
+    size_t nslices=1;
+    for(unsigned int i=k+1; i<nargs_; i++) {nslices*=shape[i];}
+    size_t newsize=values.size()/shape[k]*grid_bf_nbin_[k];
+    if(usederiv) {
+      for(unsigned int j=k+1; j<nargs_; j++) {
+        tmp.resize(newsize);
+        multiplyAlongDimension(derivs[j].data(),shape,k,grid_bf_values_[k].data(),false,grid_bf_nbin_[k],1.0,tmp.data(),0,nslices);
+        derivs[j].swap(tmp);
+      }
+      derivs[k].resize(newsize);
+      multiplyAlongDimension(values.data(),shape,k,grid_bf_derivs_[k].data(),false,grid_bf_nbin_[k],1.0,derivs[k].data(),0,nslices);
+    }
+    tmp.resize(newsize);
+    multiplyAlongDimension(values.data(),shape,k,grid_bf_values_[k].data(),false,grid_bf_nbin_[k],1.0,tmp.data(),0,nslices);
+    values.swap(tmp);
+    shape[k]=grid_bf_nbin_[k];
+  }
+  //
+  size_t nslices=values.size()/shape[0];
+  size_t stride=mycomm_.Get_size();
+  size_t rank=mycomm_.Get_rank();
+  size_t nslices_rank=(nslices+stride-1)/stride;
+  size_t r_begin=std::min(rank*nslices_rank,nslices);
+  size_t r_end=std::min(r_begin+nslices_rank,nslices);
+  //
+  bias_values.assign(grid_pntr->getSize(),0.0);
+  multiplyAlongDimension(values.data(),shape,0,grid_bf_values_[0].data(),false,grid_bf_nbin_[0],1.0,bias_values.data(),r_begin,r_end);
+  mycomm_.Sum(bias_values);
+  if(usederiv) {
+    forces_values.assign(nargs_,std::vector<double>(grid_pntr->getSize(),0.0));
+    multiplyAlongDimension(values.data(),shape,0,grid_bf_derivs_[0].data(),false,grid_bf_nbin_[0],-1.0,forces_values[0].data(),r_begin,r_end);
+    for(unsigned int k=1; k<nargs_; k++) {
+      multiplyAlongDimension(derivs[k].data(),shape,0,grid_bf_values_[0].data(),false,grid_bf_nbin_[0],-1.0,forces_values[k].data(),r_begin,r_end);
+    }
+    for(unsigned int k=0; k<nargs_; k++) {
+      mycomm_.Sum(forces_values[k]);
+    }
+  }
+  else {
+    forces_values.clear();
+  }
+}
+
+
 double LinearBasisSetExpansion::getBiasAndForces(const std::vector<double>& args_values, bool& all_inside, std::vector<double>& forces, std::vector<double>& coeffsderivs_values, std::vector<BasisFunctions*>& basisf_pntrs_in, CoeffsVector* coeffs_pntr_in, Communicator* comm_in) {
   unsigned int nargs = args_values.size();
   plumed_assert(coeffs_pntr_in->numberOfDimensions()==nargs);
   plumed_assert(basisf_pntrs_in.size()==nargs);
   plumed_assert(forces.size()==nargs);
-  plumed_assert(coeffsderivs_values.size()==coeffs_pntr_in->numberOfCoeffs());
+  plumed_assert(coeffsderivs_values.size()==coeffs_pntr_in->numberOfCoeffs() || coeffsderivs_values.size()==0);
 
   std::vector<double> args_values_trsfrm(nargs);
   // std::vector<bool>   inside_interval(nargs,true);
@@ -382,6 +542,7 @@ double LinearBasisSetExpansion::getBiasAndForces(const std::vector<double>& args
   std::vector< std::vector <double> > bf_derivs(nargs);
   //
   for(unsigned int k=0; k<nargs; k++) {
+    plumed_assert(basisf_pntrs_in[k]->getNumberOfBasisFunctions()==coeffs_pntr_in->shapeOfIndices(k));
     bf_values[k].assign(basisf_pntrs_in[k]->getNumberOfBasisFunctions(),0.0);
     bf_derivs[k].assign(basisf_pntrs_in[k]->getNumberOfBasisFunctions(),0.0);
     bool curr_inside=true;
@@ -398,31 +559,68 @@ double LinearBasisSetExpansion::getBiasAndForces(const std::vector<double>& args
     stride=comm_in->Get_size();
     rank=comm_in->Get_rank();
   }
-  // loop over coeffs
-  double bias=0.0;
-  for(size_t i=rank; i<coeffs_pntr_in->numberOfCoeffs(); i+=stride) {
-    std::vector<unsigned int> indices=coeffs_pntr_in->getIndices(i);
-    double coeff = coeffs_pntr_in->getValue(i);
-    double bf_curr=1.0;
-    for(unsigned int k=0; k<nargs; k++) {
-      bf_curr*=bf_values[k][indices[k]];
+  // The coeffs are stored as a tensor where the first index runs fastest.
+  // The sum over the coeffs is done contracting the tensor one dimension at a time,
+  // so that the bias and all the forces are obtained with a few matrix-vector products:
+  // contr[nargs] is contracted with the values of the basis functions, while
+  // contr[k] is contracted with the derivatives for dimension k and with the values otherwise.
+  // Only the first contraction involves all the coeffs, so that it is split among
+  // the processes in blocks of columns. The following ones are linear in the
+  // partial results, which are then summed at the end.
+  const unsigned int nrows = coeffs_pntr_in->shapeOfIndices(0);
+  size_t ncols = coeffs_pntr_in->numberOfCoeffs()/nrows;
+  const size_t ncols_rank = (ncols+stride-1)/stride;
+  const size_t col_begin = std::min(rank*ncols_rank,ncols);
+  const size_t col_end = std::min(col_begin+ncols_rank,ncols);
+  const double* coeffs = &(*coeffs_pntr_in)[0];
+  //
+  std::vector< std::vector<double> > contr(nargs+1);
+  contr[nargs].assign(ncols,0.0);
+  contr[0].assign(ncols,0.0);
+  contractFirstIndex(coeffs+nrows*col_begin,nrows,col_end-col_begin,bf_values[0].data(),contr[nargs].data()+col_begin);
+  contractFirstIndex(coeffs+nrows*col_begin,nrows,col_end-col_begin,bf_derivs[0].data(),contr[0].data()+col_begin);
+  std::vector<double> tmp;
+  for(unsigned int j=1; j<nargs; j++) {
+    const unsigned int nj = coeffs_pntr_in->shapeOfIndices(j);
+    ncols /= nj;
+    for(unsigned int k=0; k<j; k++) {
+      tmp.resize(ncols);
+      contractFirstIndex(contr[k].data(),nj,ncols,bf_values[j].data(),tmp.data());
+      contr[k].swap(tmp);
     }
-    bias+=coeff*bf_curr;
-    coeffsderivs_values[i] = bf_curr;
-    for(unsigned int k=0; k<nargs; k++) {
-      double der = 1.0;
-      for(unsigned int l=0; l<nargs; l++) {
-        if(l!=k) {der*=bf_values[l][indices[l]];}
-        else {der*=bf_derivs[l][indices[l]];}
+    contr[j].resize(ncols);
+    contractFirstIndex(contr[nargs].data(),nj,ncols,bf_derivs[j].data(),contr[j].data());
+    tmp.resize(ncols);
+    contractFirstIndex(contr[nargs].data(),nj,ncols,bf_values[j].data(),tmp.data());
+    contr[nargs].swap(tmp);
+  }
+  double bias=contr[nargs][0];
+  for(unsigned int k=0; k<nargs; k++) {
+    forces[k]=-contr[k][0];
+  }
+  //
+  // the values of the basis set are the outer product of the values of the basis functions.
+  // All the processes calculate all of them, as VesBias::addToSampledAverages
+  // needs the full vector to update the averages without communication
+  if(coeffsderivs_values.size()>0) {
+    std::vector<unsigned int> col_indices(nargs,0);
+    for(size_t m=0; m<coeffs_pntr_in->numberOfCoeffs()/nrows; m++) {
+      double col_value=1.0;
+      for(unsigned int k=1; k<nargs; k++) {
+        col_value*=bf_values[k][col_indices[k]];
+      }
+      double* col_coeffsderivs=&coeffsderivs_values[nrows*m];
+      for(unsigned int i=0; i<nrows; i++) {
+        col_coeffsderivs[i]=col_value*bf_values[0][i];
+      }
+      for(unsigned int k=1; k<nargs; k++) {
+        if(++col_indices[k]<coeffs_pntr_in->shapeOfIndices(k)) {break;}
+        col_indices[k]=0;
       }
-      forces[k]-=coeff*der;
-      // maybe faster but dangerous
-      // forces[k]-=coeff*bf_curr*(bf_derivs[k][indices[k]]/bf_values[k][indices[k]]);
     }
   }
   //
   if(comm_in!=NULL) {
-    // coeffsderivs_values is not summed as the mpi Sum is done later on for the averages
     comm_in->Sum(bias);
     comm_in->Sum(forces);
   }
@@ -570,20 +768,34 @@ void LinearBasisSetExpansion::restartTargetDistribution() {
 
 void LinearBasisSetExpansion::calculateTargetDistAveragesFromGrid(const Grid* targetdist_grid_pntr) {
   plumed_assert(targetdist_grid_pntr!=NULL);
-  std::vector<double> targetdist_averages(ncoeffs_,0.0);
   std::vector<double> integration_weights = GridIntegrationWeights::getIntegrationWeights(targetdist_grid_pntr);
-  Grid::index_t stride=mycomm_.Get_size();
-  Grid::index_t rank=mycomm_.Get_rank();
-  for(Grid::index_t l=rank; l<targetdist_grid_pntr->getSize(); l+=stride) {
-    std::vector<double> args_values = targetdist_grid_pntr->getPoint(l);
-    std::vector<double> basisset_values(ncoeffs_);
-    // parallelization done over the grid -> should NOT use parallel in getBasisSetValues!!
-    getBasisSetValues(args_values,basisset_values,false);
-    double weight = integration_weights[l]*targetdist_grid_pntr->getValue(l);
-    for(unsigned int i=0; i<ncoeffs_; i++) {
-      targetdist_averages[i] += weight*basisset_values[i];
-    }
-  }
+  std::vector<double> weights(targetdist_grid_pntr->getSize());
+  for(Grid::index_t l=0; l<targetdist_grid_pntr->getSize(); l++) {
+    weights[l] = integration_weights[l]*targetdist_grid_pntr->getValue(l);
+  }
+  // the weights on the grid are multiplied by the transposed tables of the basis functions
+  // one dimension at a time. The first multiplication, which involves the full grid,
+  // is split among the processes and the partial results are summed at the end
+  setupGridBasisFunctions(targetdist_grid_pntr);
+  std::vector<unsigned int> shape=grid_bf_nbin_;
+  size_t nslices=weights.size()/shape[0];
+  size_t stride=mycomm_.Get_size();
+  size_t rank=mycomm_.Get_rank();
+  size_t nslices_rank=(nslices+stride-1)/stride;
+  size_t r_begin=std::min(rank*nslices_rank,nslices);
+  size_t r_end=std::min(r_begin+nslices_rank,nslices);
+  std::vector<double> targetdist_averages(nslices*nbasisf_[0],0.0);
+  multiplyAlongDimension(weights.data(),shape,0,grid_bf_values_[0].data(),true,nbasisf_[0],1.0,targetdist_averages.data(),r_begin,r_end);
+  shape[0]=nbasisf_[0];
+  std::vector<double> tmp;
+  for(unsigned int k=1; k<nargs_; k++) {
+    nslices/=shape[k];
+    tmp.resize(targetdist_averages.size()/shape[k]*nbasisf_[k]);
+    multiplyAlongDimension(targetdist_averages.data(),shape,k,grid_bf_values_[k].data(),true,nbasisf_[k],1.0,tmp.data(),0,nslices);
+    targetdist_averages.swap(tmp);
+    shape[k]=nbasisf_[k];
+  }
+  plumed_assert(targetdist_averages.size()==ncoeffs_);
   mycomm_.Sum(targetdist_averages);
   // the overall constant;
   targetdist_averages[0] = getBasisSetConstant();
@@ -83,6 +83,15 @@ private:
   Grid* targetdist_grid_pntr_;
   //
   TargetDistribution* targetdist_pntr_;
+  //
+  // values and derivatives of the basis functions on the points of the grids, for each
+  // argument stored as a (number of grid points) x (number of basis functions) column-major matrix
+  std::vector< std::vector<double> > grid_bf_values_;
+  std::vector< std::vector<double> > grid_bf_derivs_;
+  // shape and range of the grid used for grid_bf_values_ and grid_bf_derivs_
+  std::vector<unsigned int> grid_bf_nbin_;
+  std::vector<std::string> grid_bf_min_;
+  std::vector<std::string> grid_bf_max_;
 public:
   static void registerKeywords( Keywords& keys );
   // Constructor
@@ -117,7 +126,7 @@ public:
   //
   void linkVesBias(VesBias*);
   void linkAction(Action*);
-  // calculate bias and derivatives
+  // calculate bias and derivatives, coeffsderivs_values can be left empty if not needed
   static double getBiasAndForces(const std::vector<double>&, bool&, std::vector<double>&, std::vector<double>&, std::vector<BasisFunctions*>&, CoeffsVector*, Communicator* comm_in=NULL);
   double getBiasAndForces(const std::vector<double>&, bool&, std::vector<double>&, std::vector<double>&);
   double getBiasAndForces(const std::vector<double>&, bool&, std::vector<double>&);
@@ -188,6 +197,10 @@ private:
   void calculateTargetDistAveragesFromGrid(const Grid*);
   //
   bool isStaticTargetDistFileOutputActive() const;
+  //
+  void setupGridBasisFunctions(const Grid*);
+  // calculate the bias (and the forces if the grid has derivatives) on all the points of a grid
+  void getBiasAndForcesOnGrid(const Grid*, std::vector<double>&, std::vector< std::vector<double> >&);
 };
 
 
@@ -199,7 +212,7 @@ double LinearBasisSetExpansion::getBiasAndForces(const std::vector<double>& args
 
 inline
 double LinearBasisSetExpansion::getBiasAndForces(const std::vector<double>& args_values, bool& all_inside, std::vector<double>& forces) {
-  std::vector<double> coeffsderivs_values_dummy(ncoeffs_);
+  std::vector<double> coeffsderivs_values_dummy;
   return getBiasAndForces(args_values,all_inside,forces,coeffsderivs_values_dummy,basisf_pntrs_, bias_coeffs_pntr_, &mycomm_);
 }
 
@@ -207,7 +220,7 @@ double LinearBasisSetExpansion::getBiasAndForces(const std::vector<double>& args
 inline
 double LinearBasisSetExpansion::getBias(const std::vector<double>& args_values, bool& all_inside, const bool parallel) {
   std::vector<double> forces_dummy(nargs_);
-  std::vector<double> coeffsderivs_values_dummy(ncoeffs_);
+  std::vector<double> coeffsderivs_values_dummy;
   if(parallel) {
     return getBiasAndForces(args_values,all_inside,forces_dummy,coeffsderivs_values_dummy,basisf_pntrs_, bias_coeffs_pntr_, &mycomm_);
   }
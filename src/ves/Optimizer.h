@@ -191,6 +191,7 @@ public:
   void apply() {};
   void calculate() {};
   void update();
+  bool isHistoryDependent()const override {return true;}
   unsigned int getNumberOfDerivatives() {return 0;}
   //
   bool fixedStepSize() const {return fixed_stepsize_;}
@@ -118,6 +118,8 @@ private:
   void setupAdditionalGrids(const std::vector<Value*>&, const std::vector<std::string>&, const std::vector<std::string>&, const std::vector<unsigned int>&);
   //
   lepton::CompiledExpression expression;
+  // values of the variables used by expression: the CVs, followed by FE, kBT and beta
+  std::vector<double> var_values_;
   //
   std::vector<unsigned int> cv_var_idx_;
   std::vector<std::string> cv_var_str_;
@@ -205,6 +207,17 @@ TD_Custom::TD_Custom(const ActionOptions& ao):
     std::string str1; Tools::convert(cv_var_idx_[j]+1,str1);
     cv_var_str_[j] = cv_var_prefix_str_+str1;
   }
+  // the expression reads the variables directly from var_values_
+  const unsigned int ncvs = cv_var_str_.size();
+  var_values_.assign(ncvs+3,0.0);
+  std::map<std::string, double*> var_locations;
+  for(unsigned int j=0; j<ncvs; j++) {
+    var_locations[cv_var_str_[j]] = &var_values_[j];
+  }
+  if(use_fes_) {var_locations[fes_var_str_] = &var_values_[ncvs];}
+  if(use_kbt_) {var_locations[kbt_var_str_] = &var_values_[ncvs+1];}
+  if(use_beta_) {var_locations[beta_var_str_] = &var_values_[ncvs+2];}
+  expression.setVariableLocations(var_locations);
 }
 
 
@@ -225,32 +238,20 @@ void TD_Custom::updateGrid() {
   if(use_fes_) {
     plumed_massert(getFesGridPntr()!=NULL,"the FES grid has to be linked to the free energy in the target distribution");
   }
-  if(use_kbt_) {
-    try {
-      expression.getVariableReference(kbt_var_str_) = 1.0/getBeta();
-    } catch(PLMD::lepton::Exception& exc) {}
-  }
-  if(use_beta_) {
-    try {
-      expression.getVariableReference(beta_var_str_) = getBeta();
-    } catch(PLMD::lepton::Exception& exc) {}
-  }
+  const unsigned int ncvs = cv_var_str_.size();
+  if(use_kbt_) {var_values_[ncvs+1] = 1.0/getBeta();}
+  if(use_beta_) {var_values_[ncvs+2] = getBeta();}
   //
   std::vector<double> integration_weights = GridIntegrationWeights::getIntegrationWeights(getTargetDistGridPntr());
   double norm = 0.0;
   //
+  std::vector<double> point(getDimension());
   for(Grid::index_t l=0; l<targetDistGrid().getSize(); l++) {
-    std::vector<double> point = targetDistGrid().getPoint(l);
-    for(unsigned int k=0; k<cv_var_str_.size() ; k++) {
-      try {
-        expression.getVariableReference(cv_var_str_[k]) = point[cv_var_idx_[k]];
-      } catch(PLMD::lepton::Exception& exc) {}
-    }
-    if(use_fes_) {
-      try {
-        expression.getVariableReference(fes_var_str_) = getFesGridPntr()->getValue(l);
-      } catch(PLMD::lepton::Exception& exc) {}
+    targetDistGrid().getPoint(l,point);
+    for(unsigned int k=0; k<ncvs; k++) {
+      var_values_[k] = point[cv_var_idx_[k]];
     }
+    if(use_fes_) {var_values_[ncvs] = getFesGridPntr()->getValue(l);}
     double value = expression.evaluate();
 
     if(value<0.0 && !isTargetDistGridShiftedToZero()) {plumed_merror(getName()+": The target distribution function gives negative values. You should change the definition of the function used for the target distribution to avoid this. You can also use the SHIFT_TO_ZERO keyword to avoid this problem.");}
@@ -48,7 +48,7 @@ VesBias::VesBias(const ActionOptions&ao):
   gradient_pntrs_(0),
   hessian_pntrs_(0),
   sampled_averages(0),
-  sampled_cross_averages(0),
+  sampled_comoments(0),
   use_multiple_coeffssets_(false),
   coeffs_fnames(0),
   ncoeffs_total_(0),
@@ -374,9 +374,9 @@ void VesBias::initializeCoeffs(CoeffsVector* coeffs_pntr_in) {
   aver_sampled_tmp.assign(coeffs_pntr_in->numberOfCoeffs(),0.0);
   sampled_averages.push_back(aver_sampled_tmp);
   //
-  std::vector<double> cross_aver_sampled_tmp;
-  cross_aver_sampled_tmp.assign(hessian_tmp->getSize(),0.0);
-  sampled_cross_averages.push_back(cross_aver_sampled_tmp);
+  std::vector<double> comoments_sampled_tmp;
+  comoments_sampled_tmp.assign(hessian_tmp->getSize(),0.0);
+  sampled_comoments.push_back(comoments_sampled_tmp);
   //
   aver_counters.push_back(0);
   //
@@ -423,16 +423,17 @@ bool VesBias::readCoeffsFromFiles() {
 void VesBias::updateGradientAndHessian(const bool use_mwalkers_mpi) {
   for(unsigned int k=0; k<ncoeffssets_; k++) {
     //
-    comm.Sum(sampled_averages[k]);
-    comm.Sum(sampled_cross_averages[k]);
+    // the averages are the same on all the processes, while the comoments are split among them
+    comm.Sum(sampled_comoments[k]);
+    std::vector<double> covariance = computeCovarianceFromComoments(k);
     if(use_mwalkers_mpi) {
       double walker_weight=1.0;
       if(aver_counters[k]==0) {walker_weight=0.0;}
-      multiSimSumAverages(k,walker_weight);
+      multiSimSumAverages(k,covariance,walker_weight);
     }
     // NOTE: this assumes that all walkers have the same TargetDist, might change later on!!
     Gradient(k).setValues( TargetDistAverages(k) - sampled_averages[k] );
-    Hessian(k) = computeCovarianceFromAverages(k);
+    Hessian(k) = covariance;
     Hessian(k) *= getBeta();
     //
     Gradient(k).activate();
@@ -453,70 +454,84 @@ void VesBias::updateGradientAndHessian(const bool use_mwalkers_mpi) {
     }
     //
     std::fill(sampled_averages[k].begin(), sampled_averages[k].end(), 0.0);
-    std::fill(sampled_cross_averages[k].begin(), sampled_cross_averages[k].end(), 0.0);
+    std::fill(sampled_comoments[k].begin(), sampled_comoments[k].end(), 0.0);
     aver_counters[k]=0;
   }
 }
 
 
-void VesBias::multiSimSumAverages(const unsigned int c_id, const double walker_weight) {
+void VesBias::multiSimSumAverages(const unsigned int c_id, std::vector<double>& covariance, const double walker_weight) {
   plumed_massert(walker_weight>=0.0,"the weight of the walker cannot be negative!");
-  if(walker_weight!=1.0) {
-    for(size_t i=0; i<sampled_averages[c_id].size(); i++) {
-      sampled_averages[c_id][i] *= walker_weight;
-    }
-    for(size_t i=0; i<sampled_cross_averages[c_id].size(); i++) {
-      sampled_cross_averages[c_id][i] *= walker_weight;
-    }
-  }
   //
+  /*
+  the covariance of all the walkers is the average of the covariances of the walkers
+  plus the covariance of the averages of the walkers:
+      C = sum_w w*(C[w] + (xm[w]-xm)*(xm[w]-xm)^T) / sum_w w
+  */
   if(comm.Get_rank()==0) {
-    multi_sim_comm.Sum(sampled_averages[c_id]);
-    multi_sim_comm.Sum(sampled_cross_averages[c_id]);
+    size_t ncoeffs = numberOfCoeffs(c_id);
     double norm_weights = walker_weight;
     multi_sim_comm.Sum(norm_weights);
     if(norm_weights>0.0) {norm_weights=1.0/norm_weights;}
-    for(size_t i=0; i<sampled_averages[c_id].size(); i++) {
-      sampled_averages[c_id][i] *= norm_weights;
+    std::vector<double> averages(sampled_averages[c_id]);
+    for(size_t i=0; i<ncoeffs; i++) {
+      averages[i] *= walker_weight*norm_weights;
+    }
+    multi_sim_comm.Sum(averages);
+    std::vector<double> deltas(ncoeffs);
+    for(size_t i=0; i<ncoeffs; i++) {
+      deltas[i] = sampled_averages[c_id][i]-averages[i];
     }
-    for(size_t i=0; i<sampled_cross_averages[c_id].size(); i++) {
-      sampled_cross_averages[c_id][i] *= norm_weights;
+    for(size_t i=0; i<ncoeffs; i++) {
+      size_t jmax = diagonal_hessian_ ? i+1 : ncoeffs;
+      double* cov_row = &covariance[getHessianIndex(i,i,c_id)];
+      for(size_t j=i; j<jmax; j++) {
+        cov_row[j-i] = walker_weight*norm_weights*(cov_row[j-i] + deltas[i]*deltas[j]);
+      }
     }
+    multi_sim_comm.Sum(covariance);
+    sampled_averages[c_id] = averages;
   }
   comm.Bcast(sampled_averages[c_id],0);
-  comm.Bcast(sampled_cross_averages[c_id],0);
+  comm.Bcast(covariance,0);
 }
 
 
 void VesBias::addToSampledAverages(const std::vector<double>& values, const unsigned int c_id) {
   /*
-  use the following online equation to calculate the average and covariance
+  use the following online equations to calculate the average and the covariance
   (see https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Covariance)
       xm[n+1] = xm[n] + (x[n+1]-xm[n])/(n+1)
+      M[n+1] = M[n] + n/(n+1) * (x[n+1]-xm[n])*(x[n+1]-xm[n])^T
+  where the covariance is M[n]/n. Compared to averaging the products of the values
+  this does not suffer from cancellation errors.
+  The values should be the same on all the processes, so that each of them
+  can update all the averages, while the rows of the comoments are split among them
+  and summed only when the gradient and the Hessian are updated.
   */
   double counter_dbl = static_cast<double>(aver_counters[c_id]);
   size_t ncoeffs = numberOfCoeffs(c_id);
-  std::vector<double> deltas(ncoeffs,0.0);
+  std::vector<double>& averages = sampled_averages[c_id];
+  std::vector<double>& comoments = sampled_comoments[c_id];
+  if(sampled_deltas_.size()!=ncoeffs) {sampled_deltas_.resize(ncoeffs);}
+  for(size_t i=0; i<ncoeffs; i++) {
+    sampled_deltas_[i] = values[i]-averages[i]; // x[n+1]-xm[n]
+    averages[i] += sampled_deltas_[i]/(counter_dbl+1);
+  }
+  const double factor = counter_dbl/(counter_dbl+1);
+  const double* deltas = sampled_deltas_.data();
   size_t stride = comm.Get_size();
   size_t rank = comm.Get_rank();
-  // update average and diagonal part of Hessian
   for(size_t i=rank; i<ncoeffs; i+=stride) {
-    size_t midx = getHessianIndex(i,i,c_id);
-    deltas[i] = (values[i]-sampled_averages[c_id][i])/(counter_dbl+1); // (x[n+1]-xm[n])/(n+1)
-    sampled_averages[c_id][i] += deltas[i];
-    sampled_cross_averages[c_id][midx] += (values[i]*values[i]-sampled_cross_averages[c_id][midx])/(counter_dbl+1);
-  }
-  comm.Sum(deltas);
-  // update off-diagonal part of the Hessian
-  if(!diagonal_hessian_) {
-    for(size_t i=rank; i<ncoeffs; i+=stride) {
-      for(size_t j=(i+1); j<ncoeffs; j++) {
-        size_t midx = getHessianIndex(i,j,c_id);
-        sampled_cross_averages[c_id][midx] += (values[i]*values[j]-sampled_cross_averages[c_id][midx])/(counter_dbl+1);
-      }
+    // the upper triangular part of row i is contiguous
+    size_t jmax = diagonal_hessian_ ? i+1 : ncoeffs;
+    double* comoments_row = &comoments[getHessianIndex(i,i,c_id)];
+    const double factor_i = factor*deltas[i];
+    for(size_t j=i; j<jmax; j++) {
+      comoments_row[j-i] += factor_i*deltas[j];
     }
   }
-  // NOTE: the MPI sum for sampled_averages and sampled_cross_averages is done later
+  // NOTE: the MPI sum for sampled_comoments is done later
   aver_counters[c_id] += 1;
 }
 
@@ -577,15 +592,15 @@ void VesBias::linkOptimizer(Optimizer* optimizer_pntr_in) {
 void VesBias::enableHessian(const bool diagonal_hessian) {
   compute_hessian_=true;
   diagonal_hessian_=diagonal_hessian;
-  sampled_cross_averages.clear();
+  sampled_comoments.clear();
   for (unsigned int i=0; i<ncoeffssets_; i++) {
     delete hessian_pntrs_[i];
     std::string label = getCoeffsSetLabelString("hessian",i);
     hessian_pntrs_[i] = new CoeffsMatrix(label,coeffs_pntrs_[i],comm,diagonal_hessian_);
     //
-    std::vector<double> cross_aver_sampled_tmp;
-    cross_aver_sampled_tmp.assign(hessian_pntrs_[i]->getSize(),0.0);
-    sampled_cross_averages.push_back(cross_aver_sampled_tmp);
+    std::vector<double> comoments_sampled_tmp;
+    comoments_sampled_tmp.assign(hessian_pntrs_[i]->getSize(),0.0);
+    sampled_comoments.push_back(comoments_sampled_tmp);
   }
 }
 
@@ -593,15 +608,15 @@ void VesBias::enableHessian(const bool diagonal_hessian) {
 void VesBias::disableHessian() {
   compute_hessian_=false;
   diagonal_hessian_=true;
-  sampled_cross_averages.clear();
+  sampled_comoments.clear();
   for (unsigned int i=0; i<ncoeffssets_; i++) {
     delete hessian_pntrs_[i];
     std::string label = getCoeffsSetLabelString("hessian",i);
     hessian_pntrs_[i] = new CoeffsMatrix(label,coeffs_pntrs_[i],comm,diagonal_hessian_);
     //
-    std::vector<double> cross_aver_sampled_tmp;
-    cross_aver_sampled_tmp.assign(hessian_pntrs_[i]->getSize(),0.0);
-    sampled_cross_averages.push_back(cross_aver_sampled_tmp);
+    std::vector<double> comoments_sampled_tmp;
+    comoments_sampled_tmp.assign(hessian_pntrs_[i]->getSize(),0.0);
+    sampled_comoments.push_back(comoments_sampled_tmp);
   }
 }
 
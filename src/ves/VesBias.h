@@ -66,7 +66,9 @@ private:
   std::vector<CoeffsVector*> gradient_pntrs_;
   std::vector<CoeffsMatrix*> hessian_pntrs_;
   std::vector<std::vector<double> > sampled_averages;
-  std::vector<std::vector<double> > sampled_cross_averages;
+  // sums of the products of the deviations from the sampled averages (upper triangular part
+  // or diagonal as for the Hessian), each process only updates the rows i=rank+n*stride
+  std::vector<std::vector<double> > sampled_comoments;
   bool use_multiple_coeffssets_;
   //
   std::vector<std::string> coeffs_fnames;
@@ -80,6 +82,7 @@ private:
   bool diagonal_hessian_;
   //
   std::vector<unsigned int> aver_counters;
+  std::vector<double> sampled_deltas_;
   //
   double kbt_;
   //
@@ -120,8 +123,8 @@ private:
   bool calc_reweightfactor_;
 private:
   void initializeCoeffs(CoeffsVector*);
-  std::vector<double> computeCovarianceFromAverages(const unsigned int) const;
-  void multiSimSumAverages(const unsigned int, const double walker_weight=1.0);
+  std::vector<double> computeCovarianceFromComoments(const unsigned int) const;
+  void multiSimSumAverages(const unsigned int, std::vector<double>&, const double walker_weight=1.0);
 protected:
   //
   void checkThatTemperatureIsGiven();
@@ -359,20 +362,12 @@ void VesBias::applyBiasCutoff(double& bias, std::vector<double>& forces, std::ve
 
 
 inline
-std::vector<double> VesBias::computeCovarianceFromAverages(const unsigned int c_id) const {
-  size_t ncoeffs = numberOfCoeffs(c_id);
-  std::vector<double> covariance(sampled_cross_averages[c_id].size(),0.0);
-  // diagonal part
-  for(size_t i=0; i<ncoeffs; i++) {
-    size_t midx = getHessianIndex(i,i,c_id);
-    covariance[midx] = sampled_cross_averages[c_id][midx] - sampled_averages[c_id][i]*sampled_averages[c_id][i];
-  }
-  if(!diagonal_hessian_) {
-    for(size_t i=0; i<ncoeffs; i++) {
-      for(size_t j=(i+1); j<ncoeffs; j++) {
-        size_t midx = getHessianIndex(i,j,c_id);
-        covariance[midx] = sampled_cross_averages[c_id][midx] - sampled_averages[c_id][i]*sampled_averages[c_id][j];
-      }
+std::vector<double> VesBias::computeCovarianceFromComoments(const unsigned int c_id) const {
+  std::vector<double> covariance(sampled_comoments[c_id].size(),0.0);
+  if(aver_counters[c_id]>0) {
+    double norm = 1.0/static_cast<double>(aver_counters[c_id]);
+    for(size_t i=0; i<covariance.size(); i++) {
+      covariance[i] = norm*sampled_comoments[c_id][i];
     }
   }
   return covariance;
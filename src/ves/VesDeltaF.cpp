@@ -152,6 +152,7 @@ public:
   VesDeltaF(const ActionOptions&);
   void calculate();
   void update();
+  bool isHistoryDependent()const override {return true;}
   static void registerKeywords(Keywords& keys);
 };
 
@@ -87,6 +87,8 @@ public:
 /// Overwrite ActionWithArguments getArguments() so that we don't return the bias
   std::vector<Value*> getArguments();
   void update();
+/// Averages are history dependent unless they are cleared at every step
+  bool isHistoryDependent()const override {return clearstride==0 || clearstride>unsigned(getStride());}
 /// This does the clearing of the action
   virtual void clearAverage();
 /// This is done before the averaging comences
@@ -260,6 +260,63 @@ unsigned ActionWithVessel::getSizeOfBuffer( unsigned& bufsize ) {
   return bufsize;
 }
 
+template <class T>
+void ActionWithVessel::sparseSum( Communicator& comm, SparsePattern& pattern, std::vector<T>& buf ) {
+  const int size=comm.Get_size();
+  if( size==1 ) return;
+  if( pattern.valid && pattern.all.size()>0 && pattern.all.back()==buf.size() ) {
+    // Only the values of the elements in the pattern are sent, followed by a flag that is set
+    // when this process has non-zero elements outside of the pattern, or far less non-zero elements
+    std::vector<T> values( pattern.local.size()+1 );
+    unsigned nnz=0, k=0;
+    bool fits=true;
+    for(unsigned i=0; i<buf.size(); ++i) {
+      if( k<pattern.local.size() && pattern.local[k]==i ) { values[k++]=buf[i]; if( buf[i]!=T(0) ) nnz++; }
+      else if( buf[i]!=T(0) ) { fits=false; break; }
+    }
+    values.back()=( fits && 4*nnz>=pattern.local.size() ) ? T(0) : T(1);
+    std::vector<T> all_value( pattern.displ[size-1]+pattern.counts[size-1] );
+    comm.Allgatherv( &values[0], pattern.counts[comm.Get_rank()], &all_value[0], &pattern.counts[0], &pattern.displ[0] );
+    bool update=false;
+    for(int r=0; r<size; ++r) if( all_value[pattern.displ[r]+pattern.counts[r]-1]!=T(0) ) update=true;
+    if( !update ) {
+      buf.assign( buf.size(), T(0) );
+      for(int r=0; r<size; ++r) {
+        for(int j=0; j<pattern.counts[r]-1; ++j) buf[pattern.all[pattern.displ[r]-r+j]]+=all_value[pattern.displ[r]+j];
+      }
+      return;
+    }
+  }
+  pattern.valid=false;
+  std::vector<unsigned> nz_index;
+  std::vector<T> nz_value;
+  for(unsigned i=0; i<buf.size(); ++i) {
+    if( buf[i]!=T(0) ) { nz_index.push_back(i); nz_value.push_back(buf[i]); }
+  }
+  std::vector<int> counts(size), displ(size);
+  comm.Allgather( int(nz_index.size()), counts );
+  displ[0]=0; for(int i=1; i<size; ++i) displ[i]=displ[i-1]+counts[i-1];
+  const unsigned tot=displ[size-1]+counts[size-1];
+  // An index and a value are sent per element, use a dense reduction if it is cheaper
+  if( 2*tot>buf.size() ) { comm.Sum( buf ); return; }
+  std::vector<unsigned> all_index( tot+1 );
+  std::vector<T> all_value( tot+1 );
+  nz_index.push_back(0); nz_value.push_back(T(0));
+  comm.Allgatherv( &nz_index[0], counts[comm.Get_rank()], &all_index[0], &counts[0], &displ[0] );
+  comm.Allgatherv( &nz_value[0], counts[comm.Get_rank()], &all_value[0], &counts[0], &displ[0] );
+  buf.assign( buf.size(), T(0) );
+  for(unsigned i=0; i<tot; ++i) buf[all_index[i]]+=all_value[i];
+  // Store the pattern, the size of the buffer is stored at the end of the indices
+  // and each process sends an additional element with the flag
+  nz_index.pop_back();
+  pattern.local.swap( nz_index );
+  all_index.back()=buf.size();
+  pattern.all.swap( all_index );
+  pattern.counts.resize( size ); pattern.displ.resize( size );
+  for(int r=0; r<size; ++r) { pattern.counts[r]=counts[r]+1; pattern.displ[r]=displ[r]+r; }
+  pattern.valid=true;
+}
+
 void ActionWithVessel::runAllTasks() {
   plumed_massert( !contributorsAreUnlocked && functions.size()>0, "you must have a call to readVesselKeywords somewhere" );
   unsigned stride=comm.Get_size();
@@ -283,10 +340,13 @@ void ActionWithVessel::runAllTasks() {
   if( dertime_can_be_off ) dertime=false;
 
   if(timers) stopwatch.start("2 Loop over tasks");
+  // Buffers of the single threads, kept together so that they can be merged in parallel.
+  // They store (index,value) pairs, as each task only contributes to its active derivatives
+  std::vector<AccumulationBuffer> omp_buffers( nt>1 ? nt : 0, AccumulationBuffer( bufsize ) );
   #pragma omp parallel num_threads(nt)
   {
-    std::vector<double> omp_buffer;
-    if( nt>1 ) omp_buffer.resize( bufsize, 0.0 );
+    AccumulationBuffer dense_buffer( buffer );
+    AccumulationBuffer & omp_buffer( nt>1 ? omp_buffers[OpenMP::getThreadNum()] : dense_buffer );
     MultiValue myvals( getNumberOfQuantities(), getNumberOfDerivatives() );
     MultiValue bvals( getNumberOfQuantities(), getNumberOfDerivatives() );
     myvals.clearAll(); bvals.clearAll();
@@ -308,17 +368,24 @@ void ActionWithVessel::runAllTasks() {
       // Now calculate all the functions
       // If the contribution of this quantity is very small at neighbour list time ignore it
       // untill next neighbour list time
-      if( nt>1 ) {
-        calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, omp_buffer, der_list );
-      } else {
-        calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, buffer, der_list );
-      }
+      calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, omp_buffer, der_list );
 
       // Clear the value
       myvals.clearAll();
     }
-    #pragma omp critical
-    if(nt>1) for(unsigned i=0; i<bufsize; ++i) buffer[i]+=omp_buffer[i];
+    // Merge the buffers of the threads, each thread takes care of some slices of the buffer.
+    // Notice that the team could be smaller than nt if we are in a nested region,
+    // the buffers of the missing threads are then empty
+    if( nt>1 ) {
+      omp_buffer.compact();
+      #pragma omp barrier
+      const unsigned nslices=4*nt, slice=(bufsize+nslices-1)/nslices;
+      #pragma omp for
+      for(unsigned k=0; k<nslices; ++k) {
+        unsigned begin=std::min( k*slice, bufsize ), end=std::min( begin+slice, bufsize );
+        for(unsigned j=0; j<omp_buffers.size(); ++j) omp_buffers[j].addTo( begin, end, buffer );
+      }
+    }
   }
   if(timers) stopwatch.stop("2 Loop over tasks");
   // Turn back on derivative calculation
@@ -326,10 +393,10 @@ void ActionWithVessel::runAllTasks() {
 
   if(timers) stopwatch.start("3 MPI gather");
   // MPI Gather everything
-  if( !serial && buffer.size()>0 ) comm.Sum( buffer );
+  if( !serial && buffer.size()>0 ) sparseSum( comm, buffer_pattern, buffer );
   // MPI Gather index stores
   if( mydata && !lowmem && !noderiv ) {
-    comm.Sum( der_list ); mydata->setActiveValsAndDerivatives( der_list );
+    sparseSum( comm, der_list_pattern, der_list ); mydata->setActiveValsAndDerivatives( der_list );
   }
   // Update the elements that are makign contributions to the sum here
   // this causes problems if we do it in prepare
@@ -344,7 +411,7 @@ void ActionWithVessel::transformBridgedDerivatives( const unsigned& current, Mul
   plumed_error();
 }
 
-void ActionWithVessel::calculateAllVessels( const unsigned& taskCode, MultiValue& myvals, MultiValue& bvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) {
+void ActionWithVessel::calculateAllVessels( const unsigned& taskCode, MultiValue& myvals, MultiValue& bvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) {
   for(unsigned j=0; j<functions.size(); ++j) {
     // Calculate returns a bool that tells us if this particular
     // quantity is contributing more than the tolerance
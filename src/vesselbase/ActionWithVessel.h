@@ -27,6 +27,7 @@
 #include "tools/Exception.h"
 #include "tools/DynamicList.h"
 #include "tools/MultiValue.h"
+#include "tools/AccumulationBuffer.h"
 #include <vector>
 #include "tools/ForwardDecl.h"
 
@@ -85,6 +86,18 @@ private:
   std::vector<unsigned> der_list;
 /// The buffer that we use (we keep a copy here to avoid resizing)
   std::vector<double> buffer;
+/// The elements of a buffer exchanged in the last sparse MPI reduction. They are
+/// reused, without exchanging indices again, while they include all the non-zero elements
+  struct SparsePattern {
+    bool valid;
+    std::vector<unsigned> local, all;
+    std::vector<int> counts, displ;
+    SparsePattern(): valid(false) {}
+  };
+  SparsePattern buffer_pattern, der_list_pattern;
+/// Sum a buffer over all the processes, exchanging only its non-zero elements when it is mostly made of zeros
+  template <class T>
+  static void sparseSum( Communicator& comm, SparsePattern& pattern, std::vector<T>& buf );
 /// Do we want to output information on the timings of different parts of the calculation
   bool timers;
   ForwardDecl<Stopwatch> stopwatch_fwd;
@@ -124,7 +137,7 @@ protected:
   void resizeFunctions();
 /// This loops over all the vessels calculating them and also
 /// sets all the element derivatives equal to zero
-  void calculateAllVessels( const unsigned& taskCode, MultiValue& myvals, MultiValue& bvals, std::vector<double>& buffer, std::vector<unsigned>& der_list );
+  void calculateAllVessels( const unsigned& taskCode, MultiValue& myvals, MultiValue& bvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list );
 /// Retrieve the forces from all the vessels (used in apply)
   bool getForcesFromVessels( std::vector<double>& forcesToApply );
 /// Is the calculation being done in serial
@@ -82,7 +82,7 @@ MultiValue& BridgeVessel::transformDerivatives( const unsigned& current, MultiVa
   return outvals;
 }
 
-void BridgeVessel::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
+void BridgeVessel::calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {
   // in_normal_calculate=true;
   if( myvals.get(0)<myOutputAction->getTolerance() ) return;
   myOutputAction->calculateAllVessels( current, myvals, myvals, buffer, der_list );
@@ -49,7 +49,7 @@ void FunctionVessel::resize() {
   }
 }
 
-void FunctionVessel::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
+void FunctionVessel::calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {
   unsigned nderivatives=getFinalValue()->getNumberOfDerivatives();
   double weight=myvals.get(0);
   plumed_dbg_assert( weight>=getTolerance() );
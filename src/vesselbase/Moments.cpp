@@ -43,7 +43,7 @@ public:
   explicit Moments( const vesselbase::VesselOptions& da );
   std::string description();
   void resize();
-  void calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {}
+  void calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {}
   void finish( const std::vector<double>& buffer );
   bool applyForce( std::vector<double>& forces );
 };
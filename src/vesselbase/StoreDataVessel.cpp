@@ -60,7 +60,7 @@ void StoreDataVessel::resize() {
   local_buffer.resize( getNumberOfStoredValues()*vecsize*nspace );
 }
 
-void StoreDataVessel::storeValues( const unsigned& myelem, MultiValue& myvals, std::vector<double>& buffer ) const {
+void StoreDataVessel::storeValues( const unsigned& myelem, MultiValue& myvals, AccumulationBuffer& buffer ) const {
   plumed_dbg_assert( vecsize>0 );
   unsigned jelem = getAction()->getPositionInCurrentTaskList( myelem ); plumed_dbg_assert( jelem<getNumberOfStoredValues() );
   unsigned ibuf = bufstart + jelem * vecsize * nspace;
@@ -69,7 +69,7 @@ void StoreDataVessel::storeValues( const unsigned& myelem, MultiValue& myvals, s
   }
 }
 
-void StoreDataVessel::storeDerivatives( const unsigned& myelem, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
+void StoreDataVessel::storeDerivatives( const unsigned& myelem, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {
   plumed_dbg_assert( vecsize>0 && getAction()->derivativesAreRequired() && myelem<getAction()->getFullNumberOfTasks() );
   unsigned jelem = getAction()->getPositionInCurrentTaskList( myelem );
 
@@ -145,7 +145,7 @@ void StoreDataVessel::retrieveDerivatives( const unsigned& myelem, const bool& n
   }
 }
 
-void StoreDataVessel::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
+void StoreDataVessel::calculate( const unsigned& current, MultiValue& myvals, AccumulationBuffer& buffer, std::vector<unsigned>& der_list ) const {
 
   if( myvals.get(0)>epsilon ) {
     storeValues( current, myvals, buffer );